@@ -0,0 +1,41 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "../util/c99defs.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+// A handful of named values; strings are borrowed, not copied
+#define CALLDATA_STUB_ENTRIES 8
+
+struct calldata_entry {
+    const char *name;
+    const char *string;
+    void *ptr;
+    long long integer;
+    bool boolean;
+};
+
+// Like libobs, calldata_free leaves the data unusable until calldata_init;
+// here any use of it in between aborts instead of touching freed memory
+struct calldata {
+    struct calldata_entry entries[CALLDATA_STUB_ENTRIES];
+    size_t count;
+    bool freed;
+};
+typedef struct calldata calldata_t;
+void calldata_init(calldata_t *data);
+void calldata_free(calldata_t *data);
+void calldata_set_string(calldata_t *data, const char *name, const char *str);
+void calldata_set_ptr(calldata_t *data, const char *name, void *ptr);
+void calldata_set_int(calldata_t *data, const char *name, long long val);
+void calldata_set_bool(calldata_t *data, const char *name, bool val);
+const char *calldata_string(const calldata_t *data, const char *name);
+void *calldata_ptr(const calldata_t *data, const char *name);
+long long calldata_int(const calldata_t *data, const char *name);
+bool calldata_bool(const calldata_t *data, const char *name);
+#ifdef __cplusplus
+}
+#endif
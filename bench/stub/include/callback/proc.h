@@ -0,0 +1,17 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "calldata.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+struct proc_handler;
+typedef struct proc_handler proc_handler_t;
+typedef void (*proc_handler_proc_t)(void *data, calldata_t *cd);
+void proc_handler_add(proc_handler_t *handler, const char *decl_string, proc_handler_proc_t proc, void *data);
+bool proc_handler_call(proc_handler_t *handler, const char *name, calldata_t *params);
+#ifdef __cplusplus
+}
+#endif
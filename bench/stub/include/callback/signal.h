@@ -0,0 +1,18 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "calldata.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+struct signal_handler;
+typedef struct signal_handler signal_handler_t;
+typedef void (*signal_callback_t)(void *data, calldata_t *cd);
+void signal_handler_connect(signal_handler_t *handler, const char *signal, signal_callback_t callback, void *data);
+void signal_handler_disconnect(signal_handler_t *handler, const char *signal, signal_callback_t callback,
+                               void *data);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "../util/c99defs.h"
+#define MAX_AV_PLANES 8
+#define MAX_AUDIO_MIXES 6
+#define AUDIO_OUTPUT_FRAMES 1024
+struct audio_output;
+typedef struct audio_output audio_t;
+struct audio_data {
+    uint8_t *data[MAX_AV_PLANES];
+    uint32_t frames;
+    uint64_t timestamp;
+};
+struct audio_convert_info;
+typedef void (*audio_output_callback_t)(void *param, size_t mix_idx, struct audio_data *data);
+#ifdef __cplusplus
+extern "C" {
+#endif
+bool audio_output_connect(audio_t *audio, size_t mix_idx, const struct audio_convert_info *conversion,
+                          audio_output_callback_t callback, void *param);
+void audio_output_disconnect(audio_t *audio, size_t mix_idx, audio_output_callback_t callback, void *param);
+size_t audio_output_get_channels(const audio_t *audio);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "../util/c99defs.h"
+struct video_output;
+typedef struct video_output video_t;
+enum video_format { VIDEO_FORMAT_NONE, VIDEO_FORMAT_I420, VIDEO_FORMAT_NV12, VIDEO_FORMAT_Y800 };
+enum video_range_type { VIDEO_RANGE_DEFAULT, VIDEO_RANGE_PARTIAL, VIDEO_RANGE_FULL };
+enum video_colorspace { VIDEO_CS_DEFAULT, VIDEO_CS_601, VIDEO_CS_709 };
+struct video_scale_info {
+    enum video_format format;
+    uint32_t width;
+    uint32_t height;
+    enum video_range_type range;
+    enum video_colorspace colorspace;
+};
+struct video_data {
+    uint8_t *data[8];
+    uint32_t linesize[8];
+    uint64_t timestamp;
+};
+struct video_output_info {
+    const char *name;
+    enum video_format format;
+    uint32_t fps_num;
+    uint32_t fps_den;
+    uint32_t width;
+    uint32_t height;
+    size_t cache_size;
+};
+#ifdef __cplusplus
+extern "C" {
+#endif
+const struct video_output_info *video_output_get_info(const video_t *video);
+uint64_t video_output_get_frame_time(const video_t *video);
+#ifdef __cplusplus
+}
+#endif
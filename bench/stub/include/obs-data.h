@@ -0,0 +1,33 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "util/c99defs.h"
+struct obs_data;
+typedef struct obs_data obs_data_t;
+struct obs_data_array;
+typedef struct obs_data_array obs_data_array_t;
+#ifdef __cplusplus
+extern "C" {
+#endif
+obs_data_t *obs_data_create(void);
+obs_data_t *obs_data_create_from_json(const char *json_string);
+void obs_data_release(obs_data_t *data);
+const char *obs_data_get_json(obs_data_t *data);
+const char *obs_data_get_string(obs_data_t *data, const char *name);
+long long obs_data_get_int(obs_data_t *data, const char *name);
+bool obs_data_has_user_value(obs_data_t *data, const char *name);
+void obs_data_set_string(obs_data_t *data, const char *name, const char *val);
+void obs_data_set_int(obs_data_t *data, const char *name, long long val);
+void obs_data_set_bool(obs_data_t *data, const char *name, bool val);
+void obs_data_set_array(obs_data_t *data, const char *name, obs_data_array_t *array);
+obs_data_array_t *obs_data_get_array(obs_data_t *data, const char *name);
+obs_data_array_t *obs_data_array_create(void);
+void obs_data_array_release(obs_data_array_t *array);
+size_t obs_data_array_count(obs_data_array_t *array);
+obs_data_t *obs_data_array_item(obs_data_array_t *array, size_t idx);
+size_t obs_data_array_push_back(obs_data_array_t *array, obs_data_t *obj);
+#ifdef __cplusplus
+}
+#endif
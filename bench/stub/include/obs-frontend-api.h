@@ -0,0 +1,63 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include <obs.h>
+#include <util/config-file.h>
+enum obs_frontend_event {
+    OBS_FRONTEND_EVENT_STREAMING_STARTING,
+    OBS_FRONTEND_EVENT_STREAMING_STARTED,
+    OBS_FRONTEND_EVENT_STREAMING_STOPPING,
+    OBS_FRONTEND_EVENT_STREAMING_STOPPED,
+    OBS_FRONTEND_EVENT_RECORDING_STARTING,
+    OBS_FRONTEND_EVENT_RECORDING_STARTED,
+    OBS_FRONTEND_EVENT_RECORDING_STOPPING,
+    OBS_FRONTEND_EVENT_RECORDING_STOPPED,
+    OBS_FRONTEND_EVENT_SCENE_CHANGED,
+    OBS_FRONTEND_EVENT_SCENE_LIST_CHANGED,
+    OBS_FRONTEND_EVENT_TRANSITION_CHANGED,
+    OBS_FRONTEND_EVENT_TRANSITION_STOPPED,
+    OBS_FRONTEND_EVENT_TRANSITION_LIST_CHANGED,
+    OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED,
+    OBS_FRONTEND_EVENT_SCENE_COLLECTION_LIST_CHANGED,
+    OBS_FRONTEND_EVENT_PROFILE_CHANGED,
+    OBS_FRONTEND_EVENT_PROFILE_LIST_CHANGED,
+    OBS_FRONTEND_EVENT_EXIT,
+    OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTING,
+    OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTED,
+    OBS_FRONTEND_EVENT_REPLAY_BUFFER_STOPPING,
+    OBS_FRONTEND_EVENT_REPLAY_BUFFER_STOPPED,
+    OBS_FRONTEND_EVENT_STUDIO_MODE_ENABLED,
+    OBS_FRONTEND_EVENT_STUDIO_MODE_DISABLED,
+    OBS_FRONTEND_EVENT_PREVIEW_SCENE_CHANGED,
+    OBS_FRONTEND_EVENT_SCENE_COLLECTION_CLEANUP,
+    OBS_FRONTEND_EVENT_FINISHED_LOADING,
+    OBS_FRONTEND_EVENT_RECORDING_PAUSED,
+    OBS_FRONTEND_EVENT_RECORDING_UNPAUSED,
+    OBS_FRONTEND_EVENT_TRANSITION_DURATION_CHANGED,
+    OBS_FRONTEND_EVENT_REPLAY_BUFFER_SAVED,
+    OBS_FRONTEND_EVENT_VIRTUALCAM_STARTED,
+    OBS_FRONTEND_EVENT_VIRTUALCAM_STOPPED,
+    OBS_FRONTEND_EVENT_TBAR_VALUE_CHANGED,
+    OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGING,
+    OBS_FRONTEND_EVENT_PROFILE_CHANGING,
+    OBS_FRONTEND_EVENT_SCRIPTING_SHUTDOWN,
+    OBS_FRONTEND_EVENT_PROFILE_RENAMED,
+    OBS_FRONTEND_EVENT_SCENE_COLLECTION_RENAMED,
+    OBS_FRONTEND_EVENT_THEME_CHANGED,
+    OBS_FRONTEND_EVENT_SCREENSHOT_TAKEN,
+};
+typedef void (*obs_frontend_event_cb)(enum obs_frontend_event event, void *private_data);
+#ifdef __cplusplus
+extern "C" {
+#endif
+config_t *obs_frontend_get_profile_config(void);
+obs_output_t *obs_frontend_get_recording_output(void);
+char *obs_frontend_get_last_recording(void);
+obs_source_t *obs_frontend_get_current_scene(void);
+void obs_frontend_add_event_callback(obs_frontend_event_cb callback, void *private_data);
+void obs_frontend_remove_event_callback(obs_frontend_event_cb callback, void *private_data);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "util/c99defs.h"
+typedef size_t obs_hotkey_id;
+#define OBS_INVALID_HOTKEY_ID (~(obs_hotkey_id)0)
+struct obs_hotkey;
+typedef struct obs_hotkey obs_hotkey_t;
+struct obs_data_array;
+typedef struct obs_data_array obs_data_array_t;
+typedef void (*obs_hotkey_func)(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed);
+#ifdef __cplusplus
+extern "C" {
+#endif
+obs_hotkey_id obs_hotkey_register_frontend(const char *name, const char *description, obs_hotkey_func func, void *data);
+void obs_hotkey_unregister(obs_hotkey_id id);
+void obs_hotkey_load(obs_hotkey_id id, obs_data_array_t *data);
+obs_data_array_t *obs_hotkey_save(obs_hotkey_id id);
+#ifdef __cplusplus
+}
+#endif
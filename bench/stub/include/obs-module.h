@@ -0,0 +1,25 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "obs.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+#define OBS_DECLARE_MODULE()                                   \
+    static obs_module_t *obs_module_pointer;                   \
+    MODULE_EXPORT void obs_module_set_pointer(obs_module_t *module); \
+    void obs_module_set_pointer(obs_module_t *module) { obs_module_pointer = module; } \
+    obs_module_t *obs_current_module(void) { return obs_module_pointer; }
+#define OBS_MODULE_USE_DEFAULT_LOCALE(module_name, default_locale)
+MODULE_EXPORT bool obs_module_load(void);
+MODULE_EXPORT void obs_module_unload(void);
+MODULE_EXPORT void obs_module_post_load(void);
+MODULE_EXPORT const char *obs_module_name(void);
+MODULE_EXPORT const char *obs_module_description(void);
+obs_module_t *obs_current_module(void);
+#define obs_module_config_path(file) obs_module_get_config_path(obs_current_module(), file)
+#ifdef __cplusplus
+}
+#endif
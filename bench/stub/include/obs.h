@@ -0,0 +1,83 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "obs-config.h"
+#include "util/c99defs.h"
+#include "util/bmem.h"
+#include "util/base.h"
+#include "obs-hotkey.h"
+#include "obs-data.h"
+#include "callback/signal.h"
+#include "callback/proc.h"
+#include "media-io/video-io.h"
+#include "media-io/audio-io.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+struct obs_module;
+typedef struct obs_module obs_module_t;
+char *obs_module_get_config_path(obs_module_t *module, const char *file);
+char *obs_get_module_data_path(obs_module_t *module);
+#ifdef __cplusplus
+}
+#endif
+#ifdef __cplusplus
+extern "C" {
+#endif
+struct obs_video_info {
+    const char *graphics_module;
+    uint32_t fps_num;
+    uint32_t fps_den;
+    uint32_t base_width;
+    uint32_t base_height;
+    uint32_t output_width;
+    uint32_t output_height;
+    int output_format;
+    uint32_t adapter;
+    bool gpu_conversion;
+    int colorspace;
+    int range;
+    int scale_type;
+};
+bool obs_get_video_info(struct obs_video_info *ovi);
+#ifdef __cplusplus
+}
+#endif
+#ifdef __cplusplus
+extern "C" {
+#endif
+struct obs_output;
+typedef struct obs_output obs_output_t;
+struct obs_source;
+typedef struct obs_source obs_source_t;
+const char *obs_source_get_name(const obs_source_t *source);
+void obs_source_release(obs_source_t *source);
+obs_source_t *obs_get_source_by_name(const char *name);
+typedef void (*obs_source_audio_capture_t)(void *param, obs_source_t *source, const struct audio_data *audio_data,
+                                           bool muted);
+void obs_source_add_audio_capture_callback(obs_source_t *source, obs_source_audio_capture_t callback, void *param);
+void obs_source_remove_audio_capture_callback(obs_source_t *source, obs_source_audio_capture_t callback,
+                                              void *param);
+audio_t *obs_get_audio(void);
+void obs_add_raw_video_callback(const struct video_scale_info *conversion,
+                                void (*callback)(void *param, struct video_data *frame), void *param);
+void obs_remove_raw_video_callback(void (*callback)(void *param, struct video_data *frame), void *param);
+void obs_add_raw_video_callback2(const struct video_scale_info *conversion, uint32_t frame_rate_divisor,
+                                 void (*callback)(void *param, struct video_data *frame), void *param);
+void obs_remove_raw_video_callback2(const struct video_scale_info *conversion, uint32_t frame_rate_divisor,
+                                    void (*callback)(void *param, struct video_data *frame), void *param);
+void obs_output_release(obs_output_t *output);
+bool obs_output_active(const obs_output_t *output);
+int obs_output_get_total_frames(const obs_output_t *output);
+uint64_t obs_output_get_pause_offset(obs_output_t *output);
+obs_data_t *obs_output_get_settings(const obs_output_t *output);
+int obs_output_get_frames_dropped(const obs_output_t *output);
+signal_handler_t *obs_output_get_signal_handler(const obs_output_t *output);
+proc_handler_t *obs_get_proc_handler(void);
+video_t *obs_get_video(void);
+uint64_t obs_get_video_frame_time(void);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,14 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "c99defs.h"
+enum { LOG_ERROR = 100, LOG_WARNING = 200, LOG_INFO = 300, LOG_DEBUG = 400 };
+#ifdef __cplusplus
+extern "C" {
+#endif
+void blog(int log_level, const char *format, ...);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "c99defs.h"
+#include <string.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+void *bmalloc(size_t size);
+void *brealloc(void *ptr, size_t size);
+void bfree(void *ptr);
+static inline void *bzalloc(size_t size)
+{
+    void *mem = bmalloc(size);
+    if (mem)
+        memset(mem, 0, size);
+    return mem;
+}
+static inline void *bmemdup(const void *ptr, size_t size)
+{
+    void *out = bmalloc(size);
+    if (size)
+        memcpy(out, ptr, size);
+    return out;
+}
+
+static inline char *bstrdup(const char *str)
+{
+    if (!str)
+        return NULL;
+    size_t len = strlen(str);
+    char *dup = (char *)bmalloc(len + 1);
+    memcpy(dup, str, len + 1);
+    return dup;
+}
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#define UNUSED_PARAMETER(param) (void)param
+#define EXPORT
+#ifdef __cplusplus
+#define MODULE_EXPORT extern "C"
+#else
+#define MODULE_EXPORT
+#endif
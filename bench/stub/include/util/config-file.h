@@ -0,0 +1,28 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "c99defs.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+struct config_data;
+typedef struct config_data config_t;
+const char *config_get_string(config_t *config, const char *section, const char *name);
+int64_t config_get_int(config_t *config, const char *section, const char *name);
+uint64_t config_get_uint(config_t *config, const char *section, const char *name);
+bool config_get_bool(config_t *config, const char *section, const char *name);
+double config_get_double(config_t *config, const char *section, const char *name);
+void config_set_string(config_t *config, const char *section, const char *name, const char *value);
+void config_set_int(config_t *config, const char *section, const char *name, int64_t value);
+void config_set_uint(config_t *config, const char *section, const char *name, uint64_t value);
+void config_set_bool(config_t *config, const char *section, const char *name, bool value);
+void config_set_default_string(config_t *config, const char *section, const char *name, const char *value);
+void config_set_default_int(config_t *config, const char *section, const char *name, int64_t value);
+void config_set_default_uint(config_t *config, const char *section, const char *name, uint64_t value);
+void config_set_default_bool(config_t *config, const char *section, const char *name, bool value);
+bool config_has_user_value(config_t *config, const char *section, const char *name);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,103 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "c99defs.h"
+#include "bmem.h"
+#include <string.h>
+#include <assert.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+#define DARRAY_INVALID ((size_t)-1)
+struct darray { void *array; size_t num; size_t capacity; };
+static inline void darray_init(struct darray *dst) { dst->array = NULL; dst->num = 0; dst->capacity = 0; }
+static inline void darray_free(struct darray *dst) { bfree(dst->array); darray_init(dst); }
+static inline void darray_reserve(const size_t element_size, struct darray *dst, const size_t capacity)
+{
+    if (capacity == 0 || capacity <= dst->capacity) return;
+    void *ptr = bmalloc(element_size * capacity);
+    if (dst->array) {
+        if (dst->num) memcpy(ptr, dst->array, element_size * dst->num);
+        bfree(dst->array);
+    }
+    dst->array = ptr;
+    dst->capacity = capacity;
+}
+static inline void darray_ensure_capacity(const size_t element_size, struct darray *dst, const size_t new_size)
+{
+    if (new_size <= dst->capacity) return;
+    size_t new_cap = (!dst->capacity) ? new_size : dst->capacity * 2;
+    if (new_size > new_cap) new_cap = new_size;
+    void *ptr = bmalloc(element_size * new_cap);
+    if (dst->array) {
+        if (dst->capacity) memcpy(ptr, dst->array, element_size * dst->capacity);
+        bfree(dst->array);
+    }
+    dst->array = ptr;
+    dst->capacity = new_cap;
+}
+static inline void darray_resize(const size_t element_size, struct darray *dst, const size_t size)
+{
+    if (size == dst->num) return;
+    if (size == 0) { dst->num = 0; return; }
+    bool b_clear = size > dst->num;
+    size_t old_num = dst->num;
+    darray_ensure_capacity(element_size, dst, size);
+    dst->num = size;
+    if (b_clear) memset((char *)dst->array + element_size * old_num, 0, element_size * (dst->num - old_num));
+}
+static inline size_t darray_push_back(const size_t element_size, struct darray *dst, const void *item)
+{
+    darray_ensure_capacity(element_size, dst, ++dst->num);
+    memcpy((char *)dst->array + element_size * (dst->num - 1), item, element_size);
+    return dst->num - 1;
+}
+static inline void *darray_push_back_new(const size_t element_size, struct darray *dst)
+{
+    darray_ensure_capacity(element_size, dst, ++dst->num);
+    void *last = (char *)dst->array + element_size * (dst->num - 1);
+    memset(last, 0, element_size);
+    return last;
+}
+static inline size_t darray_push_back_array(const size_t element_size, struct darray *dst, const void *array, const size_t num)
+{
+    size_t old_num;
+    if (!dst) return 0;
+    if (!array || !num) return dst->num;
+    old_num = dst->num;
+    darray_resize(element_size, dst, dst->num + num);
+    memcpy((char *)dst->array + element_size * old_num, array, element_size * num);
+    return old_num;
+}
+static inline void darray_insert(const size_t element_size, struct darray *dst, const size_t idx, const void *item)
+{ darray_ensure_capacity(element_size, dst, dst->num + 1); char *p = (char *)dst->array + idx * element_size; memmove(p + element_size, p, (dst->num - idx) * element_size); memcpy(p, item, element_size); dst->num++; }
+static inline void darray_erase(const size_t element_size, struct darray *dst, const size_t idx)
+{
+    if (idx >= dst->num) return;
+    if (!--dst->num) return;
+    memmove((char *)dst->array + element_size * idx, (char *)dst->array + element_size * (idx + 1), element_size * (dst->num - idx));
+}
+static inline void darray_move(struct darray *dst, struct darray *src)
+{
+    darray_free(dst);
+    memcpy(dst, src, sizeof(struct darray));
+    src->array = NULL; src->capacity = 0; src->num = 0;
+}
+#define DARRAY(type) union { struct darray da; struct { type *array; size_t num; size_t capacity; }; }
+#define da_init(v) darray_init(&(v).da)
+#define da_free(v) darray_free(&(v).da)
+#define da_end(v) (((v).num) ? &(v).array[(v).num - 1] : NULL)
+#define da_reserve(v, capacity) darray_reserve(sizeof(*(v).array), &(v).da, capacity)
+#define da_resize(v, size) darray_resize(sizeof(*(v).array), &(v).da, size)
+#define da_clear(v) ((v).num = 0)
+#define da_push_back(v, item) darray_push_back(sizeof(*(v).array), &(v).da, item)
+#define da_push_back_new(v) darray_push_back_new(sizeof(*(v).array), &(v).da)
+#define da_push_back_array(dst, src_array, n) darray_push_back_array(sizeof(*(dst).array), &(dst).da, src_array, n)
+#define da_insert(v, idx, item) darray_insert(sizeof(*(v).array), &(v).da, idx, item)
+#define da_erase(v, idx) darray_erase(sizeof(*(v).array), &(v).da, idx)
+#define da_move(dst, src) darray_move(&(dst).da, &(src).da)
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "c99defs.h"
+#include "bmem.h"
+#include <string.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+struct dstr { char *array; size_t len; size_t capacity; };
+int astrcmpi(const char *str1, const char *str2);
+int astrcmpi_n(const char *str1, const char *str2, size_t n);
+static inline void dstr_init(struct dstr *dst) { dst->array = NULL; dst->len = 0; dst->capacity = 0; }
+void dstr_free(struct dstr *dst);
+void dstr_copy(struct dstr *dst, const char *array);
+void dstr_cat(struct dstr *dst, const char *array);
+void dstr_ncat(struct dstr *dst, const char *array, const size_t len);
+void dstr_printf(struct dstr *dst, const char *format, ...);
+void dstr_catf(struct dstr *dst, const char *format, ...);
+void dstr_cat_ch(struct dstr *dst, char ch);
+void dstr_reserve(struct dstr *dst, const size_t capacity);
+void dstr_resize(struct dstr *dst, const size_t num);
+static inline bool dstr_is_empty(const struct dstr *str) { return !str->array || !str->len || !*str->array; }
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "c99defs.h"
+#include <stdio.h>
+#include <sys/stat.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+FILE *os_fopen(const char *path, const char *mode);
+int64_t os_ftelli64(FILE *file);
+int os_fseeki64(FILE *file, int64_t offset, int origin);
+int64_t os_get_file_size(const char *path);
+bool os_sleepto_ns(uint64_t time_target);
+void os_sleep_ms(uint32_t duration);
+uint64_t os_gettime_ns(void);
+bool os_file_exists(const char *path);
+int os_unlink(const char *path);
+int os_rename(const char *old_path, const char *new_path);
+int os_mkdir(const char *path);
+int os_mkdirs(const char *path);
+char *os_get_abs_path_ptr(const char *path);
+const char *os_get_path_extension(const char *path);
+#define os_stat stat
+struct os_dir;
+typedef struct os_dir os_dir_t;
+struct os_dirent { char d_name[256]; bool directory; };
+os_dir_t *os_opendir(const char *path);
+struct os_dirent *os_readdir(os_dir_t *dir);
+void os_closedir(os_dir_t *dir);
+#define MKDIR_EXISTS 1
+#define MKDIR_SUCCESS 0
+#define MKDIR_ERROR -1
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+// Minimal stand-in for the libobs header of the same name, covering only
+// what the plugin sources use. Used by timestamp-bench, never by the plugin.
+
+#include "c99defs.h"
+#include <pthread.h>
+#include <errno.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+static inline long os_atomic_inc_long(volatile long *val) { return __atomic_add_fetch(val, 1, __ATOMIC_SEQ_CST); }
+static inline long os_atomic_dec_long(volatile long *val) { return __atomic_sub_fetch(val, 1, __ATOMIC_SEQ_CST); }
+static inline void os_atomic_store_long(volatile long *ptr, long val) { __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST); }
+static inline void os_atomic_set_long(volatile long *ptr, long val) { __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST); }
+static inline long os_atomic_exchange_long(volatile long *ptr, long val) { return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST); }
+static inline long os_atomic_load_long(const volatile long *ptr) { return __atomic_load_n(ptr, __ATOMIC_SEQ_CST); }
+static inline bool os_atomic_compare_swap_long(volatile long *val, long old_val, long new_val) { return __atomic_compare_exchange_n(val, &old_val, new_val, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+static inline bool os_atomic_compare_exchange_long(volatile long *val, long *old_val, long new_val) { return __atomic_compare_exchange_n(val, old_val, new_val, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+static inline void os_atomic_store_bool(volatile bool *ptr, bool val) { __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST); }
+static inline void os_atomic_set_bool(volatile bool *ptr, bool val) { __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST); }
+static inline bool os_atomic_exchange_bool(volatile bool *ptr, bool val) { return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST); }
+static inline bool os_atomic_load_bool(const volatile bool *ptr) { return __atomic_load_n(ptr, __ATOMIC_SEQ_CST); }
+
+struct os_event_data;
+struct os_sem_data;
+typedef struct os_event_data os_event_t;
+typedef struct os_sem_data os_sem_t;
+enum os_event_type { OS_EVENT_TYPE_AUTO, OS_EVENT_TYPE_MANUAL };
+int os_event_init(os_event_t **event, enum os_event_type type);
+void os_event_destroy(os_event_t *event);
+int os_event_wait(os_event_t *event);
+int os_event_timedwait(os_event_t *event, unsigned long milliseconds);
+int os_event_try(os_event_t *event);
+int os_event_signal(os_event_t *event);
+void os_event_reset(os_event_t *event);
+int os_sem_init(os_sem_t **sem, int value);
+void os_sem_destroy(os_sem_t *sem);
+int os_sem_post(os_sem_t *sem);
+int os_sem_wait(os_sem_t *sem);
+void os_set_thread_name(const char *name);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,1207 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "obs-stub.h"
+#include <obs-module.h>
+#include <util/config-file.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Memory
+
+void *bmalloc(size_t size)
+{
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        fprintf(stderr, "obs-stub: out of memory\n");
+        abort();
+    }
+    return ptr;
+}
+
+void *brealloc(void *ptr, size_t size)
+{
+    ptr = realloc(ptr, size ? size : 1);
+    if (!ptr) {
+        fprintf(stderr, "obs-stub: out of memory\n");
+        abort();
+    }
+    return ptr;
+}
+
+void bfree(void *ptr)
+{
+    free(ptr);
+}
+
+// Logging
+
+static int log_level = LOG_ERROR;
+
+void stub_set_log_level(int level)
+{
+    log_level = level;
+}
+
+void blog(int level, const char *format, ...)
+{
+    if (level > log_level) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+// Strings
+
+int astrcmpi(const char *str1, const char *str2)
+{
+    return strcasecmp(str1 ? str1 : "", str2 ? str2 : "");
+}
+
+int astrcmpi_n(const char *str1, const char *str2, size_t n)
+{
+    return strncasecmp(str1 ? str1 : "", str2 ? str2 : "", n);
+}
+
+// Platform
+
+uint64_t os_gettime_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void os_sleep_ms(uint32_t duration)
+{
+    usleep(duration * 1000);
+}
+
+FILE *os_fopen(const char *path, const char *mode)
+{
+    return fopen(path, mode);
+}
+
+int os_fseeki64(FILE *file, int64_t offset, int origin)
+{
+    return fseeko(file, (off_t)offset, origin);
+}
+
+int64_t os_ftelli64(FILE *file)
+{
+    return (int64_t)ftello(file);
+}
+
+bool os_file_exists(const char *path)
+{
+    return access(path, F_OK) == 0;
+}
+
+int64_t os_get_file_size(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 ? (int64_t)st.st_size : -1;
+}
+
+int os_unlink(const char *path)
+{
+    return unlink(path);
+}
+
+int os_rename(const char *old_path, const char *new_path)
+{
+    return rename(old_path, new_path);
+}
+
+int os_mkdir(const char *path)
+{
+    if (mkdir(path, 0755) == 0) {
+        return MKDIR_SUCCESS;
+    }
+    return errno == EEXIST ? MKDIR_EXISTS : MKDIR_ERROR;
+}
+
+int os_mkdirs(const char *path)
+{
+    char buffer[1024];
+    snprintf(buffer, sizeof(buffer), "%s", path);
+
+    for (char *p = buffer + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            os_mkdir(buffer);
+            *p = '/';
+        }
+    }
+    return os_mkdir(buffer) == MKDIR_ERROR ? MKDIR_ERROR : MKDIR_SUCCESS;
+}
+
+struct os_dir {
+    DIR *dir;
+    struct os_dirent entry;
+};
+
+os_dir_t *os_opendir(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return NULL;
+    }
+
+    os_dir_t *result = bzalloc(sizeof(*result));
+    result->dir = dir;
+    return result;
+}
+
+struct os_dirent *os_readdir(os_dir_t *dir)
+{
+    struct dirent *entry = readdir(dir->dir);
+    if (!entry) {
+        return NULL;
+    }
+
+    snprintf(dir->entry.d_name, sizeof(dir->entry.d_name), "%s", entry->d_name);
+    dir->entry.directory = entry->d_type == DT_DIR;
+    return &dir->entry;
+}
+
+void os_closedir(os_dir_t *dir)
+{
+    if (dir) {
+        closedir(dir->dir);
+        bfree(dir);
+    }
+}
+
+// Threading
+
+struct os_event_data {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool signalled;
+    bool manual;
+};
+
+int os_event_init(os_event_t **event, enum os_event_type type)
+{
+    os_event_t *data = bzalloc(sizeof(*data));
+    pthread_mutex_init(&data->mutex, NULL);
+    pthread_cond_init(&data->cond, NULL);
+    data->manual = type == OS_EVENT_TYPE_MANUAL;
+    *event = data;
+    return 0;
+}
+
+void os_event_destroy(os_event_t *event)
+{
+    if (event) {
+        pthread_mutex_destroy(&event->mutex);
+        pthread_cond_destroy(&event->cond);
+        bfree(event);
+    }
+}
+
+int os_event_wait(os_event_t *event)
+{
+    pthread_mutex_lock(&event->mutex);
+    while (!event->signalled) {
+        pthread_cond_wait(&event->cond, &event->mutex);
+    }
+    if (!event->manual) {
+        event->signalled = false;
+    }
+    pthread_mutex_unlock(&event->mutex);
+    return 0;
+}
+
+int os_event_timedwait(os_event_t *event, unsigned long milliseconds)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += (time_t)(milliseconds / 1000);
+    ts.tv_nsec += (long)(milliseconds % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+
+    int ret = 0;
+    pthread_mutex_lock(&event->mutex);
+    while (!event->signalled) {
+        ret = pthread_cond_timedwait(&event->cond, &event->mutex, &ts);
+        if (ret == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (event->signalled) {
+        ret = 0;
+        if (!event->manual) {
+            event->signalled = false;
+        }
+    }
+    pthread_mutex_unlock(&event->mutex);
+    return ret;
+}
+
+int os_event_try(os_event_t *event)
+{
+    int ret = EAGAIN;
+
+    pthread_mutex_lock(&event->mutex);
+    if (event->signalled) {
+        if (!event->manual) {
+            event->signalled = false;
+        }
+        ret = 0;
+    }
+    pthread_mutex_unlock(&event->mutex);
+    return ret;
+}
+
+int os_event_signal(os_event_t *event)
+{
+    pthread_mutex_lock(&event->mutex);
+    event->signalled = true;
+    pthread_cond_signal(&event->cond);
+    pthread_mutex_unlock(&event->mutex);
+    return 0;
+}
+
+void os_event_reset(os_event_t *event)
+{
+    pthread_mutex_lock(&event->mutex);
+    event->signalled = false;
+    pthread_mutex_unlock(&event->mutex);
+}
+
+// Counting semaphore on a mutex/condvar; unnamed POSIX semaphores are not
+// available on macOS
+struct os_sem_data {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int value;
+};
+
+int os_sem_init(os_sem_t **sem, int value)
+{
+    os_sem_t *data = bzalloc(sizeof(*data));
+    pthread_mutex_init(&data->mutex, NULL);
+    pthread_cond_init(&data->cond, NULL);
+    data->value = value;
+    *sem = data;
+    return 0;
+}
+
+void os_sem_destroy(os_sem_t *sem)
+{
+    if (sem) {
+        pthread_mutex_destroy(&sem->mutex);
+        pthread_cond_destroy(&sem->cond);
+        bfree(sem);
+    }
+}
+
+int os_sem_post(os_sem_t *sem)
+{
+    pthread_mutex_lock(&sem->mutex);
+    sem->value++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+    return 0;
+}
+
+int os_sem_wait(os_sem_t *sem)
+{
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->value <= 0) {
+        pthread_cond_wait(&sem->cond, &sem->mutex);
+    }
+    sem->value--;
+    pthread_mutex_unlock(&sem->mutex);
+    return 0;
+}
+
+void os_set_thread_name(const char *name)
+{
+#ifdef __APPLE__
+    pthread_setname_np(name);
+#else
+    pthread_setname_np(pthread_self(), name);
+#endif
+}
+
+// Profile config: a flat section/name/value list is plenty for a handful of keys
+
+struct config_entry {
+    char section[64];
+    char name[64];
+    char value[512];
+};
+
+#define STUB_CONFIG_ENTRIES 64
+
+struct config_data {
+    struct config_entry entries[STUB_CONFIG_ENTRIES];
+    size_t count;
+};
+
+static struct config_data profile_config;
+
+static struct config_entry *find_entry(config_t *config, const char *section, const char *name)
+{
+    for (size_t i = 0; i < config->count; i++) {
+        struct config_entry *entry = &config->entries[i];
+        if (strcmp(entry->section, section) == 0 && strcmp(entry->name, name) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+void config_set_string(config_t *config, const char *section, const char *name, const char *value)
+{
+    struct config_entry *entry = find_entry(config, section, name);
+    if (!entry) {
+        if (config->count == STUB_CONFIG_ENTRIES) {
+            fprintf(stderr, "obs-stub: config full, dropping %s/%s\n", section, name);
+            return;
+        }
+        entry = &config->entries[config->count++];
+        snprintf(entry->section, sizeof(entry->section), "%s", section);
+        snprintf(entry->name, sizeof(entry->name), "%s", name);
+    }
+    snprintf(entry->value, sizeof(entry->value), "%s", value ? value : "");
+}
+
+void stub_config_set(const char *section, const char *name, const char *value)
+{
+    config_set_string(&profile_config, section, name, value);
+}
+
+void stub_config_clear(void)
+{
+    profile_config.count = 0;
+}
+
+const char *config_get_string(config_t *config, const char *section, const char *name)
+{
+    struct config_entry *entry = find_entry(config, section, name);
+    return entry ? entry->value : NULL;
+}
+
+int64_t config_get_int(config_t *config, const char *section, const char *name)
+{
+    const char *value = config_get_string(config, section, name);
+    return value ? strtoll(value, NULL, 10) : 0;
+}
+
+uint64_t config_get_uint(config_t *config, const char *section, const char *name)
+{
+    const char *value = config_get_string(config, section, name);
+    return value ? strtoull(value, NULL, 10) : 0;
+}
+
+bool config_get_bool(config_t *config, const char *section, const char *name)
+{
+    const char *value = config_get_string(config, section, name);
+    return value && (astrcmpi(value, "true") == 0 || strtol(value, NULL, 10) != 0);
+}
+
+double config_get_double(config_t *config, const char *section, const char *name)
+{
+    const char *value = config_get_string(config, section, name);
+    return value ? strtod(value, NULL) : 0.0;
+}
+
+void config_set_int(config_t *config, const char *section, const char *name, int64_t value)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%lld", (long long)value);
+    config_set_string(config, section, name, buffer);
+}
+
+void config_set_uint(config_t *config, const char *section, const char *name, uint64_t value)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)value);
+    config_set_string(config, section, name, buffer);
+}
+
+void config_set_bool(config_t *config, const char *section, const char *name, bool value)
+{
+    config_set_string(config, section, name, value ? "true" : "false");
+}
+
+bool config_has_user_value(config_t *config, const char *section, const char *name)
+{
+    return find_entry(config, section, name) != NULL;
+}
+
+// Module
+
+static char config_dir[512] = ".";
+
+void stub_set_config_dir(const char *path)
+{
+    snprintf(config_dir, sizeof(config_dir), "%s", path);
+}
+
+obs_module_t *obs_current_module(void)
+{
+    return NULL;
+}
+
+char *obs_module_get_config_path(obs_module_t *module, const char *file)
+{
+    UNUSED_PARAMETER(module);
+
+    size_t size = strlen(config_dir) + strlen(file) + 2;
+    char *path = bmalloc(size);
+    snprintf(path, size, "%s/%s", config_dir, file);
+    return path;
+}
+
+// Video: no running output, so the plugin falls back to the profile FPS and
+// the wall clock
+
+bool obs_get_video_info(struct obs_video_info *ovi)
+{
+    memset(ovi, 0, sizeof(*ovi));
+    ovi->fps_num = 60;
+    ovi->fps_den = 1;
+    ovi->base_width = ovi->output_width = 1920;
+    ovi->base_height = ovi->output_height = 1080;
+    return true;
+}
+
+video_t *obs_get_video(void)
+{
+    return NULL;
+}
+
+const struct video_output_info *video_output_get_info(const video_t *video)
+{
+    UNUSED_PARAMETER(video);
+    return NULL;
+}
+
+uint64_t obs_get_video_frame_time(void)
+{
+    return os_gettime_ns();
+}
+
+// Sources are the current scene, which the bench names, and audio sources
+// with capture callbacks
+#define STUB_AUDIO_CALLBACKS 4
+
+struct audio_capture {
+    obs_source_audio_capture_t callback;
+    void *param;
+};
+
+struct obs_source {
+    char name[256];
+    struct audio_capture captures[STUB_AUDIO_CALLBACKS];
+    size_t capture_count;
+};
+
+const char *obs_source_get_name(const obs_source_t *source)
+{
+    return source ? source->name : NULL;
+}
+
+void obs_source_release(obs_source_t *source)
+{
+    UNUSED_PARAMETER(source);
+}
+
+// Audio: sources and mixes call back under this lock, so removing a callback
+// waits for one in progress, as in libobs
+
+#define STUB_AUDIO_SOURCES 4
+#define STUB_AUDIO_CHANNELS 2
+
+struct mix_output {
+    audio_output_callback_t callback;
+    void *param;
+};
+
+static pthread_mutex_t audio_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct obs_source audio_sources[STUB_AUDIO_SOURCES];
+static size_t audio_source_count = 0;
+static struct mix_output mix_outputs[MAX_AUDIO_MIXES][STUB_AUDIO_CALLBACKS];
+static size_t mix_output_count[MAX_AUDIO_MIXES];
+
+void stub_add_audio_source(const char *name)
+{
+    pthread_mutex_lock(&audio_mutex);
+    if (audio_source_count < STUB_AUDIO_SOURCES) {
+        snprintf(audio_sources[audio_source_count++].name, sizeof(audio_sources[0].name), "%s", name);
+    }
+    pthread_mutex_unlock(&audio_mutex);
+}
+
+obs_source_t *obs_get_source_by_name(const char *name)
+{
+    for (size_t i = 0; i < audio_source_count; i++) {
+        if (strcmp(audio_sources[i].name, name) == 0) {
+            return &audio_sources[i];
+        }
+    }
+    return NULL;
+}
+
+void obs_source_add_audio_capture_callback(obs_source_t *source, obs_source_audio_capture_t callback, void *param)
+{
+    pthread_mutex_lock(&audio_mutex);
+    if (source->capture_count < STUB_AUDIO_CALLBACKS) {
+        source->captures[source->capture_count].callback = callback;
+        source->captures[source->capture_count].param = param;
+        source->capture_count++;
+    }
+    pthread_mutex_unlock(&audio_mutex);
+}
+
+void obs_source_remove_audio_capture_callback(obs_source_t *source, obs_source_audio_capture_t callback,
+                                              void *param)
+{
+    pthread_mutex_lock(&audio_mutex);
+    for (size_t i = 0; i < source->capture_count; i++) {
+        if (source->captures[i].callback == callback && source->captures[i].param == param) {
+            source->captures[i] = source->captures[--source->capture_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&audio_mutex);
+}
+
+// Any non-NULL pointer; the stub has a single audio output
+static int audio_output;
+
+audio_t *obs_get_audio(void)
+{
+    return (audio_t *)&audio_output;
+}
+
+size_t audio_output_get_channels(const audio_t *audio)
+{
+    UNUSED_PARAMETER(audio);
+    return STUB_AUDIO_CHANNELS;
+}
+
+bool audio_output_connect(audio_t *audio, size_t mix_idx, const struct audio_convert_info *conversion,
+                          audio_output_callback_t callback, void *param)
+{
+    UNUSED_PARAMETER(audio);
+    UNUSED_PARAMETER(conversion);
+
+    bool ok = false;
+    pthread_mutex_lock(&audio_mutex);
+    if (mix_idx < MAX_AUDIO_MIXES && mix_output_count[mix_idx] < STUB_AUDIO_CALLBACKS) {
+        mix_outputs[mix_idx][mix_output_count[mix_idx]].callback = callback;
+        mix_outputs[mix_idx][mix_output_count[mix_idx]].param = param;
+        mix_output_count[mix_idx]++;
+        ok = true;
+    }
+    pthread_mutex_unlock(&audio_mutex);
+    return ok;
+}
+
+void audio_output_disconnect(audio_t *audio, size_t mix_idx, audio_output_callback_t callback, void *param)
+{
+    UNUSED_PARAMETER(audio);
+
+    pthread_mutex_lock(&audio_mutex);
+    for (size_t i = 0; mix_idx < MAX_AUDIO_MIXES && i < mix_output_count[mix_idx]; i++) {
+        if (mix_outputs[mix_idx][i].callback == callback && mix_outputs[mix_idx][i].param == param) {
+            mix_outputs[mix_idx][i] = mix_outputs[mix_idx][--mix_output_count[mix_idx]];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&audio_mutex);
+}
+
+void stub_push_audio(const char *source, size_t track, const float *const *planes, size_t channels,
+                     uint32_t frames, uint64_t timestamp)
+{
+    struct audio_data audio = {0};
+    for (size_t ch = 0; ch < channels && ch < MAX_AV_PLANES; ch++) {
+        audio.data[ch] = (uint8_t *)planes[ch];
+    }
+    audio.frames = frames;
+    audio.timestamp = timestamp;
+
+    pthread_mutex_lock(&audio_mutex);
+    if (source) {
+        obs_source_t *target = obs_get_source_by_name(source);
+        for (size_t i = 0; target && i < target->capture_count; i++) {
+            target->captures[i].callback(target->captures[i].param, target, &audio, false);
+        }
+    } else if (track >= 1 && track <= MAX_AUDIO_MIXES) {
+        for (size_t i = 0; i < mix_output_count[track - 1]; i++) {
+            mix_outputs[track - 1][i].callback(mix_outputs[track - 1][i].param, track - 1, &audio);
+        }
+    }
+    pthread_mutex_unlock(&audio_mutex);
+}
+
+// Raw video: called back under a lock, as in libobs
+
+#define STUB_VIDEO_CALLBACKS 4
+
+struct raw_video_callback {
+    void (*callback)(void *param, struct video_data *frame);
+    void *param;
+    uint32_t divisor;
+    uint64_t count;
+};
+
+static pthread_mutex_t video_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct raw_video_callback video_callbacks[STUB_VIDEO_CALLBACKS];
+static size_t video_callback_count = 0;
+
+void obs_add_raw_video_callback2(const struct video_scale_info *conversion, uint32_t frame_rate_divisor,
+                                 void (*callback)(void *param, struct video_data *frame), void *param)
+{
+    UNUSED_PARAMETER(conversion);
+
+    pthread_mutex_lock(&video_mutex);
+    if (video_callback_count < STUB_VIDEO_CALLBACKS) {
+        struct raw_video_callback *entry = &video_callbacks[video_callback_count++];
+        entry->callback = callback;
+        entry->param = param;
+        entry->divisor = frame_rate_divisor ? frame_rate_divisor : 1;
+        entry->count = 0;
+    }
+    pthread_mutex_unlock(&video_mutex);
+}
+
+void obs_remove_raw_video_callback2(const struct video_scale_info *conversion, uint32_t frame_rate_divisor,
+                                    void (*callback)(void *param, struct video_data *frame), void *param)
+{
+    UNUSED_PARAMETER(conversion);
+    UNUSED_PARAMETER(frame_rate_divisor);
+
+    pthread_mutex_lock(&video_mutex);
+    for (size_t i = 0; i < video_callback_count; i++) {
+        if (video_callbacks[i].callback == callback && video_callbacks[i].param == param) {
+            video_callbacks[i] = video_callbacks[--video_callback_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&video_mutex);
+}
+
+void obs_add_raw_video_callback(const struct video_scale_info *conversion,
+                                void (*callback)(void *param, struct video_data *frame), void *param)
+{
+    obs_add_raw_video_callback2(conversion, 1, callback, param);
+}
+
+void obs_remove_raw_video_callback(void (*callback)(void *param, struct video_data *frame), void *param)
+{
+    obs_remove_raw_video_callback2(NULL, 1, callback, param);
+}
+
+void stub_push_video(const uint8_t *luma, uint32_t linesize, uint64_t timestamp)
+{
+    struct video_data frame = {0};
+    frame.data[0] = (uint8_t *)luma;
+    frame.linesize[0] = linesize;
+    frame.timestamp = timestamp;
+
+    pthread_mutex_lock(&video_mutex);
+    for (size_t i = 0; i < video_callback_count; i++) {
+        if (video_callbacks[i].count++ % video_callbacks[i].divisor == 0) {
+            video_callbacks[i].callback(video_callbacks[i].param, &frame);
+        }
+    }
+    pthread_mutex_unlock(&video_mutex);
+}
+
+void obs_output_release(obs_output_t *output)
+{
+    UNUSED_PARAMETER(output);
+}
+
+static volatile long recorded_frames = 0;
+
+void stub_set_recorded_frames(int frames)
+{
+    os_atomic_set_long(&recorded_frames, frames);
+}
+
+bool obs_output_active(const obs_output_t *output)
+{
+    return output != NULL;
+}
+
+int obs_output_get_total_frames(const obs_output_t *output)
+{
+    UNUSED_PARAMETER(output);
+    return (int)os_atomic_load_long(&recorded_frames);
+}
+
+// Never paused by libobs itself, so pauses are timed by the frontend events
+uint64_t obs_output_get_pause_offset(obs_output_t *output)
+{
+    UNUSED_PARAMETER(output);
+    return 0;
+}
+
+obs_data_t *obs_output_get_settings(const obs_output_t *output)
+{
+    UNUSED_PARAMETER(output);
+    return NULL;
+}
+
+// Data and hotkeys: the bench drives the hotkey callback directly
+
+obs_data_t *obs_data_create(void)
+{
+    return NULL;
+}
+
+obs_data_t *obs_data_create_from_json(const char *json_string)
+{
+    UNUSED_PARAMETER(json_string);
+    return NULL;
+}
+
+void obs_data_release(obs_data_t *data)
+{
+    UNUSED_PARAMETER(data);
+}
+
+const char *obs_data_get_json(obs_data_t *data)
+{
+    UNUSED_PARAMETER(data);
+    return "{}";
+}
+
+const char *obs_data_get_string(obs_data_t *data, const char *name)
+{
+    UNUSED_PARAMETER(data);
+    UNUSED_PARAMETER(name);
+    return "";
+}
+
+long long obs_data_get_int(obs_data_t *data, const char *name)
+{
+    UNUSED_PARAMETER(data);
+    UNUSED_PARAMETER(name);
+    return 0;
+}
+
+bool obs_data_has_user_value(obs_data_t *data, const char *name)
+{
+    UNUSED_PARAMETER(data);
+    UNUSED_PARAMETER(name);
+    return false;
+}
+
+void obs_data_set_string(obs_data_t *data, const char *name, const char *val)
+{
+    UNUSED_PARAMETER(data);
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(val);
+}
+
+void obs_data_set_int(obs_data_t *data, const char *name, long long val)
+{
+    UNUSED_PARAMETER(data);
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(val);
+}
+
+void obs_data_set_bool(obs_data_t *data, const char *name, bool val)
+{
+    UNUSED_PARAMETER(data);
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(val);
+}
+
+void obs_data_set_array(obs_data_t *data, const char *name, obs_data_array_t *array)
+{
+    UNUSED_PARAMETER(data);
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(array);
+}
+
+obs_data_array_t *obs_data_get_array(obs_data_t *data, const char *name)
+{
+    UNUSED_PARAMETER(data);
+    UNUSED_PARAMETER(name);
+    return NULL;
+}
+
+obs_data_array_t *obs_data_array_create(void)
+{
+    return NULL;
+}
+
+void obs_data_array_release(obs_data_array_t *array)
+{
+    UNUSED_PARAMETER(array);
+}
+
+size_t obs_data_array_count(obs_data_array_t *array)
+{
+    UNUSED_PARAMETER(array);
+    return 0;
+}
+
+obs_data_t *obs_data_array_item(obs_data_array_t *array, size_t idx)
+{
+    UNUSED_PARAMETER(array);
+    UNUSED_PARAMETER(idx);
+    return NULL;
+}
+
+size_t obs_data_array_push_back(obs_data_array_t *array, obs_data_t *obj)
+{
+    UNUSED_PARAMETER(array);
+    UNUSED_PARAMETER(obj);
+    return 0;
+}
+
+obs_hotkey_id obs_hotkey_register_frontend(const char *name, const char *description, obs_hotkey_func func,
+                                           void *data)
+{
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(description);
+    UNUSED_PARAMETER(func);
+    UNUSED_PARAMETER(data);
+    return 1;
+}
+
+void obs_hotkey_unregister(obs_hotkey_id id)
+{
+    UNUSED_PARAMETER(id);
+}
+
+void obs_hotkey_load(obs_hotkey_id id, obs_data_array_t *data)
+{
+    UNUSED_PARAMETER(id);
+    UNUSED_PARAMETER(data);
+}
+
+obs_data_array_t *obs_hotkey_save(obs_hotkey_id id)
+{
+    UNUSED_PARAMETER(id);
+    return NULL;
+}
+
+// Frontend
+
+#define STUB_EVENT_CALLBACKS 8
+
+struct event_callback {
+    obs_frontend_event_cb callback;
+    void *data;
+};
+
+static struct event_callback event_callbacks[STUB_EVENT_CALLBACKS];
+static size_t event_callback_count = 0;
+
+config_t *obs_frontend_get_profile_config(void)
+{
+    return &profile_config;
+}
+
+// One recording output with a "file_changed" signal
+
+struct obs_output {
+    int unused;
+};
+
+struct signal_handler {
+    pthread_mutex_t mutex;
+    signal_callback_t callback;
+    void *data;
+};
+
+static struct obs_output recording_output;
+static bool has_recording_output = false;
+static struct signal_handler output_signals = {PTHREAD_MUTEX_INITIALIZER, NULL, NULL};
+
+void stub_set_recording_output(bool enabled)
+{
+    has_recording_output = enabled;
+}
+
+obs_output_t *obs_frontend_get_recording_output(void)
+{
+    return has_recording_output ? &recording_output : NULL;
+}
+
+signal_handler_t *obs_output_get_signal_handler(const obs_output_t *output)
+{
+    UNUSED_PARAMETER(output);
+    return &output_signals;
+}
+
+void signal_handler_connect(signal_handler_t *handler, const char *signal, signal_callback_t callback, void *data)
+{
+    if (strcmp(signal, "file_changed") == 0) {
+        pthread_mutex_lock(&handler->mutex);
+        handler->callback = callback;
+        handler->data = data;
+        pthread_mutex_unlock(&handler->mutex);
+    }
+}
+
+void signal_handler_disconnect(signal_handler_t *handler, const char *signal, signal_callback_t callback,
+                               void *data)
+{
+    pthread_mutex_lock(&handler->mutex);
+    if (strcmp(signal, "file_changed") == 0 && handler->callback == callback && handler->data == data) {
+        handler->callback = NULL;
+        handler->data = NULL;
+    }
+    pthread_mutex_unlock(&handler->mutex);
+}
+
+void stub_split_recording(const char *next_file)
+{
+    calldata_t data = {0};
+    calldata_set_string(&data, "next_file", next_file);
+
+    // Held while calling back, so disconnect waits for a running callback
+    pthread_mutex_lock(&output_signals.mutex);
+    if (output_signals.callback) {
+        output_signals.callback(output_signals.data, &data);
+    }
+    pthread_mutex_unlock(&output_signals.mutex);
+    calldata_free(&data);
+}
+
+// Calldata: a short list of named values, looked up by name
+
+static void check_calldata(const calldata_t *data)
+{
+    if (data && data->freed) {
+        fprintf(stderr, "obs-stub: calldata used after calldata_free\n");
+        abort();
+    }
+}
+
+static const struct calldata_entry *find_calldata(const calldata_t *data, const char *name)
+{
+    check_calldata(data);
+    for (size_t i = 0; data && i < data->count; i++) {
+        if (strcmp(data->entries[i].name, name) == 0) {
+            return &data->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static struct calldata_entry *set_calldata(calldata_t *data, const char *name)
+{
+    struct calldata_entry *entry = (struct calldata_entry *)find_calldata(data, name);
+    if (!entry) {
+        if (data->count == CALLDATA_STUB_ENTRIES) {
+            fprintf(stderr, "obs-stub: too many calldata entries\n");
+            abort();
+        }
+        entry = &data->entries[data->count++];
+    }
+    memset(entry, 0, sizeof(*entry));
+    entry->name = name;
+    return entry;
+}
+
+void calldata_init(calldata_t *data)
+{
+    memset(data, 0, sizeof(*data));
+}
+
+void calldata_free(calldata_t *data)
+{
+    check_calldata(data);
+    memset(data->entries, 0xdd, sizeof(data->entries));
+    data->count = 0;
+    data->freed = true;
+}
+
+void calldata_set_string(calldata_t *data, const char *name, const char *str)
+{
+    set_calldata(data, name)->string = str;
+}
+
+void calldata_set_ptr(calldata_t *data, const char *name, void *ptr)
+{
+    set_calldata(data, name)->ptr = ptr;
+}
+
+void calldata_set_int(calldata_t *data, const char *name, long long val)
+{
+    set_calldata(data, name)->integer = val;
+}
+
+void calldata_set_bool(calldata_t *data, const char *name, bool val)
+{
+    set_calldata(data, name)->boolean = val;
+}
+
+const char *calldata_string(const calldata_t *data, const char *name)
+{
+    const struct calldata_entry *entry = find_calldata(data, name);
+    return entry ? entry->string : NULL;
+}
+
+void *calldata_ptr(const calldata_t *data, const char *name)
+{
+    const struct calldata_entry *entry = find_calldata(data, name);
+    return entry ? entry->ptr : NULL;
+}
+
+long long calldata_int(const calldata_t *data, const char *name)
+{
+    const struct calldata_entry *entry = find_calldata(data, name);
+    return entry ? entry->integer : 0;
+}
+
+bool calldata_bool(const calldata_t *data, const char *name)
+{
+    const struct calldata_entry *entry = find_calldata(data, name);
+    return entry ? entry->boolean : false;
+}
+
+// The global proc handler; no other module registers anything, so calls
+// to obs-websocket find nothing, like OBS without it
+
+#define STUB_PROCS 8
+
+struct proc_entry {
+    char name[64];
+    proc_handler_proc_t proc;
+    void *data;
+};
+
+struct proc_handler {
+    pthread_mutex_t mutex;
+    struct proc_entry procs[STUB_PROCS];
+    size_t count;
+};
+
+static struct proc_handler global_procs = {PTHREAD_MUTEX_INITIALIZER, {{"", NULL, NULL}}, 0};
+
+proc_handler_t *obs_get_proc_handler(void)
+{
+    return &global_procs;
+}
+
+void proc_handler_add(proc_handler_t *handler, const char *decl_string, proc_handler_proc_t proc, void *data)
+{
+    // "void name(in string json, out string result)": the name is the word before '('
+    const char *open = strchr(decl_string, '(');
+    const char *start = open;
+    while (start && start > decl_string && start[-1] != ' ') {
+        start--;
+    }
+    if (!open || open == start) {
+        fprintf(stderr, "obs-stub: bad proc declaration: %s\n", decl_string);
+        return;
+    }
+
+    pthread_mutex_lock(&handler->mutex);
+    if (handler->count < STUB_PROCS) {
+        struct proc_entry *entry = &handler->procs[handler->count++];
+        snprintf(entry->name, sizeof(entry->name), "%.*s", (int)(open - start), start);
+        entry->proc = proc;
+        entry->data = data;
+    }
+    pthread_mutex_unlock(&handler->mutex);
+}
+
+bool proc_handler_call(proc_handler_t *handler, const char *name, calldata_t *params)
+{
+    proc_handler_proc_t proc = NULL;
+    void *data = NULL;
+
+    check_calldata(params);
+    pthread_mutex_lock(&handler->mutex);
+    for (size_t i = 0; i < handler->count; i++) {
+        if (strcmp(handler->procs[i].name, name) == 0) {
+            proc = handler->procs[i].proc;
+            data = handler->procs[i].data;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&handler->mutex);
+
+    if (!proc) {
+        return false;
+    }
+    proc(data, params);
+    return true;
+}
+
+static char last_recording[512] = "";
+
+void stub_set_last_recording(const char *path)
+{
+    snprintf(last_recording, sizeof(last_recording), "%s", path ? path : "");
+}
+
+char *obs_frontend_get_last_recording(void)
+{
+    return last_recording[0] ? bstrdup(last_recording) : NULL;
+}
+
+static struct obs_source current_scene;
+static bool has_current_scene = false;
+
+void stub_set_current_scene(const char *name)
+{
+    has_current_scene = name != NULL;
+    snprintf(current_scene.name, sizeof(current_scene.name), "%s", name ? name : "");
+}
+
+obs_source_t *obs_frontend_get_current_scene(void)
+{
+    return has_current_scene ? &current_scene : NULL;
+}
+
+void obs_frontend_add_event_callback(obs_frontend_event_cb callback, void *private_data)
+{
+    if (event_callback_count < STUB_EVENT_CALLBACKS) {
+        event_callbacks[event_callback_count].callback = callback;
+        event_callbacks[event_callback_count].data = private_data;
+        event_callback_count++;
+    }
+}
+
+void obs_frontend_remove_event_callback(obs_frontend_event_cb callback, void *private_data)
+{
+    for (size_t i = 0; i < event_callback_count; i++) {
+        if (event_callbacks[i].callback == callback && event_callbacks[i].data == private_data) {
+            event_callbacks[i] = event_callbacks[--event_callback_count];
+            return;
+        }
+    }
+}
+
+void stub_frontend_event(enum obs_frontend_event event)
+{
+    for (size_t i = 0; i < event_callback_count; i++) {
+        event_callbacks[i].callback(event, event_callbacks[i].data);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <obs-frontend-api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Controls for the libobs/frontend stand-in that timestamp-bench links the
+// plugin sources against
+
+// Only messages at or above this severity (LOG_ERROR is the most severe) are
+// printed to stderr; LOG_ERROR by default
+void stub_set_log_level(int level);
+
+// Directory obs_module_config_path() resolves into
+void stub_set_config_dir(const char *path);
+
+// Set a value in the profile config returned by obs_frontend_get_profile_config()
+void stub_config_set(const char *section, const char *name, const char *value);
+void stub_config_clear(void);
+
+// Path obs_frontend_get_last_recording() returns (NULL = no recording)
+void stub_set_last_recording(const char *path);
+
+// Whether obs_frontend_get_recording_output() returns an output (false by default)
+void stub_set_recording_output(bool enabled);
+
+// Frames obs_output_get_total_frames() says the recording output has taken (0 by default)
+void stub_set_recorded_frames(int frames);
+
+// Have the recording output continue in next_file, emitting its
+// "file_changed" signal like a file split does
+void stub_split_recording(const char *next_file);
+
+// Name of the scene obs_frontend_get_current_scene() returns (NULL = none)
+void stub_set_current_scene(const char *name);
+
+// Create an audio source obs_get_source_by_name() finds
+void stub_add_audio_source(const char *name);
+
+// Deliver a block of float planar audio (channels planes of frames samples)
+// to the capture callbacks of the named source, or to those of output track
+// 1-6 if source is NULL, like the libobs audio thread does
+void stub_push_audio(const char *source, size_t track, const float *const *planes, size_t channels,
+                     uint32_t frames, uint64_t timestamp);
+
+// Deliver a luma frame to the raw video callbacks, each of which gets every
+// frame_rate_divisor-th one. The frame must already have the size of the
+// callback's conversion; the stub doesn't scale.
+void stub_push_video(const uint8_t *luma, uint32_t linesize, uint64_t timestamp);
+
+// Deliver a frontend event to every registered callback, like the OBS UI does
+void stub_frontend_event(enum obs_frontend_event event);
+
+#ifdef __cplusplus
+}
+#endif
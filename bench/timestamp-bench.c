@@ -0,0 +1,319 @@
+// timestamp-bench: drives the plugin's marker path (hotkey callback and
+// save_timestamp through the writer thread to the disk) against the libobs
+// stub and reports caller latency, throughput and drops per scenario.
+//
+// usage: timestamp-bench [burst] [fsync] [long] [--dir DIR] [--markers N]
+//                        [--threads N] [--rate N] [--live-xml] [--coalesce-ms N]
+//                        [--repeat-ms N] [--broadcast ADDR] [--verbose]
+
+#include "timestamp-plugin.h"
+#include "marker-writer.h"
+#include "obs-stub.h"
+#include <util/platform.h>
+#include <util/threading.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_MAX_THREADS 16
+
+// How long to wait for the writer to catch up before giving up
+#define BENCH_DRAIN_TIMEOUT_MS 60000
+
+struct scenario {
+    const char *name;
+    const char *description;
+    const char *flush_mode;
+    size_t markers;        // per thread
+    size_t threads;
+    uint64_t rate;         // markers per second per thread, 0 = as fast as possible
+};
+
+static const struct scenario scenarios[] = {
+    {"burst", "hotkey mashed as fast as possible", "count", 5000, 1, 0},
+    {"fsync", "fsync after every marker (slow-disk worst case)", "fsync", 2000, 1, 2000},
+    {"long", "very long session at a sustained rate", "count", 200000, 1, 20000},
+};
+
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+struct options {
+    const char *dir;
+    size_t markers;
+    size_t threads;
+    int64_t rate; // -1 = scenario default
+    bool live_xml;
+    uint32_t coalesce_ms;
+    uint32_t repeat_ms;
+    const char *broadcast;
+    bool verbose;
+};
+
+struct producer {
+    pthread_t thread;
+    size_t index;
+    size_t count;
+    uint64_t rate;
+    uint64_t start_ns;
+    uint64_t *latencies;
+};
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Wait for the scheduled time of the next marker: sleep while far off, spin close to it
+static void wait_until(uint64_t target_ns)
+{
+    for (;;) {
+        uint64_t now = os_gettime_ns();
+        if (now >= target_ns) {
+            return;
+        }
+        if (target_ns - now > 2000000) {
+            os_sleep_ms(1);
+        }
+    }
+}
+
+static void *producer_thread(void *data)
+{
+    struct producer *producer = data;
+    uint64_t interval_ns = producer->rate ? 1000000000ULL / producer->rate : 0;
+
+    for (size_t i = 0; i < producer->count; i++) {
+        if (interval_ns) {
+            wait_until(producer->start_ns + i * interval_ns);
+        }
+
+        uint64_t begin = os_gettime_ns();
+
+        // The first thread plays the hotkey thread; others are API callers
+        if (producer->index == 0) {
+            timestamp_hotkey_callback(NULL, 0, NULL, true);
+        } else {
+            save_timestamp(begin / 1000000, "Bench marker", "", "blue");
+        }
+
+        producer->latencies[i] = os_gettime_ns() - begin;
+    }
+
+    return NULL;
+}
+
+// Presses the writer has stored so far; a coalesced marker counts all of its own
+static size_t stored_presses(size_t *markers)
+{
+    size_t count = timestamp_marker_count();
+    size_t presses = 0;
+    struct marker_record record;
+
+    for (size_t i = 0; i < count; i++) {
+        if (timestamp_marker_get(i, &record)) {
+            presses += record.count ? record.count : 1;
+        }
+    }
+
+    *markers = count;
+    return presses;
+}
+
+static double percentile_us(const uint64_t *sorted, size_t count, double percentile)
+{
+    if (!count) {
+        return 0.0;
+    }
+
+    size_t index = (size_t)(percentile / 100.0 * (double)(count - 1) + 0.5);
+    return (double)sorted[index] / 1000.0;
+}
+
+static void run_scenario(const struct scenario *scenario, const struct options *options)
+{
+    size_t threads = options->threads ? options->threads : scenario->threads;
+    size_t markers = options->markers ? options->markers : scenario->markers;
+    uint64_t rate = options->rate >= 0 ? (uint64_t)options->rate : scenario->rate;
+
+    if (threads > BENCH_MAX_THREADS) {
+        threads = BENCH_MAX_THREADS;
+    }
+
+    stub_config_clear();
+    stub_config_set("Output", "Mode", "Simple");
+    stub_config_set("SimpleOutput", "FilePath", options->dir);
+    stub_config_set("Video", "FPSType", "0");
+    stub_config_set("Video", "FPSCommon", "60");
+    stub_config_set("TimestampMarker", "FlushMode", scenario->flush_mode);
+    stub_config_set("TimestampMarker", "LiveXml", options->live_xml ? "true" : "false");
+
+    char value[32];
+    snprintf(value, sizeof(value), "%u", options->coalesce_ms);
+    stub_config_set("TimestampMarker", "CoalesceMs", value);
+    snprintf(value, sizeof(value), "%u", options->repeat_ms);
+    stub_config_set("TimestampMarker", "RepeatIntervalMs", value);
+    stub_config_set("TimestampMarker", "BroadcastAddress", options->broadcast ? options->broadcast : "");
+
+    // Stand-in for the file OBS would have recorded, so the stop path finds it
+    char video_path[512];
+    snprintf(video_path, sizeof(video_path), "%s/%s.mkv", options->dir, scenario->name);
+    FILE *video = fopen(video_path, "w");
+    if (video) {
+        fclose(video);
+    }
+    stub_set_last_recording(video_path);
+
+    init_timestamp_plugin();
+    stub_frontend_event(OBS_FRONTEND_EVENT_FINISHED_LOADING);
+    stub_frontend_event(OBS_FRONTEND_EVENT_RECORDING_STARTED);
+
+    // Let the writer open the session before the clock starts
+    marker_writer_flush();
+
+    struct producer producers[BENCH_MAX_THREADS];
+    uint64_t start_ns = os_gettime_ns();
+
+    for (size_t i = 0; i < threads; i++) {
+        producers[i].index = i;
+        producers[i].count = markers;
+        producers[i].rate = rate;
+        producers[i].start_ns = start_ns;
+        producers[i].latencies = bmalloc(markers * sizeof(uint64_t));
+        pthread_create(&producers[i].thread, NULL, producer_thread, &producers[i]);
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        pthread_join(producers[i].thread, NULL);
+    }
+    uint64_t issued_ns = os_gettime_ns();
+
+    // Wait until everything that made it into the queue is on the disk
+    size_t total = threads * markers;
+    uint64_t dropped = marker_writer_dropped();
+    size_t expected = 1 + total - (size_t)dropped; // plus the start marker
+    uint64_t deadline = issued_ns + (uint64_t)BENCH_DRAIN_TIMEOUT_MS * 1000000ULL;
+
+    size_t stored = 0;
+    while (stored_presses(&stored) < expected && os_gettime_ns() < deadline) {
+        marker_writer_flush();
+    }
+    uint64_t written_ns = os_gettime_ns();
+    size_t written = stored_presses(&stored) - 1;
+
+    stub_frontend_event(OBS_FRONTEND_EVENT_RECORDING_STOPPED);
+    free_timestamp_plugin();
+    uint64_t stopped_ns = os_gettime_ns();
+
+    // Merge and sort the caller-side latencies
+    uint64_t *latencies = bmalloc(total * sizeof(uint64_t));
+    for (size_t i = 0; i < threads; i++) {
+        memcpy(latencies + i * markers, producers[i].latencies, markers * sizeof(uint64_t));
+        bfree(producers[i].latencies);
+    }
+    qsort(latencies, total, sizeof(uint64_t), compare_u64);
+
+    double issue_s = (double)(issued_ns - start_ns) / 1e9;
+    double write_s = (double)(written_ns - start_ns) / 1e9;
+
+    printf("%s: %s\n", scenario->name, scenario->description);
+    printf("  %zu marker(s) from %zu thread(s), %s, FlushMode=%s%s\n", total, threads,
+           rate ? "paced" : "unpaced", scenario->flush_mode, options->live_xml ? ", live XML" : "");
+    if (rate) {
+        printf("  target rate      %" PRIu64 " markers/s per thread\n", rate);
+    }
+    printf("  caller latency   p50 %.2fus  p99 %.2fus  p99.9 %.2fus  max %.2fus\n",
+           percentile_us(latencies, total, 50.0), percentile_us(latencies, total, 99.0),
+           percentile_us(latencies, total, 99.9), total ? (double)latencies[total - 1] / 1000.0 : 0.0);
+    printf("  caller rate      %.0f markers/s\n", issue_s > 0 ? (double)total / issue_s : 0.0);
+    printf("  written          %zu in %.1fms (%.0f markers/s), %" PRIu64 " dropped%s\n", written,
+           write_s * 1000.0, write_s > 0 ? (double)written / write_s : 0.0, dropped,
+           written + dropped < total ? ", writer did not catch up" : "");
+    if (options->coalesce_ms || options->repeat_ms) {
+        printf("  stored           %zu marker(s) (CoalesceMs=%u, RepeatIntervalMs=%u)\n", stored - 1,
+               options->coalesce_ms, options->repeat_ms);
+    }
+    printf("  stop             %.1fms (session close and XML export)\n\n",
+           (double)(stopped_ns - written_ns) / 1e6);
+
+    bfree(latencies);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [scenario...] [--dir DIR] [--markers N] [--threads N] [--rate N] [--live-xml]\n"
+            "       [--coalesce-ms N] [--repeat-ms N] [--broadcast ADDR] [--verbose]\n",
+            argv0);
+    fprintf(stderr, "scenarios:\n");
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+        fprintf(stderr, "  %-6s %s\n", scenarios[i].name, scenarios[i].description);
+    }
+    fprintf(stderr, "--dir is where the session files go; point it at the disk you want to measure.\n");
+}
+
+int main(int argc, char **argv)
+{
+    struct options options = {0};
+    options.rate = -1;
+
+    bool selected[SCENARIO_COUNT] = {0};
+    bool any_selected = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(arg, "--dir") == 0 && has_value) {
+            options.dir = argv[++i];
+        } else if (strcmp(arg, "--markers") == 0 && has_value) {
+            options.markers = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            options.threads = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--rate") == 0 && has_value) {
+            options.rate = strtoll(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--live-xml") == 0) {
+            options.live_xml = true;
+        } else if (strcmp(arg, "--coalesce-ms") == 0 && has_value) {
+            options.coalesce_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--repeat-ms") == 0 && has_value) {
+            options.repeat_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--broadcast") == 0 && has_value) {
+            options.broadcast = argv[++i];
+        } else if (strcmp(arg, "--verbose") == 0) {
+            options.verbose = true;
+        } else {
+            bool found = false;
+            for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+                if (strcmp(arg, scenarios[s].name) == 0) {
+                    selected[s] = found = any_selected = true;
+                }
+            }
+            if (!found) {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    char temp_dir[] = "/tmp/timestamp-bench-XXXXXX";
+    if (!options.dir) {
+        if (!mkdtemp(temp_dir)) {
+            perror("mkdtemp");
+            return 1;
+        }
+        options.dir = temp_dir;
+    }
+
+    stub_set_log_level(options.verbose ? LOG_INFO : LOG_ERROR);
+    stub_set_config_dir(options.dir);
+    printf("Writing session files to %s\n\n", options.dir);
+
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+        if (!any_selected || selected[i]) {
+            run_scenario(&scenarios[i], &options);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,604 @@
+// timestamp-loadgen: synthesizes recording sessions of a given size and
+// arrival pattern, replays them through the plugin's marker pipeline
+// (save_timestamps, the writer thread, the session log and the stop-time
+// export) against the libobs stub, then runs each exporter and the Python
+// converter on the result. Reports wall time, peak RSS and output size per
+// stage, so regressions in the writer or the converters show up before they
+// reach a recorder.
+//
+// usage: timestamp-loadgen [--dir DIR] [--sizes N,N,...] [--pattern steady|bursty]
+//                          [--burst N] [--rate N] [--comment-size N] [--name-size N]
+//                          [--seed N] [--python PATH] [--converter PATH]
+//                          [--no-converter] [--converter-max N] [--verbose]
+
+#include "timestamp-plugin.h"
+#include "marker-export.h"
+#include "marker-store.h"
+#include "marker-writer.h"
+#include "obs-stub.h"
+#include <util/platform.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#ifndef LOADGEN_CONVERTER
+#define LOADGEN_CONVERTER "data/timestamp_to_premiere.py"
+#endif
+
+#define LOADGEN_MAX_SIZES 8
+#define LOADGEN_MAX_BURST 512
+
+// Markers of one burst land this far apart on the recording timeline
+#define LOADGEN_BURST_SPACING_MS 20
+
+enum pattern {
+    PATTERN_STEADY, // evenly spaced, each submitted on its own like a hotkey press
+    PATTERN_BURSTY, // bursts of markers submitted as one batch, random gaps between
+};
+
+struct options {
+    const char *dir;
+    size_t sizes[LOADGEN_MAX_SIZES];
+    size_t size_count;
+    enum pattern pattern;
+    size_t burst;
+    double rate; // markers per second of recording, on average
+    size_t comment_size;
+    size_t name_size;
+    uint64_t seed;
+    const char *python;
+    const char *converter;
+    size_t converter_max; // largest session given to the in-memory converter
+    bool verbose;
+};
+
+// Deterministic marker stream: the same options and seed give the same
+// session every time, so each stage regenerates it instead of keeping it
+struct generator {
+    const struct options *options;
+    uint64_t state;
+    uint64_t next_ns;
+    size_t index;
+};
+
+static const char *colors[] = {"blue", "cyan", "green", "yellow", "red", "magenta", "purple", "orange"};
+
+// Mostly plain text, with the characters that JSON and XML have to escape
+static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789     \"\\&<>'";
+
+static void generator_init(struct generator *gen, const struct options *options)
+{
+    gen->options = options;
+    gen->state = options->seed ? options->seed : 1;
+    gen->next_ns = 1000000000ULL;
+    gen->index = 0;
+}
+
+static uint64_t next_random(struct generator *gen)
+{
+    // xorshift64*
+    gen->state ^= gen->state >> 12;
+    gen->state ^= gen->state << 25;
+    gen->state ^= gen->state >> 27;
+    return gen->state * 2685821657736338717ULL;
+}
+
+static void fill_text(struct generator *gen, char *buffer, size_t size, size_t length, const char *prefix)
+{
+    if (length >= size) {
+        length = size - 1;
+    }
+
+    int written = snprintf(buffer, size, "%s%zu ", prefix, gen->index + 1);
+    size_t used = written > 0 && (size_t)written < length ? (size_t)written : 0;
+    for (size_t i = used; i < length; i++) {
+        buffer[i] = alphabet[next_random(gen) % (sizeof(alphabet) - 1)];
+    }
+    buffer[used > length ? used : length] = '\0';
+}
+
+// Fill one marker and move the stream on; *burst_end is true for the last
+// marker of a burst (every marker, for the steady pattern)
+static void generate(struct generator *gen, struct timestamp_request *request, char *comment, char *name,
+                     bool *burst_end)
+{
+    const struct options *options = gen->options;
+
+    fill_text(gen, comment, MARKER_COMMENT_SIZE, options->comment_size, "Marker ");
+    fill_text(gen, name, MARKER_NAME_SIZE, options->name_size, "");
+
+    memset(request, 0, sizeof(*request));
+    request->has_timestamp = true;
+    request->timestamp_ms = gen->next_ns / 1000000;
+    request->comment = comment;
+    request->name = name;
+    request->color = colors[next_random(gen) % (sizeof(colors) / sizeof(colors[0]))];
+
+    gen->index++;
+    double mean_gap_ns = 1e9 / options->rate;
+
+    if (options->pattern == PATTERN_STEADY) {
+        *burst_end = true;
+        gen->next_ns += (uint64_t)mean_gap_ns;
+        return;
+    }
+
+    // Exponential gaps between bursts keep the average rate
+    *burst_end = gen->index % options->burst == 0;
+    if (*burst_end) {
+        double u = ((double)(next_random(gen) >> 11) + 1.0) / 9007199254740993.0;
+        gen->next_ns += (uint64_t)(-log(u) * mean_gap_ns * (double)options->burst);
+    } else {
+        gen->next_ns += LOADGEN_BURST_SPACING_MS * 1000000ULL;
+    }
+}
+
+// One size of one run
+struct run {
+    const struct options *options;
+    size_t markers;
+    char dir[400];
+    char video_path[512];
+    char log_path[512];
+};
+
+struct stage_result {
+    bool ok;
+    double wall_ms;
+    uint64_t output_bytes;
+    char note[128];
+};
+
+typedef void (*stage_func)(const struct run *run, const void *arg, struct stage_result *result);
+
+static double elapsed_ms(uint64_t start_ns)
+{
+    return (double)(os_gettime_ns() - start_ns) / 1e6;
+}
+
+static double rss_mb(const struct rusage *usage)
+{
+#ifdef __APPLE__
+    return (double)usage->ru_maxrss / (1024.0 * 1024.0);
+#else
+    return (double)usage->ru_maxrss / 1024.0;
+#endif
+}
+
+static void format_size(uint64_t bytes, char *buffer, size_t size)
+{
+    if (bytes >= 1024ULL * 1024ULL) {
+        snprintf(buffer, size, "%.1f MB", (double)bytes / (1024.0 * 1024.0));
+    } else {
+        snprintf(buffer, size, "%.1f KB", (double)bytes / 1024.0);
+    }
+}
+
+static void print_stage(const char *name, const struct stage_result *result, const struct rusage *usage)
+{
+    char output[32];
+    format_size(result->output_bytes, output, sizeof(output));
+
+    if (!result->ok) {
+        printf("  %-16s FAILED%s%s\n", name, result->note[0] ? "  " : "", result->note);
+        return;
+    }
+    printf("  %-16s %10.1f ms %9.1f MB %11s  %s\n", name, result->wall_ms, rss_mb(usage), output, result->note);
+}
+
+// Each stage runs in a child of its own, so its peak RSS is its own
+static void run_stage(const char *name, stage_func func, const struct run *run, const void *arg)
+{
+    struct stage_result result = {0};
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        return;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        func(run, arg, &result);
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == (ssize_t)sizeof(result) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+
+    struct rusage usage = {0};
+    int status = 0;
+    wait4(pid, &status, 0, &usage);
+    if (got != (ssize_t)sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        memset(&result, 0, sizeof(result));
+        snprintf(result.note, sizeof(result.note), "stage crashed");
+    }
+    print_stage(name, &result, &usage);
+}
+
+// An external command as a stage, such as the Python converter
+static void run_command(const char *name, char *const argv[], const char *output_path)
+{
+    struct stage_result result = {0};
+    uint64_t start_ns = os_gettime_ns();
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return;
+    }
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        if (null >= 0) {
+            dup2(null, STDOUT_FILENO);
+            close(null);
+        }
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+
+    struct rusage usage = {0};
+    int status = 0;
+    wait4(pid, &status, 0, &usage);
+    result.wall_ms = elapsed_ms(start_ns);
+    result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    int64_t size = os_get_file_size(output_path);
+    result.output_bytes = size > 0 ? (uint64_t)size : 0;
+    if (!result.ok) {
+        snprintf(result.note, sizeof(result.note), "exit status %d",
+                 WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    }
+    print_stage(name, &result, &usage);
+}
+
+// The session log of a run: the only one in its directory
+static bool find_session_log(const char *dir_path, char *buffer, size_t size)
+{
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        return false;
+    }
+
+    buffer[0] = '\0';
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        size_t len = strlen(entry->d_name);
+        if (len > 6 && strcmp(entry->d_name + len - 6, ".jsonl") == 0) {
+            snprintf(buffer, size, "%s/%s", dir_path, entry->d_name);
+        }
+    }
+    closedir(dir);
+    return buffer[0] != '\0';
+}
+
+// Stage: the session through the plugin, from recording start to the end
+// of the stop-time export
+static void replay_stage(const struct run *run, const void *arg, struct stage_result *result)
+{
+    UNUSED_PARAMETER(arg);
+    const struct options *options = run->options;
+
+    stub_config_clear();
+    stub_config_set("Output", "Mode", "Simple");
+    stub_config_set("SimpleOutput", "FilePath", run->dir);
+    stub_config_set("Video", "FPSType", "0");
+    stub_config_set("Video", "FPSCommon", "60");
+    stub_config_set("TimestampMarker", "ExportFormats", "premiere,edl,fcpxml,resolve");
+    stub_set_last_recording(run->video_path);
+
+    init_timestamp_plugin();
+    set_output_path(run->dir);
+    stub_frontend_event(OBS_FRONTEND_EVENT_FINISHED_LOADING);
+    stub_frontend_event(OBS_FRONTEND_EVENT_RECORDING_STARTED);
+    marker_writer_flush();
+
+    static struct timestamp_request requests[LOADGEN_MAX_BURST];
+    static char comments[LOADGEN_MAX_BURST][MARKER_COMMENT_SIZE];
+    static char names[LOADGEN_MAX_BURST][MARKER_NAME_SIZE];
+
+    struct generator gen;
+    generator_init(&gen, options);
+
+    uint64_t start_ns = os_gettime_ns();
+    size_t queued = 0, pushed = 0;
+    size_t pending = 0;
+
+    while (queued < run->markers) {
+        bool burst_end = false;
+        generate(&gen, &requests[pending], comments[pending], names[pending], &burst_end);
+        pending++;
+        queued++;
+
+        if (!burst_end && pending < LOADGEN_MAX_BURST && queued < run->markers) {
+            continue;
+        }
+
+        // Never more than half a queue in flight, so the replay loses
+        // nothing and measures the writer rather than the drop path
+        if (pushed + pending > MARKER_QUEUE_CAPACITY / 2) {
+            marker_writer_flush();
+            pushed = 0;
+        }
+        pushed += save_timestamps(requests, pending);
+        pending = 0;
+    }
+    marker_writer_flush();
+    double replay_ms = elapsed_ms(start_ns);
+    size_t stored = timestamp_marker_count();
+
+    uint64_t stop_ns = os_gettime_ns();
+    stub_frontend_event(OBS_FRONTEND_EVENT_RECORDING_STOPPED);
+    free_timestamp_plugin();
+    double stop_ms = elapsed_ms(stop_ns);
+
+    char log_path[512];
+    int64_t size = find_session_log(run->dir, log_path, sizeof(log_path)) ? os_get_file_size(log_path) : 0;
+    result->ok = stored == run->markers + 1;
+    result->wall_ms = replay_ms;
+    result->output_bytes = size > 0 ? (uint64_t)size : 0;
+    snprintf(result->note, sizeof(result->note), "%.0f markers/s, %zu stored, %" PRIu64 " dropped, stop+export %.1f ms",
+             replay_ms > 0 ? (double)run->markers * 1000.0 / replay_ms : 0.0, stored ? stored - 1 : 0,
+             marker_writer_dropped(), stop_ms);
+}
+
+// Stage: one exporter over the whole session, from a store built the way
+// the writer builds it
+static void export_stage(const struct run *run, const void *arg, struct stage_result *result)
+{
+    enum marker_export_format format = *(const enum marker_export_format *)arg;
+
+    struct marker_session_info info = {0};
+    snprintf(info.path, sizeof(info.path), "%s", run->log_path);
+    snprintf(info.recording_path, sizeof(info.recording_path), "%s", run->dir);
+    snprintf(info.video_path, sizeof(info.video_path), "%s", run->video_path);
+    snprintf(info.start_time, sizeof(info.start_time), "2024-05-01 20:15:00");
+    info.fps_num = 60;
+    info.fps_den = 1;
+    info.width = 1920;
+    info.height = 1080;
+    info.clock.fps_num = 60;
+    info.clock.fps_den = 1;
+
+    struct marker_store *store = marker_store_create();
+    struct generator gen;
+    generator_init(&gen, run->options);
+
+    for (size_t i = 0; i < run->markers; i++) {
+        struct timestamp_request request;
+        struct marker_record record = {0};
+        bool burst_end;
+        generate(&gen, &request, record.comment, record.name, &burst_end);
+
+        record.type = MARKER_RECORD_MARKER;
+        record.timestamp_ms = request.timestamp_ms;
+        record.timestamp_ns = request.timestamp_ms * 1000000ULL;
+        record.frame = recording_clock_frame(&info.clock, record.timestamp_ns);
+        record.count = 1;
+        snprintf(record.color, sizeof(record.color), "%s", request.color);
+        marker_store_add(store, &record);
+    }
+
+    uint64_t start_ns = os_gettime_ns();
+    uint32_t written = marker_export_run(&info, store, 1u << format);
+    result->wall_ms = elapsed_ms(start_ns);
+    result->ok = written == 1u << format;
+
+    char path[1024];
+    marker_export_output_path(&info, format, path, sizeof(path));
+    int64_t size = os_get_file_size(path);
+    result->output_bytes = size > 0 ? (uint64_t)size : 0;
+    snprintf(result->note, sizeof(result->note), "%.0f markers/s",
+             result->wall_ms > 0 ? (double)run->markers * 1000.0 / result->wall_ms : 0.0);
+
+    marker_store_destroy(store);
+}
+
+static const struct marker_exporter *exporters[MARKER_EXPORT_COUNT] = {
+    [MARKER_EXPORT_PREMIERE] = &premiere_exporter,
+    [MARKER_EXPORT_EDL] = &edl_exporter,
+    [MARKER_EXPORT_FCPXML] = &fcpxml_exporter,
+    [MARKER_EXPORT_RESOLVE_CSV] = &resolve_csv_exporter,
+};
+
+static void run_size(const struct options *options, size_t markers)
+{
+    struct run run = {0};
+    run.options = options;
+    run.markers = markers;
+    snprintf(run.dir, sizeof(run.dir), "%s/%zu", options->dir, markers);
+    os_mkdirs(run.dir);
+
+    // Stand-in for the file OBS would have recorded, so the exports find it
+    snprintf(run.video_path, sizeof(run.video_path), "%s/recording.mkv", run.dir);
+    FILE *video = fopen(run.video_path, "w");
+    if (video) {
+        fclose(video);
+    }
+
+    printf("%zu markers, %s", markers, options->pattern == PATTERN_STEADY ? "steady" : "bursty");
+    if (options->pattern == PATTERN_BURSTY) {
+        printf(" (%zu per burst)", options->burst);
+    }
+    printf(", %.1f markers/s of recording, %zu B comments, %zu B names\n", options->rate, options->comment_size,
+           options->name_size);
+    printf("  %-16s %13s %12s %11s\n", "stage", "wall", "peak RSS", "output");
+
+    run_stage("replay", replay_stage, &run, NULL);
+
+    if (!find_session_log(run.dir, run.log_path, sizeof(run.log_path))) {
+        printf("  no session log written, skipping the exporters\n\n");
+        return;
+    }
+
+    for (int i = 0; i < MARKER_EXPORT_COUNT; i++) {
+        enum marker_export_format format = (enum marker_export_format)i;
+        run_stage(exporters[i]->name, export_stage, &run, &format);
+    }
+
+    // The converter finds the recording through the log and writes its XML
+    // next to it, over the exporter's
+    if (options->converter) {
+        char xml_path[600];
+        snprintf(xml_path, sizeof(xml_path), "%s/recording_markers.xml", run.dir);
+
+        // Holding a whole session takes about 10 KB per marker in Python,
+        // so past converter_max only the streaming mode runs
+        if (markers <= options->converter_max) {
+            char *convert[] = {(char *)options->python, (char *)options->converter, run.log_path, NULL};
+            run_command("converter", convert, xml_path);
+        } else {
+            printf("  %-16s skipped, more than --converter-max %zu markers\n", "converter", options->converter_max);
+        }
+
+        char *stream[] = {(char *)options->python, (char *)options->converter, run.log_path, "--stream", NULL};
+        run_command("converter-stream", stream, xml_path);
+    }
+    printf("\n");
+}
+
+static bool parse_sizes(const char *list, struct options *options)
+{
+    options->size_count = 0;
+    while (*list && options->size_count < LOADGEN_MAX_SIZES) {
+        char *end;
+        unsigned long long value = strtoull(list, &end, 10);
+        if (end == list || value == 0) {
+            return false;
+        }
+        if (*end == 'k' || *end == 'K') {
+            value *= 1000;
+            end++;
+        } else if (*end == 'm' || *end == 'M') {
+            value *= 1000000;
+            end++;
+        }
+        options->sizes[options->size_count++] = (size_t)value;
+        list = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') {
+            return false;
+        }
+    }
+    return options->size_count > 0;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--dir DIR] [--sizes N,N,...] [--pattern steady|bursty] [--burst N] [--rate N]\n"
+            "       [--comment-size N] [--name-size N] [--seed N] [--python PATH] [--converter PATH]\n"
+            "       [--no-converter] [--converter-max N] [--verbose]\n",
+            argv0);
+    fprintf(stderr, "--sizes takes marker counts such as 1k,100k,1m (the default).\n");
+}
+
+int main(int argc, char **argv)
+{
+    struct options options = {0};
+    options.sizes[0] = 1000;
+    options.sizes[1] = 100000;
+    options.sizes[2] = 1000000;
+    options.size_count = 3;
+    options.pattern = PATTERN_BURSTY;
+    options.burst = 50;
+    options.rate = 5.0;
+    options.comment_size = 32;
+    options.name_size = 16;
+    options.seed = 1;
+    options.python = "python3";
+    options.converter = LOADGEN_CONVERTER;
+    options.converter_max = 100000;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(arg, "--dir") == 0 && has_value) {
+            options.dir = argv[++i];
+        } else if (strcmp(arg, "--sizes") == 0 && has_value) {
+            if (!parse_sizes(argv[++i], &options)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(arg, "--pattern") == 0 && has_value) {
+            const char *pattern = argv[++i];
+            if (strcmp(pattern, "steady") == 0) {
+                options.pattern = PATTERN_STEADY;
+            } else if (strcmp(pattern, "bursty") == 0) {
+                options.pattern = PATTERN_BURSTY;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(arg, "--burst") == 0 && has_value) {
+            options.burst = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--rate") == 0 && has_value) {
+            options.rate = strtod(argv[++i], NULL);
+        } else if (strcmp(arg, "--comment-size") == 0 && has_value) {
+            options.comment_size = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--name-size") == 0 && has_value) {
+            options.name_size = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--python") == 0 && has_value) {
+            options.python = argv[++i];
+        } else if (strcmp(arg, "--converter") == 0 && has_value) {
+            options.converter = argv[++i];
+        } else if (strcmp(arg, "--no-converter") == 0) {
+            options.converter = NULL;
+        } else if (strcmp(arg, "--converter-max") == 0 && has_value) {
+            options.converter_max = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--verbose") == 0) {
+            options.verbose = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.burst == 0) {
+        options.burst = 1;
+    }
+    if (options.burst > LOADGEN_MAX_BURST) {
+        options.burst = LOADGEN_MAX_BURST;
+    }
+    if (!(options.rate > 0.0)) {
+        options.rate = 5.0;
+    }
+
+    char temp_dir[] = "/tmp/timestamp-loadgen-XXXXXX";
+    if (!options.dir) {
+        if (!mkdtemp(temp_dir)) {
+            perror("mkdtemp");
+            return 1;
+        }
+        options.dir = temp_dir;
+    }
+
+    stub_set_log_level(options.verbose ? LOG_INFO : LOG_ERROR);
+    stub_set_config_dir(options.dir);
+    printf("Writing sessions to %s\n\n", options.dir);
+
+    for (size_t i = 0; i < options.size_count; i++) {
+        run_size(&options, options.sizes[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""
+OBS Timestamp Marker Listener
+
+Receives the live marker broadcast (see BroadcastAddress) and prints every
+marker with its press-to-delivery lag, as a starting point for replay and
+production tools that react to markers as they happen.
+"""
+
+import sys
+import json
+import time
+import socket
+import struct
+import argparse
+
+DEFAULT_ADDRESS = "239.255.77.77:41500"
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(description='Print markers broadcast by the OBS timestamp plugin')
+    parser.add_argument('address', nargs='?', default=DEFAULT_ADDRESS,
+                        help=f'Address the plugin broadcasts to, a.b.c.d:port (default: {DEFAULT_ADDRESS})')
+    parser.add_argument('--json', action='store_true',
+                        help='Print each datagram as received, one JSON object per line')
+    parser.add_argument('--sessions', type=int, default=0,
+                        help='Exit after this many sessions have ended (default: run until interrupted)')
+    return parser.parse_args()
+
+def open_socket(address):
+    """Bind to the port and join the group if the address is a multicast one."""
+    host, _, port = address.rpartition(':')
+    if not host:
+        host, port = port, '41500'
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    if hasattr(socket, 'SO_REUSEPORT'):
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+
+    group = socket.inet_aton(host)
+    if 224 <= group[0] <= 239:
+        sock.bind(('', int(port)))
+        membership = struct.pack('4s4s', group, socket.inet_aton('0.0.0.0'))
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    else:
+        sock.bind((host, int(port)))
+    return sock
+
+def main():
+    args = parse_arguments()
+    sock = open_socket(args.address)
+    print(f"Listening on {args.address}", file=sys.stderr)
+
+    lags = []
+    ended = 0
+    while True:
+        data, _ = sock.recvfrom(2048)
+        received_us = time.time_ns() // 1000
+
+        try:
+            message = json.loads(data)
+        except ValueError:
+            print(f"Warning: Ignoring malformed datagram ({len(data)} bytes)", file=sys.stderr)
+            continue
+
+        if args.json:
+            print(json.dumps(message), flush=True)
+
+        event = message.get('event')
+        if event == 'marker':
+            lag_us = received_us - message.get('pressed_us', received_us)
+            lags.append(lag_us)
+            if not args.json:
+                count = message.get('count', 1)
+                print(f"{message['timestamp_ms'] / 1000:10.3f}s  frame {message['frame']:<8} "
+                      f"{message['comment']}{f' [{count}x]' if count > 1 else ''}  "
+                      f"lag {lag_us}us (in OBS {message.get('latency_us', 0)}us)", flush=True)
+        elif event in ('begin', 'end') and not args.json:
+            print(f"-- session {message.get('session', '')} {event}", flush=True)
+
+        if event == 'end':
+            if lags:
+                lags.sort()
+                p50 = lags[len(lags) // 2]
+                p99 = lags[min(len(lags) - 1, int(len(lags) * 0.99))]
+                print(f"-- {len(lags)} marker(s), lag p50 {p50}us, p99 {p99}us, max {lags[-1]}us",
+                      file=sys.stderr)
+            lags = []
+            ended += 1
+            if args.sessions and ended >= args.sessions:
+                return 0
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except KeyboardInterrupt:
+        sys.exit(0)
@@ -2,15 +2,25 @@
 """
 OBS Timestamp to Premiere Pro XML Converter
 
-Converts OBS timestamp markers (JSON Lines format) to Premiere Pro marker XML format.
+Converts OBS timestamp markers (JSON Lines format, or the plugin's binary
+.tsmj journal) to Premiere Pro marker XML format.
 """
 
+import io
 import os
 import sys
+import glob
 import json
+import time
+import mmap
+import struct
+import zlib
 import argparse
+import bisect
 import xml.etree.ElementTree as ET
 from xml.dom import minidom
+from contextlib import redirect_stdout
+from multiprocessing import Pool
 from datetime import datetime
 
 # Premiere Pro color codes (32-bit ARGB values)
@@ -25,6 +35,16 @@ COLOR_MAP = {
     "orange": "4294924800",
 }
 
+# Binary marker journal layout (see src/marker-journal.h)
+JOURNAL_MAGIC = b"OBSTSMJ1"
+JOURNAL_VERSION = 2
+JOURNAL_FINALIZED = 0x1
+JOURNAL_HEADER_V1 = struct.Struct('<8sIIIIIIqQQQQ64s512s')
+JOURNAL_HEADER = struct.Struct('<8sIIIIIIqQQQQ64s512sQQ')
+JOURNAL_RECORD = struct.Struct('<QQIIII')
+JOURNAL_DRIFT = struct.Struct('<Qq')
+JOURNAL_COLORS = ["blue", "cyan", "green", "yellow", "red", "magenta", "purple", "orange"]
+
 def parse_arguments():
     """Parse command line arguments."""
     parser = argparse.ArgumentParser(
@@ -36,11 +56,19 @@ Examples:
   %(prog)s timestamps.jsonl markers.xml              # Manual output filename
   %(prog)s timestamps.jsonl --fps 60                 # Override FPS (auto-detected from metadata)
   %(prog)s timestamps.jsonl --sequence-name "My Recording"
+  %(prog)s timestamps.tsmj                           # Binary journal
+  %(prog)s timestamps.tsmj --dump-jsonl out.jsonl    # Convert a journal to JSON Lines
+  %(prog)s timestamps.jsonl --stream                 # Constant memory, for huge sessions
+  %(prog)s timestamps.jsonl --start-ms 3600000 --end-ms 7200000  # Second hour only
+  %(prog)s --batch archive/                          # Convert every session under a directory
+  %(prog)s --batch "archive/*.tsmj" out/ --jobs 4    # Glob, into one output directory
         """
     )
-    parser.add_argument('input', help='Input timestamp file (JSON Lines format)')
+    parser.add_argument('input', help='Input timestamp file (JSON Lines format or .tsmj journal), '
+                        'or with --batch a directory or glob of them')
     parser.add_argument('output', nargs='?', default=None,
-                        help='Output XML file for Premiere Pro (optional, auto-detected from metadata)')
+                        help='Output XML file for Premiere Pro (optional, auto-detected from metadata); '
+                        'with --batch an output directory')
     parser.add_argument('--fps', type=float, default=60,
                         help='Frames per second (default: 60, or auto-detected from metadata)')
     parser.add_argument('--sequence-name', default=None,
@@ -49,9 +77,319 @@ Examples:
                         help='Video width (default: 1920)')
     parser.add_argument('--height', type=int, default=1080,
                         help='Video height (default: 1080)')
+    parser.add_argument('--stream', action='store_true',
+                        help='Stream the XML to disk without loading all markers (for very long sessions)')
+    parser.add_argument('--indent', action='store_true',
+                        help='With --stream: indent the XML like the default writer (larger file)')
+    parser.add_argument('--start-ms', type=int, default=None,
+                        help='Only markers at or after this time in the log (reads through the .tsidx index)')
+    parser.add_argument('--end-ms', type=int, default=None,
+                        help='Only markers at or before this time in the log')
+    parser.add_argument('--dump-jsonl', metavar='FILE', default=None,
+                        help='Write the parsed markers to FILE as JSON Lines and exit')
+    parser.add_argument('--batch', action='store_true',
+                        help='Convert every session file in a directory (searched recursively) or glob')
+    parser.add_argument('--jobs', type=int, default=None,
+                        help='With --batch: number of worker processes (default: CPU count)')
+    parser.add_argument('--force', action='store_true',
+                        help='With --batch: convert sessions whose XML is already up to date')
     return parser.parse_args()
 
-def parse_timestamps(file_path):
+def c_string(raw):
+    """Decode a fixed-size NUL-padded field."""
+    return raw.split(b'\0', 1)[0].decode('utf-8', errors='replace')
+
+class JournalError(Exception):
+    """The file is not a usable marker journal."""
+
+def int_div(value, divisor):
+    """Integer division rounding toward zero, as the plugin's C code does."""
+    quotient = abs(value) // divisor
+    return quotient if value >= 0 else -quotient
+
+def in_range(timestamp_ms, time_range):
+    """Whether a marker time lies in an inclusive (start_ms, end_ms) range; None is everything."""
+    return time_range is None or time_range[0] <= timestamp_ms <= time_range[1]
+
+def iter_journal(file_path, quiet=False, time_range=None):
+    """
+    Yield the same ('metadata', dict) / ('marker', dict) entries as iter_jsonl
+    from a binary marker journal, reading records straight from the mapping.
+    """
+    with open(file_path, 'rb') as f:
+        with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as data:
+            if len(data) < JOURNAL_HEADER_V1.size:
+                raise JournalError(f"'{file_path}' is too short to be a marker journal")
+
+            (magic, version, header_size, record_size, flags, fps_num, fps_den, start_epoch,
+             record_count, records_offset, strings_offset, strings_size,
+             start_time, recording_path) = JOURNAL_HEADER_V1.unpack_from(data, 0)
+
+            # Version 2 adds the clock drift table after the strings
+            drift_offset = drift_count = 0
+            if version >= 2 and len(data) >= JOURNAL_HEADER.size:
+                drift_offset, drift_count = JOURNAL_HEADER.unpack_from(data, 0)[-2:]
+
+            if (magic != JOURNAL_MAGIC or not 1 <= version <= JOURNAL_VERSION or
+                    (version >= 2 and len(data) < JOURNAL_HEADER.size) or
+                    record_size != JOURNAL_RECORD.size or records_offset > len(data)):
+                raise JournalError(f"'{file_path}' is not a valid marker journal")
+
+            available = (len(data) - records_offset) // record_size
+            strings_end = strings_offset
+            if flags & JOURNAL_FINALIZED:
+                record_count = min(record_count, available)
+                strings_end = min(strings_offset + strings_size, len(data))
+                drift_count = min(drift_count, max(0, len(data) - drift_offset) // JOURNAL_DRIFT.size)
+            else:
+                # Never closed: records are there, the string table is not
+                if not quiet:
+                    print("Warning: Journal was not finalized, comments and names are unavailable")
+                record_count = available
+                drift_count = 0
+
+            def lookup(offset):
+                start = strings_offset + offset
+                if start >= strings_end:
+                    return ''
+                end = data.find(b'\0', start, strings_end)
+                return data[start:end if end >= 0 else strings_end].decode('utf-8', errors='replace')
+
+            yield 'metadata', {
+                'recording_path': c_string(recording_path),
+                'timestamp': c_string(start_time),
+                'fps_num': fps_num,
+                'fps_den': fps_den,
+            }
+
+            for i in range(record_count):
+                timestamp_ns, frame, comment, name, color, count = \
+                    JOURNAL_RECORD.unpack_from(data, records_offset + i * record_size)
+                if not in_range(timestamp_ns // 1000000, time_range):
+                    continue
+                marker = {
+                    'timestamp_ms': timestamp_ns // 1000000,
+                    'frame': frame,
+                    'comment': lookup(comment),
+                    'name': lookup(name),
+                    'color': JOURNAL_COLORS[color] if color < len(JOURNAL_COLORS) else 'blue',
+                }
+                # Coalesced hotkey presses, as in the JSONL log
+                if count > 1:
+                    marker['count'] = count
+                yield 'marker', marker
+
+            # The drift table follows the markers, in the JSONL log's [ms, us] units
+            if drift_count:
+                yield 'metadata', {'drift': [
+                    [timestamp_ns // 1000000, int_div(drift_ns, 1000)]
+                    for timestamp_ns, drift_ns in JOURNAL_DRIFT.iter_unpack(
+                        data[drift_offset:drift_offset + drift_count * JOURNAL_DRIFT.size])]}
+
+def parse_journal(file_path, time_range=None):
+    """
+    Parse a binary marker journal written by the plugin.
+
+    Returns the same (metadata_dict, timestamps_list) tuple as parse_timestamps.
+    """
+    timestamps = []
+    metadata = {}
+    drift = []
+
+    try:
+        for kind, data in iter_journal(file_path, time_range=time_range):
+            if kind == 'metadata':
+                if 'drift' in data:
+                    drift.extend(data['drift'])
+                    continue
+                metadata.update(data)
+                print(f"Found metadata: recording_path={metadata['recording_path']}")
+            else:
+                timestamps.append(data)
+
+    except FileNotFoundError:
+        print(f"Error: Input file '{file_path}' not found")
+        return None, None
+    except JournalError as e:
+        print(f"Error: {e}")
+        return None, None
+    except Exception as e:
+        print(f"Error reading journal: {e}")
+        return None, None
+
+    if len(drift) > 1:
+        apply_drift(timestamps, drift, metadata)
+    return metadata, timestamps
+
+def is_journal(file_path):
+    """Check the file's magic rather than trusting its extension."""
+    try:
+        with open(file_path, 'rb') as f:
+            return f.read(len(JOURNAL_MAGIC)) == JOURNAL_MAGIC
+    except OSError:
+        return False
+
+def write_jsonl(metadata, timestamps, output_path):
+    """Write markers in the plugin's JSON Lines format."""
+    with open(output_path, 'w', encoding='utf-8') as f:
+        if metadata:
+            f.write(json.dumps({'metadata': metadata}) + '\n')
+        for ts in timestamps:
+            f.write(json.dumps({
+                'timestamp_ms': ts['timestamp_ms'],
+                'frame': ts.get('frame', 0),
+                'comment': ts['comment'],
+                'name': ts['name'],
+                'color': ts['color'],
+            }) + '\n')
+
+CRC_FIELD = b', "crc": "'
+
+def line_intact(raw):
+    """
+    Whether a session log line matches its "crc" field, the CRC-32 of the
+    bytes in front of it. Lines without one (older logs) are taken as they are.
+    """
+    index = raw.rfind(CRC_FIELD)
+    if index < 0:
+        return True
+    try:
+        return zlib.crc32(raw[:index]) == int(raw[index + len(CRC_FIELD):index + len(CRC_FIELD) + 8], 16)
+    except ValueError:
+        return False
+
+def load_index(log_path):
+    """
+    Blocks of the sparse index the plugin writes next to a closed log
+    ("<session>.tsidx", see src/session-index.h) as (offset, length, first_ms,
+    last_ms) tuples, or None if there is no usable index for this log.
+    """
+    index_path = os.path.splitext(log_path)[0] + '.tsidx'
+    try:
+        with open(index_path, 'rb') as f:
+            lines = [raw.strip() for raw in f if raw.strip()]
+        log_size = os.path.getsize(log_path)
+    except OSError:
+        return None
+
+    # Written whole and renamed into place, so any bad line means it isn't one of ours
+    try:
+        if not lines or not all(line_intact(raw) for raw in lines):
+            return None
+        header = json.loads(lines[0].decode('utf-8'))['metadata']
+        if header.get('log') != os.path.basename(log_path) or header.get('blocks') != len(lines) - 1:
+            return None
+        blocks = []
+        for raw in lines[1:]:
+            block = json.loads(raw.decode('utf-8'))
+            blocks.append((int(block['offset']), int(block['length']),
+                           int(block['first_ms']), int(block['last_ms'])))
+    except (ValueError, KeyError, TypeError):
+        return None
+
+    if not blocks or blocks[-1][0] + blocks[-1][1] > log_size:
+        return None
+    return blocks
+
+def index_spans(blocks, time_range, log_size):
+    """
+    Byte ranges of the log to read for the markers in time_range: the
+    metadata before the first block, every block that overlaps the range
+    (neighbours merged) and the metadata after the last one.
+    """
+    spans = [(0, blocks[0][0])]
+    for offset, length, first_ms, last_ms in blocks:
+        if last_ms < time_range[0] or first_ms > time_range[1]:
+            continue
+        if spans[-1][1] == offset:
+            spans[-1] = (spans[-1][0], offset + length)
+        else:
+            spans.append((offset, offset + length))
+    end = blocks[-1][0] + blocks[-1][1]
+    if spans[-1][1] == end:
+        spans[-1] = (spans[-1][0], log_size)
+    else:
+        spans.append((end, log_size))
+    return spans
+
+def log_lines(f, file_path, time_range):
+    """
+    (where, raw line) pairs of a log. With a time range and an index, only the
+    blocks that can hold markers in the range are read, seeking past the rest.
+    """
+    blocks = load_index(file_path) if time_range is not None else None
+    if blocks is None:
+        for line_num, raw in enumerate(f, 1):
+            yield f"Line {line_num}", raw
+        return
+
+    for start, end in index_spans(blocks, time_range, os.path.getsize(file_path)):
+        f.seek(start)
+        position = start
+        for raw in io.BytesIO(f.read(end - start)):
+            yield f"Line at byte {position}", raw
+            position += len(raw)
+
+def iter_jsonl(file_path, quiet=False, time_range=None):
+    """
+    Yield ('metadata', dict) and ('marker', dict) entries from a JSON Lines file
+    one line at a time. Bad lines are reported (unless quiet) and skipped.
+    Markers outside time_range (inclusive, in ms) are left out.
+    """
+    with open(file_path, 'rb') as f:
+        for where, raw in log_lines(f, file_path, time_range):
+            raw = raw.strip()
+            if not raw:
+                continue
+
+            if not line_intact(raw):
+                if not quiet:
+                    print(f"Warning: {where} does not match its checksum, skipping")
+                continue
+
+            try:
+                data = json.loads(raw.decode('utf-8'))
+
+                # Check if this is a metadata line (first line, and video_path after the markers)
+                if 'metadata' in data:
+                    yield 'metadata', data['metadata']
+                    continue
+
+                # Validate required fields for timestamp entries
+                if 'timestamp_ms' not in data:
+                    if not quiet:
+                        print(f"Warning: {where} missing 'timestamp_ms' field, skipping")
+                    continue
+
+                if not in_range(int(data['timestamp_ms']), time_range):
+                    continue
+
+                # Extract fields with defaults
+                timestamp = {
+                    'timestamp_ms': int(data['timestamp_ms']),
+                    'comment': data.get('comment', ''),
+                    'name': data.get('name', ''),
+                    'color': data.get('color', 'blue')
+                }
+
+                # Exact frame index recorded by the plugin (newer logs only)
+                if 'frame' in data:
+                    timestamp['frame'] = int(data['frame'])
+                if int(data.get('count', 1)) > 1:
+                    timestamp['count'] = int(data['count'])
+
+                yield 'marker', timestamp
+
+            except json.JSONDecodeError as e:
+                if not quiet:
+                    print(f"Warning: {where} is not valid JSON: {e}")
+                continue
+            except (ValueError, TypeError) as e:
+                if not quiet:
+                    print(f"Warning: {where} has invalid data: {e}")
+                continue
+
+def parse_timestamps(file_path, time_range=None):
     """
     Parse timestamps from JSON Lines file.
 
@@ -59,47 +397,25 @@ def parse_timestamps(file_path):
         Tuple of (metadata_dict, timestamps_list)
         metadata_dict contains recording_path, timestamp, fps info
         timestamps_list contains dicts with keys: timestamp_ms, comment, name, color
+        (and frame, when the plugin recorded an exact frame index)
     """
     timestamps = []
     metadata = {}
+    drift = []
 
     try:
-        with open(file_path, 'r', encoding='utf-8') as f:
-            for line_num, line in enumerate(f, 1):
-                line = line.strip()
-                if not line:
-                    continue
-
-                try:
-                    data = json.loads(line)
-
-                    # Check if this is the metadata line (first line)
-                    if 'metadata' in data:
-                        metadata = data['metadata']
-                        print(f"Found metadata: recording_path={metadata.get('recording_path', 'N/A')}")
-                        continue
-
-                    # Validate required fields for timestamp entries
-                    if 'timestamp_ms' not in data:
-                        print(f"Warning: Line {line_num} missing 'timestamp_ms' field, skipping")
-                        continue
-
-                    # Extract fields with defaults
-                    timestamp = {
-                        'timestamp_ms': int(data['timestamp_ms']),
-                        'comment': data.get('comment', ''),
-                        'name': data.get('name', ''),
-                        'color': data.get('color', 'blue')
-                    }
-
-                    timestamps.append(timestamp)
-
-                except json.JSONDecodeError as e:
-                    print(f"Warning: Line {line_num} is not valid JSON: {e}")
-                    continue
-                except (ValueError, TypeError) as e:
-                    print(f"Warning: Line {line_num} has invalid data: {e}")
+        for kind, data in iter_jsonl(file_path, time_range=time_range):
+            if kind == 'metadata':
+                # The clock drift table may span several lines
+                if 'drift' in data:
+                    drift.extend(data['drift'])
                     continue
+                # The plugin adds video_path in a second metadata line at stop
+                metadata.update(data)
+                if 'recording_path' in data:
+                    print(f"Found metadata: recording_path={metadata['recording_path']}")
+            else:
+                timestamps.append(data)
 
     except FileNotFoundError:
         print(f"Error: Input file '{file_path}' not found")
@@ -108,45 +424,67 @@ def parse_timestamps(file_path):
         print(f"Error reading file: {e}")
         return None, None
 
+    if len(drift) > 1:
+        apply_drift(timestamps, drift, metadata)
     return metadata, timestamps
 
+def drift_at(points, timestamp_ms):
+    """Drift in microseconds at timestamp_ms, interpolated in the plugin's [ms, us] table."""
+    i = bisect.bisect_right([p[0] for p in points], timestamp_ms)
+    if i == 0:
+        return points[0][1]
+    if i == len(points):
+        return points[-1][1]
+    (t0, d0), (t1, d1) = points[i - 1], points[i]
+    return d0 + (d1 - d0) * (timestamp_ms - t0) / (t1 - t0) if t1 > t0 else d1
+
+def correct_drift(ts, points, fps):
+    """Move one marker from clock time to media time, like the plugin's own exports."""
+    timestamp_ms = ts['timestamp_ms']
+    media_ms = max(0, int(round(timestamp_ms - drift_at(points, timestamp_ms) / 1000.0)))
+    if 'frame' in ts:
+        shift = ms_to_frames(timestamp_ms, fps) - ms_to_frames(media_ms, fps)
+        ts['frame'] = max(0, ts['frame'] - shift)
+    ts['timestamp_ms'] = media_ms
+
+def apply_drift(timestamps, points, metadata):
+    """Correct every marker of a log for the clock drift table it ends with."""
+    fps = metadata_fps(metadata, 60)
+    for ts in timestamps:
+        correct_drift(ts, points, fps)
+    print(f"Corrected for clock drift of up to {max(abs(p[1]) for p in points) / 1000.0:.1f} ms")
+
 def ms_to_frames(milliseconds, fps):
     """Convert milliseconds to frame number."""
     return int((milliseconds / 1000.0) * fps)
 
+def marker_frame(timestamp, fps):
+    """Frame of a marker: the exact index when the log has one, else derived from ms."""
+    if 'frame' in timestamp:
+        return timestamp['frame']
+    return ms_to_frames(timestamp['timestamp_ms'], fps)
+
 def get_color_code(color_name):
     """Get Premiere Pro color code from color name."""
     return COLOR_MAP.get(color_name.lower(), COLOR_MAP["blue"])
 
-def find_latest_video_file(recording_dir, metadata_timestamp):
-    """
-    Find the most recent video file in the recording directory.
+# Common video extensions
+VIDEO_EXTENSIONS = ('.mp4', '.mkv', '.flv', '.mov', '.avi', '.ts')
 
-    Args:
-        recording_dir: Path to the recording directory
-        metadata_timestamp: Timestamp string from metadata (format: "YYYY-MM-DD HH:MM:SS")
+def scan_video_files(recording_dir):
+    """
+    List the video files in a recording directory, newest first.
 
-    Returns:
-        Path to the most recent video file, or None if not found
+    Returns a list of (path, mtime) tuples, or None if the directory can't be read.
     """
     if not recording_dir or not os.path.exists(recording_dir):
         return None
 
-    # Common video extensions
-    video_extensions = ('.mp4', '.mkv', '.flv', '.mov', '.avi', '.ts')
-
-    # Parse the metadata timestamp
-    try:
-        from datetime import datetime
-        metadata_time = datetime.strptime(metadata_timestamp, "%Y-%m-%d %H:%M:%S")
-    except:
-        metadata_time = None
-
     # Find all video files
     video_files = []
     try:
         for filename in os.listdir(recording_dir):
-            if filename.lower().endswith(video_extensions):
+            if filename.lower().endswith(VIDEO_EXTENSIONS):
                 filepath = os.path.join(recording_dir, filename)
                 # Get file modification time
                 mtime = os.path.getmtime(filepath)
@@ -155,11 +493,30 @@ def find_latest_video_file(recording_dir, metadata_timestamp):
         print(f"Error scanning directory: {e}")
         return None
 
+    # Sort by modification time (newest first)
+    video_files.sort(key=lambda x: x[1], reverse=True)
+    return video_files
+
+def pick_video_file(video_files, metadata_timestamp, allow_newest=True):
+    """
+    Pick the video that belongs to a session from a scan_video_files() list.
+
+    Args:
+        video_files: (path, mtime) list, newest first
+        metadata_timestamp: Timestamp string from metadata (format: "YYYY-MM-DD HH:MM:SS")
+        allow_newest: Fall back to the newest video when none matches the time
+
+    Returns:
+        Path to the video file, or None if not found
+    """
     if not video_files:
         return None
 
-    # Sort by modification time (newest first)
-    video_files.sort(key=lambda x: x[1], reverse=True)
+    # Parse the metadata timestamp
+    try:
+        metadata_time = datetime.strptime(metadata_timestamp, "%Y-%m-%d %H:%M:%S")
+    except (TypeError, ValueError):
+        metadata_time = None
 
     # If we have a metadata timestamp, find the file closest to that time
     if metadata_time:
@@ -171,7 +528,68 @@ def find_latest_video_file(recording_dir, metadata_timestamp):
                 return filepath
 
     # Otherwise return the most recent file
-    return video_files[0][0]
+    return video_files[0][0] if allow_newest else None
+
+def find_latest_video_file(recording_dir, metadata_timestamp):
+    """
+    Find the most recent video file in the recording directory.
+
+    Args:
+        recording_dir: Path to the recording directory
+        metadata_timestamp: Timestamp string from metadata (format: "YYYY-MM-DD HH:MM:SS")
+
+    Returns:
+        Path to the most recent video file, or None if not found
+    """
+    return pick_video_file(scan_video_files(recording_dir), metadata_timestamp)
+
+# Session index the plugin keeps next to the session logs (see src/session-manifest.h)
+SESSION_MANIFEST_NAME = 'sessions.manifest'
+
+def load_manifest_videos(session_dir):
+    """
+    Map session file names to the video recorded for them, from the
+    sessions.manifest in session_dir. Returns {} if there is no manifest.
+    """
+    videos = {}
+    manifest_path = os.path.join(session_dir, SESSION_MANIFEST_NAME)
+    try:
+        with open(manifest_path, 'r', encoding='utf-8') as f:
+            for line in f:
+                try:
+                    entry = json.loads(line)
+                except json.JSONDecodeError:
+                    continue  # a partial line from a crash
+                if entry.get('video'):
+                    # The end entry comes last and has the final path
+                    videos[entry.get('session')] = entry['video']
+    except OSError:
+        pass
+    return videos
+
+def session_log_name(file_path):
+    """Manifest key of a session file (journals are listed under their .jsonl name)."""
+    return os.path.splitext(os.path.basename(file_path))[0] + '.jsonl'
+
+def recorded_video_file(file_path, metadata, manifest_videos=None):
+    """
+    The video the plugin recorded the session's path for: video_path from the
+    metadata, else the manifest entry. None if neither exists on disk, in which
+    case the caller falls back to scanning recording_path.
+    """
+    candidates = []
+    if metadata and metadata.get('video_path'):
+        candidates.append(metadata['video_path'])
+
+    if manifest_videos is None:
+        manifest_videos = load_manifest_videos(os.path.dirname(os.path.abspath(file_path)))
+    if manifest_videos.get(session_log_name(file_path)):
+        candidates.append(manifest_videos[session_log_name(file_path)])
+
+    for candidate in candidates:
+        if os.path.isfile(candidate):
+            return candidate
+    return None
 
 def create_premiere_xml(timestamps, output_path, fps=60, sequence_name=None, width=1920, height=1080):
     """
@@ -198,8 +616,8 @@ def create_premiere_xml(timestamps, output_path, fps=60, sequence_name=None, wid
         sequence_name = f"OBS Markers ({datetime.now().strftime('%Y-%m-%d %H:%M')})"
 
     # Calculate duration (last marker + 60 seconds buffer)
-    max_timestamp_ms = max(t['timestamp_ms'] for t in timestamps)
-    duration = ms_to_frames(max_timestamp_ms + 60000, fps)
+    max_frame = max(marker_frame(t, fps) for t in timestamps)
+    duration = max_frame + ms_to_frames(60000, fps)
 
     # Create root element with DOCTYPE
     root = ET.Element('xmeml', version="4")
@@ -303,7 +721,7 @@ def create_premiere_xml(timestamps, output_path, fps=60, sequence_name=None, wid
 
     # Add markers to generator item
     for ts in timestamps:
-        frame = ms_to_frames(ts['timestamp_ms'], fps)
+        frame = marker_frame(ts, fps)
         color_code = get_color_code(ts['color'])
 
         marker = ET.SubElement(gen_item, 'marker')
@@ -340,7 +758,7 @@ def create_premiere_xml(timestamps, output_path, fps=60, sequence_name=None, wid
 
     # Add markers at sequence level too (for better compatibility)
     for ts in timestamps:
-        frame = ms_to_frames(ts['timestamp_ms'], fps)
+        frame = marker_frame(ts, fps)
         color_code = get_color_code(ts['color'])
 
         marker = ET.SubElement(sequence, 'marker')
@@ -368,29 +786,253 @@ def create_premiere_xml(timestamps, output_path, fps=60, sequence_name=None, wid
         print(f"Error writing XML file: {e}")
         return False
 
-def main():
-    """Main entry point."""
-    args = parse_arguments()
+def iter_records(file_path, quiet=False, time_range=None):
+    """Iterate a timestamp log, JSON Lines or binary journal."""
+    if is_journal(file_path):
+        return iter_journal(file_path, quiet, time_range)
+    return iter_jsonl(file_path, quiet, time_range)
 
-    print(f"OBS Timestamp to Premiere Pro XML Converter")
-    print(f"=" * 50)
-    print(f"Input file:  {args.input}")
-    print()
+def scan_timestamps(file_path, time_range=None):
+    """
+    One pass over the log without keeping the markers.
 
-    # Parse timestamps
-    print("Parsing timestamps...")
-    metadata, timestamps = parse_timestamps(args.input)
+    Returns (metadata, count, max_frame, max_ms_without_frame), or None on error.
+    The last two let the caller work out the duration once the FPS is known.
+    """
+    metadata = {}
+    count = 0
+    max_frame = None
+    max_ms = None
 
-    if timestamps is None:
-        return 1
+    try:
+        for kind, data in iter_records(file_path, time_range=time_range):
+            if kind == 'metadata':
+                # The clock drift table may span several lines
+                if 'drift' in data:
+                    metadata.setdefault('drift', []).extend(data['drift'])
+                    continue
+                # The plugin adds video_path in a second metadata line at stop
+                metadata.update(data)
+                if 'recording_path' in data:
+                    print(f"Found metadata: recording_path={metadata['recording_path']}")
+                continue
+
+            count += 1
+            if 'frame' in data:
+                max_frame = data['frame'] if max_frame is None else max(max_frame, data['frame'])
+            else:
+                max_ms = data['timestamp_ms'] if max_ms is None else max(max_ms, data['timestamp_ms'])
 
-    if not timestamps:
-        print("No valid timestamps found in the input file")
-        return 1
+    except FileNotFoundError:
+        print(f"Error: Input file '{file_path}' not found")
+        return None
+    except JournalError as e:
+        print(f"Error: {e}")
+        return None
+    except Exception as e:
+        print(f"Error reading file: {e}")
+        return None
 
-    print(f"Found {len(timestamps)} timestamp(s)")
-    print()
+    return metadata, count, max_frame, max_ms
+
+def xml_escape(text):
+    """Escape text the way minidom does, so both writers produce the same bytes."""
+    return (str(text).replace('&', '&amp;').replace('<', '&lt;')
+            .replace('"', '&quot;').replace('>', '&gt;'))
+
+class XmlStream:
+    """Write XML elements straight to a file, optionally indented like toprettyxml."""
+
+    def __init__(self, f, indent=False):
+        self.f = f
+        self.indent = indent
+        self.depth = 0
+
+    def _line(self, content):
+        if self.indent:
+            self.f.write('  ' * self.depth + content + '\n')
+        else:
+            self.f.write(content)
+
+    def open(self, tag, attrs=None):
+        attr_text = ''.join(f' {k}="{xml_escape(v)}"' for k, v in (attrs or {}).items())
+        self._line(f'<{tag}{attr_text}>')
+        self.depth += 1
+
+    def close(self, tag):
+        self.depth -= 1
+        self._line(f'</{tag}>')
 
+    def text(self, tag, value):
+        value = '' if value is None else str(value)
+        if value:
+            self._line(f'<{tag}>{xml_escape(value)}</{tag}>')
+        else:
+            self._line(f'<{tag}/>')
+
+def stream_markers(xml, input_path, fps, drift=None, time_range=None):
+    """Write every marker of the log, reading it again from disk."""
+    for kind, ts in iter_records(input_path, quiet=True, time_range=time_range):
+        if kind != 'marker':
+            continue
+        if drift and len(drift) > 1:
+            correct_drift(ts, drift, fps)
+        xml.open('marker')
+        xml.text('comment', ts['comment'])
+        xml.text('name', ts['name'])
+        xml.text('in', marker_frame(ts, fps))
+        xml.text('out', '-1')
+        xml.text('pproColor', get_color_code(ts['color']))
+        xml.close('marker')
+
+def write_rate(xml, timebase, ntsc):
+    xml.open('rate')
+    xml.text('timebase', timebase)
+    xml.text('ntsc', 'TRUE' if ntsc else 'FALSE')
+    xml.close('rate')
+
+def stream_premiere_xml(input_path, output_path, duration, fps=60, sequence_name=None,
+                        width=1920, height=1080, indent=False, drift=None, time_range=None):
+    """
+    Write the same document as create_premiere_xml in a single pass over the
+    output, re-reading the markers from input_path for each of the two marker
+    lists. Memory use does not depend on the number of markers.
+
+    Args:
+        input_path: Timestamp log (JSON Lines or journal)
+        output_path: Path to save XML file
+        duration: Sequence duration in frames
+        indent: Pretty-print with two-space indentation
+        time_range: Only the markers in this (start_ms, end_ms) range
+    """
+    # Determine if NTSC framerate
+    ntsc = fps in [23.976, 29.97, 59.94]
+    timebase = int(fps) if not ntsc else int(fps * 1.001)
+
+    # Default sequence name
+    if not sequence_name:
+        sequence_name = f"OBS Markers ({datetime.now().strftime('%Y-%m-%d %H:%M')})"
+
+    try:
+        with open(output_path, 'w', encoding='utf-8') as f:
+            f.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+            f.write('<!DOCTYPE xmeml>\n')
+
+            xml = XmlStream(f, indent)
+            xml.open('xmeml', {'version': '4'})
+            xml.open('sequence', {'id': 'sequence', 'explodedTracks': 'true'})
+            xml.text('uuid', 'obs-timestamp-markers-sequence')
+            xml.text('duration', duration)
+            write_rate(xml, timebase, ntsc)
+            xml.text('name', sequence_name)
+
+            xml.open('media')
+            xml.open('video')
+            xml.open('format')
+            xml.open('samplecharacteristics')
+            write_rate(xml, timebase, ntsc)
+            xml.open('codec')
+            xml.text('name', 'Apple ProRes 422')
+            xml.close('codec')
+            xml.text('width', width)
+            xml.text('height', height)
+            xml.text('anamorphic', 'FALSE')
+            xml.text('pixelaspectratio', 'square')
+            xml.text('fielddominance', 'none')
+            xml.text('colordepth', '24')
+            xml.close('samplecharacteristics')
+            xml.close('format')
+
+            xml.open('track')
+            xml.text('enabled', 'TRUE')
+            xml.text('locked', 'FALSE')
+
+            # Generator item (invisible color matte that holds the markers)
+            xml.open('generatoritem', {'id': 'clipitem-1'})
+            xml.text('name', 'OBS Marker Holder')
+            xml.text('enabled', 'TRUE')
+            xml.text('duration', duration)
+            write_rate(xml, timebase, ntsc)
+            xml.text('start', '0')
+            xml.text('end', duration)
+            xml.text('in', '0')
+            xml.text('out', duration)
+            xml.text('alphatype', 'none')
+
+            xml.open('effect')
+            xml.text('name', 'Color')
+            xml.text('effectid', 'Color')
+            xml.text('effectcategory', 'Matte')
+            xml.text('effecttype', 'generator')
+            xml.text('mediatype', 'video')
+            xml.open('parameter', {'authoringApp': 'PremierePro'})
+            xml.text('parameterid', 'fillcolor')
+            xml.text('name', 'Color')
+            xml.open('value')
+            for channel in ('alpha', 'red', 'green', 'blue'):
+                xml.text(channel, '0')
+            xml.close('value')
+            xml.close('parameter')
+            xml.close('effect')
+
+            xml.open('filter')
+            xml.open('effect')
+            xml.text('name', 'Opacity')
+            xml.text('effectid', 'opacity')
+            xml.text('effectcategory', 'motion')
+            xml.text('effecttype', 'motion')
+            xml.text('mediatype', 'video')
+            xml.open('parameter', {'authoringApp': 'PremierePro'})
+            xml.text('parameterid', 'opacity')
+            xml.text('name', 'opacity')
+            xml.text('value', '0')
+            xml.close('parameter')
+            xml.close('effect')
+            xml.close('filter')
+
+            stream_markers(xml, input_path, fps, drift, time_range)
+            xml.close('generatoritem')
+            xml.close('track')
+            xml.close('video')
+
+            xml.open('audio')
+            xml.text('numOutputChannels', '2')
+            xml.open('format')
+            xml.open('samplecharacteristics')
+            xml.text('depth', '16')
+            xml.text('samplerate', '48000')
+            xml.close('samplecharacteristics')
+            xml.close('format')
+            for i in range(2):
+                xml.open('track')
+                xml.text('enabled', 'TRUE')
+                xml.text('locked', 'FALSE')
+                xml.text('outputchannelindex', i + 1)
+                xml.close('track')
+            xml.close('audio')
+            xml.close('media')
+
+            xml.open('timecode')
+            write_rate(xml, timebase, ntsc)
+            xml.text('string', '00:00:00:00')
+            xml.text('frame', '0')
+            xml.text('displayformat', 'NDF')
+            xml.close('timecode')
+
+            # Markers at sequence level too (for better compatibility)
+            stream_markers(xml, input_path, fps, drift, time_range)
+            xml.close('sequence')
+            xml.close('xmeml')
+
+            if not indent:
+                f.write('\n')
+        return True
+    except Exception as e:
+        print(f"Error writing XML file: {e}")
+        return False
+
+def resolve_output(args, metadata):
+    """Pick the FPS and the output path from the metadata and the arguments."""
     # Auto-detect FPS from metadata if available
     fps = args.fps
     if metadata and 'fps_num' in metadata and 'fps_den' in metadata:
@@ -402,7 +1044,13 @@ def main():
 
     # Auto-detect output filename from video file if metadata available
     output_file = args.output
-    if metadata and 'recording_path' in metadata and 'timestamp' in metadata:
+    video_file = recorded_video_file(args.input, metadata)
+    if video_file:
+        print(f"Recorded video: {video_file}")
+        video_basename = os.path.splitext(os.path.basename(video_file))[0]
+        output_file = os.path.join(os.path.dirname(video_file), f"{video_basename}_markers.xml")
+        print(f"Auto-generated output: {output_file}")
+    elif metadata and 'recording_path' in metadata and 'timestamp' in metadata:
         recording_dir = metadata['recording_path']
         recording_time = metadata['timestamp']
 
@@ -410,7 +1058,7 @@ def main():
         print(f"Recording timestamp: {recording_time}")
         print()
 
-        # Try to find the matching video file
+        # Older sessions don't record the file; try to find the matching video
         video_file = find_latest_video_file(recording_dir, recording_time)
         if video_file:
             print(f"Found matching video: {os.path.basename(video_file)}")
@@ -432,6 +1080,304 @@ def main():
             output_file = os.path.splitext(args.input)[0] + '_markers.xml'
         print(f"Output file: {output_file}")
 
+    return fps, output_file
+
+def stream_main(args):
+    """--stream: convert with constant memory, re-reading the log per marker list."""
+    print("Scanning timestamps...")
+    scan = scan_timestamps(args.input, args.time_range)
+    if scan is None:
+        return 1
+
+    metadata, count, max_frame, max_ms = scan
+    if not count:
+        print("No valid timestamps found in the input file")
+        return 1
+
+    print(f"Found {count} timestamp(s)")
+    print()
+
+    fps, output_file = resolve_output(args, metadata)
+
+    print(f"FPS:         {fps}")
+    print()
+
+    # Calculate duration (last marker + 60 seconds buffer)
+    last_frame = max(max_frame if max_frame is not None else 0,
+                     ms_to_frames(max_ms, fps) if max_ms is not None else 0)
+    duration = last_frame + ms_to_frames(60000, fps)
+
+    print("Streaming Premiere Pro XML...")
+    success = stream_premiere_xml(
+        args.input,
+        output_file,
+        duration,
+        fps=fps,
+        sequence_name=args.sequence_name,
+        width=args.width,
+        height=args.height,
+        indent=args.indent,
+        drift=metadata.get('drift'),
+        time_range=args.time_range
+    )
+
+    if success:
+        print(f"✓ XML file saved to '{output_file}'")
+        return 0
+    print("✗ Failed to generate XML file")
+    return 1
+
+# Session log extensions picked up by --batch
+SESSION_EXTENSIONS = ('.jsonl', '.tsmj')
+
+def collect_sessions(pattern):
+    """Expand a --batch input (directory or glob) into a sorted list of session files."""
+    if os.path.isdir(pattern):
+        paths = []
+        for root, _, files in os.walk(pattern):
+            paths.extend(os.path.join(root, name) for name in files
+                          if name.lower().endswith(SESSION_EXTENSIONS))
+    else:
+        paths = [path for path in glob.glob(pattern, recursive=True) if os.path.isfile(path)]
+    return sorted(paths)
+
+def read_trailing_metadata(file_path):
+    """The metadata line the plugin appends after the markers at stop, or {}."""
+    try:
+        with open(file_path, 'rb') as f:
+            f.seek(0, os.SEEK_END)
+            f.seek(max(0, f.tell() - 4096))
+            lines = f.read().splitlines()
+        data = json.loads(lines[-1]) if lines else {}
+    except (OSError, ValueError):
+        return {}
+    return data.get('metadata', {}) if isinstance(data, dict) else {}
+
+def read_metadata(file_path):
+    """Read just the metadata of a session file, not its markers (or None)."""
+    try:
+        for kind, record in iter_records(file_path, quiet=True):
+            if kind != 'metadata':
+                return None
+            if not is_journal(file_path):
+                record.update(read_trailing_metadata(file_path))
+            return record
+    except (OSError, JournalError):
+        return None
+    return None
+
+def metadata_fps(metadata, default_fps):
+    """FPS from a session's metadata, or the default."""
+    if metadata and metadata.get('fps_num') and metadata.get('fps_den'):
+        return metadata['fps_num'] / metadata['fps_den']
+    return default_fps
+
+def plan_batch(args, sessions):
+    """
+    Work out the output path and FPS of every session.
+
+    Sessions that recorded their video file use it directly. For the others,
+    each recording directory is listed once, however many sessions point at it.
+    Old sessions don't fall back to the newest video, so two of them never map
+    onto the same XML.
+
+    Returns a list of job dicts.
+    """
+    video_scans = {}
+    manifests = {}
+    jobs = []
+    for session in sessions:
+        metadata = read_metadata(session)
+        output_file = None
+
+        session_dir = os.path.dirname(os.path.abspath(session))
+        if session_dir not in manifests:
+            manifests[session_dir] = load_manifest_videos(session_dir)
+
+        video_file = recorded_video_file(session, metadata, manifests[session_dir])
+        recording_dir = metadata.get('recording_path') if metadata else None
+        if video_file:
+            video_basename = os.path.splitext(os.path.basename(video_file))[0]
+            output_file = os.path.join(os.path.dirname(video_file), f"{video_basename}_markers.xml")
+        elif recording_dir and 'timestamp' in metadata:
+            if recording_dir not in video_scans:
+                video_scans[recording_dir] = scan_video_files(recording_dir)
+            video_file = pick_video_file(video_scans[recording_dir], metadata['timestamp'],
+                                         allow_newest=False)
+            if video_file:
+                video_basename = os.path.splitext(os.path.basename(video_file))[0]
+                output_file = os.path.join(recording_dir, f"{video_basename}_markers.xml")
+
+        if not output_file:
+            output_file = os.path.splitext(session)[0] + '_markers.xml'
+        if args.output:
+            output_file = os.path.join(args.output, os.path.basename(output_file))
+
+        jobs.append({
+            'input': session,
+            'output': output_file,
+            'fps': metadata_fps(metadata, args.fps),
+            'sequence_name': args.sequence_name,
+            'width': args.width,
+            'height': args.height,
+            'stream': args.stream,
+            'indent': args.indent,
+        })
+    return jobs
+
+def is_up_to_date(job):
+    """True when the job's XML is newer than its session file."""
+    try:
+        return os.path.getmtime(job['output']) >= os.path.getmtime(job['input'])
+    except OSError:
+        return False
+
+def convert_session(job):
+    """Batch worker: convert one session quietly and report how it went."""
+    start = time.perf_counter()
+    log = io.StringIO()
+    markers = 0
+    success = False
+
+    try:
+        with redirect_stdout(log):
+            fps = job['fps']
+            if job['stream']:
+                scan = scan_timestamps(job['input'])
+                if scan and scan[1]:
+                    metadata, markers, max_frame, max_ms = scan
+                    last_frame = max(max_frame if max_frame is not None else 0,
+                                     ms_to_frames(max_ms, fps) if max_ms is not None else 0)
+                    success = stream_premiere_xml(job['input'], job['output'],
+                                                  last_frame + ms_to_frames(60000, fps), fps=fps,
+                                                  sequence_name=job['sequence_name'], width=job['width'],
+                                                  height=job['height'], indent=job['indent'],
+                                                  drift=metadata.get('drift'))
+            else:
+                if is_journal(job['input']):
+                    _, timestamps = parse_journal(job['input'])
+                else:
+                    _, timestamps = parse_timestamps(job['input'])
+                if timestamps:
+                    markers = len(timestamps)
+                    success = create_premiere_xml(timestamps, job['output'], fps=fps,
+                                                  sequence_name=job['sequence_name'],
+                                                  width=job['width'], height=job['height'])
+    except Exception as e:
+        log.write(f"{e}\n")
+
+    if not success and not markers:
+        log.write("No valid timestamps found\n")
+
+    # The last thing the converter printed is the most useful error line
+    lines = [line for line in log.getvalue().splitlines() if line.strip()]
+    return {
+        'input': job['input'],
+        'output': job['output'],
+        'markers': markers,
+        'success': bool(success),
+        'bytes': os.path.getsize(job['input']) if os.path.exists(job['input']) else 0,
+        'seconds': time.perf_counter() - start,
+        'error': lines[-1] if lines else '',
+    }
+
+def batch_main(args):
+    """--batch: convert a whole archive of sessions across a worker pool."""
+    start = time.perf_counter()
+
+    sessions = collect_sessions(args.input)
+    if not sessions:
+        print(f"No session files found in '{args.input}'")
+        return 1
+
+    if args.output:
+        os.makedirs(args.output, exist_ok=True)
+
+    jobs = plan_batch(args, sessions)
+    pending = [job for job in jobs if args.force or not is_up_to_date(job)]
+    skipped = len(jobs) - len(pending)
+
+    workers = max(1, min(args.jobs or os.cpu_count() or 1, len(pending) or 1))
+    print(f"Found {len(jobs)} session(s), {skipped} up to date, converting {len(pending)} "
+          f"with {workers} worker(s)")
+    print()
+
+    results = []
+    if pending:
+        with Pool(processes=workers) as pool:
+            for result in pool.imap_unordered(convert_session, pending):
+                results.append(result)
+                if result['success']:
+                    print(f"✓ {result['input']} -> {result['output']} "
+                          f"({result['markers']} marker(s), {result['seconds']:.2f}s)")
+                else:
+                    print(f"✗ {result['input']}: {result['error']}")
+
+    elapsed = time.perf_counter() - start
+    converted = [result for result in results if result['success']]
+    failed = len(results) - len(converted)
+    markers = sum(result['markers'] for result in converted)
+    megabytes = sum(result['bytes'] for result in converted) / (1024 * 1024)
+
+    print()
+    print(f"=" * 50)
+    print(f"Converted:   {len(converted)} session(s), {markers} marker(s), {megabytes:.1f} MB")
+    print(f"Skipped:     {skipped} up to date")
+    print(f"Failed:      {failed}")
+    if elapsed > 0:
+        print(f"Throughput:  {len(converted) / elapsed:.1f} sessions/s, {markers / elapsed:.0f} markers/s, "
+              f"{megabytes / elapsed:.1f} MB/s ({elapsed:.2f}s)")
+
+    return 1 if failed else 0
+
+def main():
+    """Main entry point."""
+    args = parse_arguments()
+
+    if args.batch:
+        if args.start_ms is not None or args.end_ms is not None:
+            print("Error: --start-ms and --end-ms apply to a single session, not --batch")
+            return 1
+        return batch_main(args)
+
+    # Markers of a time range only; the index lets the log be read in part
+    args.time_range = None
+    if args.start_ms is not None or args.end_ms is not None:
+        args.time_range = (args.start_ms if args.start_ms is not None else 0,
+                           args.end_ms if args.end_ms is not None else sys.maxsize)
+
+    print(f"OBS Timestamp to Premiere Pro XML Converter")
+    print(f"=" * 50)
+    print(f"Input file:  {args.input}")
+    print()
+
+    if args.stream and not args.dump_jsonl:
+        return stream_main(args)
+
+    # Parse timestamps
+    print("Parsing timestamps...")
+    if is_journal(args.input):
+        metadata, timestamps = parse_journal(args.input, args.time_range)
+    else:
+        metadata, timestamps = parse_timestamps(args.input, args.time_range)
+
+    if timestamps is None:
+        return 1
+
+    if args.dump_jsonl:
+        write_jsonl(metadata, timestamps, args.dump_jsonl)
+        print(f"Wrote {len(timestamps)} timestamp(s) to {args.dump_jsonl}")
+        return 0
+
+    if not timestamps:
+        print("No valid timestamps found in the input file")
+        return 1
+
+    print(f"Found {len(timestamps)} timestamp(s)")
+    print()
+
+    fps, output_file = resolve_output(args, metadata)
+
     print(f"FPS:         {fps}")
     print()
 
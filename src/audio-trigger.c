@@ -0,0 +1,258 @@
+#include "audio-trigger.h"
+#include "marker-stats.h"
+#include <util/platform.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_TRIGGER_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define AUDIO_TRIGGER_NEON
+#endif
+
+struct audio_trigger {
+    obs_source_t *source; // NULL when listening to a track
+    audio_t *audio;
+    size_t mix_idx;
+    size_t channels;
+    char label[256];
+
+    // Thresholds as linear amplitudes, so the callback needs no log or sqrt
+    float on_level;
+    float off_level;
+    uint64_t hold_ns;
+    bool use_peak;
+
+    audio_trigger_callback callback;
+    void *param;
+
+    // Audio thread only from here on
+    bool fired;              // over the threshold, waiting to re-arm
+    uint64_t quiet_since_ns; // start of the block the level fell below off_level in (0 = not yet)
+    uint64_t blocks;
+    uint64_t markers;
+    uint64_t total_ns;
+    uint64_t max_ns;
+};
+
+bool audio_trigger_enabled(const struct audio_trigger_settings *settings)
+{
+    return settings->source[0] || settings->track > 0;
+}
+
+// Largest of the four lanes and the sum of the four lanes
+#if defined(AUDIO_TRIGGER_SSE2)
+static float max_lanes(__m128 v)
+{
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+static float sum_lanes(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+#endif
+
+void audio_trigger_measure(const float *samples, size_t count, float *peak, float *sum_squares)
+{
+    float max = *peak;
+    float sum = 0.0f;
+    size_t i = 0;
+
+    // Two accumulators each, so consecutive adds don't wait on each other
+#if defined(AUDIO_TRIGGER_SSE2)
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 max0 = _mm_setzero_ps(), max1 = _mm_setzero_ps();
+    __m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_loadu_ps(samples + i);
+        __m128 b = _mm_loadu_ps(samples + i + 4);
+        max0 = _mm_max_ps(max0, _mm_and_ps(a, abs_mask));
+        max1 = _mm_max_ps(max1, _mm_and_ps(b, abs_mask));
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(a, a));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(b, b));
+    }
+
+    float block_max = max_lanes(_mm_max_ps(max0, max1));
+    max = block_max > max ? block_max : max;
+    sum = sum_lanes(_mm_add_ps(sum0, sum1));
+#elif defined(AUDIO_TRIGGER_NEON)
+    float32x4_t max0 = vdupq_n_f32(0.0f), max1 = vdupq_n_f32(0.0f);
+    float32x4_t sum0 = vdupq_n_f32(0.0f), sum1 = vdupq_n_f32(0.0f);
+
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a = vld1q_f32(samples + i);
+        float32x4_t b = vld1q_f32(samples + i + 4);
+        max0 = vmaxq_f32(max0, vabsq_f32(a));
+        max1 = vmaxq_f32(max1, vabsq_f32(b));
+        sum0 = vfmaq_f32(sum0, a, a);
+        sum1 = vfmaq_f32(sum1, b, b);
+    }
+
+    float block_max = vmaxvq_f32(vmaxq_f32(max0, max1));
+    max = block_max > max ? block_max : max;
+    sum = vaddvq_f32(vaddq_f32(sum0, sum1));
+#endif
+
+    for (; i < count; i++) {
+        float sample = samples[i];
+        float magnitude = sample < 0.0f ? -sample : sample;
+        max = magnitude > max ? magnitude : max;
+        sum += sample * sample;
+    }
+
+    *peak = max;
+    *sum_squares += sum;
+}
+
+static float to_db(float level)
+{
+    return level > 0.0f ? 20.0f * log10f(level) : -INFINITY;
+}
+
+// One block: measure it, then fire or re-arm. Costs one pass over the
+// samples plus a few comparisons; the clock is read twice for the stats.
+static void process_block(struct audio_trigger *trigger, const struct audio_data *audio, bool muted)
+{
+    uint64_t start_ns = os_gettime_ns();
+
+    float peak = 0.0f;
+    float sum_squares = 0.0f;
+    size_t samples = 0;
+
+    if (!muted) {
+        for (size_t ch = 0; ch < trigger->channels && ch < MAX_AV_PLANES; ch++) {
+            if (audio->data[ch]) {
+                audio_trigger_measure((const float *)audio->data[ch], audio->frames, &peak, &sum_squares);
+                samples += audio->frames;
+            }
+        }
+    }
+
+    // RMS >= level  <=>  sum of squares >= level^2 * samples
+    bool over, under;
+    if (trigger->use_peak) {
+        over = peak >= trigger->on_level;
+        under = peak < trigger->off_level;
+    } else {
+        over = samples && sum_squares >= trigger->on_level * trigger->on_level * (float)samples;
+        under = !samples || sum_squares < trigger->off_level * trigger->off_level * (float)samples;
+    }
+
+    if (!trigger->fired) {
+        if (over) {
+            trigger->fired = true;
+            trigger->quiet_since_ns = 0;
+            trigger->markers++;
+
+            float level = trigger->use_peak ? peak : sqrtf(sum_squares / (float)samples);
+            trigger->callback(trigger->param, trigger->label, audio->timestamp, to_db(level));
+        }
+    } else if (!under) {
+        trigger->quiet_since_ns = 0;
+    } else if (!trigger->quiet_since_ns) {
+        trigger->quiet_since_ns = audio->timestamp ? audio->timestamp : 1;
+    } else if (audio->timestamp - trigger->quiet_since_ns >= trigger->hold_ns) {
+        trigger->fired = false;
+    }
+
+    uint64_t cost_ns = os_gettime_ns() - start_ns;
+    trigger->blocks++;
+    trigger->total_ns += cost_ns;
+    trigger->max_ns = cost_ns > trigger->max_ns ? cost_ns : trigger->max_ns;
+    marker_stats_record(MARKER_STAT_AUDIO_BLOCK, cost_ns);
+}
+
+static void source_audio_callback(void *param, obs_source_t *source, const struct audio_data *audio, bool muted)
+{
+    UNUSED_PARAMETER(source);
+    process_block(param, audio, muted);
+}
+
+static void mix_audio_callback(void *param, size_t mix_idx, struct audio_data *audio)
+{
+    UNUSED_PARAMETER(mix_idx);
+    process_block(param, audio, false);
+}
+
+struct audio_trigger *audio_trigger_create(const struct audio_trigger_settings *settings,
+                                           audio_trigger_callback callback, void *param)
+{
+    audio_t *audio = obs_get_audio();
+    if (!audio || !audio_trigger_enabled(settings)) {
+        return NULL;
+    }
+
+    struct audio_trigger *trigger = bzalloc(sizeof(*trigger));
+    trigger->audio = audio;
+    trigger->channels = audio_output_get_channels(audio);
+    trigger->on_level = powf(10.0f, settings->threshold_db / 20.0f);
+    trigger->off_level = powf(10.0f, (settings->threshold_db - settings->hysteresis_db) / 20.0f);
+    trigger->hold_ns = (uint64_t)settings->hold_ms * 1000000ULL;
+    trigger->use_peak = settings->use_peak;
+    trigger->callback = callback;
+    trigger->param = param;
+
+    if (settings->source[0]) {
+        trigger->source = obs_get_source_by_name(settings->source);
+        if (!trigger->source) {
+            blog(LOG_WARNING, "Timestamp Plugin: Audio trigger source '%s' not found", settings->source);
+            bfree(trigger);
+            return NULL;
+        }
+        snprintf(trigger->label, sizeof(trigger->label), "%s", settings->source);
+        obs_source_add_audio_capture_callback(trigger->source, source_audio_callback, trigger);
+    } else {
+        if (settings->track > MAX_AUDIO_MIXES) {
+            blog(LOG_WARNING, "Timestamp Plugin: Audio trigger track %u doesn't exist", settings->track);
+            bfree(trigger);
+            return NULL;
+        }
+        trigger->mix_idx = settings->track - 1;
+        snprintf(trigger->label, sizeof(trigger->label), "Track %u", settings->track);
+
+        // No conversion: the mix arrives as OBS produces it, float planar
+        if (!audio_output_connect(audio, trigger->mix_idx, NULL, mix_audio_callback, trigger)) {
+            blog(LOG_WARNING, "Timestamp Plugin: Could not listen to audio track %u", settings->track);
+            bfree(trigger);
+            return NULL;
+        }
+    }
+
+    blog(LOG_INFO, "Timestamp Plugin: Audio trigger on %s at %.1f dB %s (re-arms %.1f dB below for %u ms)",
+         trigger->label, settings->threshold_db, trigger->use_peak ? "peak" : "RMS", settings->hysteresis_db,
+         settings->hold_ms);
+    return trigger;
+}
+
+void audio_trigger_destroy(struct audio_trigger *trigger)
+{
+    if (!trigger) {
+        return;
+    }
+
+    // Both take the lock the audio thread holds while calling back
+    if (trigger->source) {
+        obs_source_remove_audio_capture_callback(trigger->source, source_audio_callback, trigger);
+        obs_source_release(trigger->source);
+    } else {
+        audio_output_disconnect(trigger->audio, trigger->mix_idx, mix_audio_callback, trigger);
+    }
+
+    blog(LOG_INFO,
+         "Timestamp Plugin: Audio trigger on %s: %" PRIu64 " marker(s), %" PRIu64
+         " block(s), %.2f us mean, %.2f us max per block",
+         trigger->label, trigger->markers, trigger->blocks,
+         trigger->blocks ? (double)trigger->total_ns / (double)trigger->blocks / 1000.0 : 0.0,
+         (double)trigger->max_ns / 1000.0);
+    bfree(trigger);
+}
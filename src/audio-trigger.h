@@ -0,0 +1,46 @@
+#pragma once
+
+#include <obs-module.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Markers from the sound of the recording: whenever an audio source (say the
+// commentator mic) or one of the output tracks gets louder than a threshold.
+// The detector runs inside the libobs audio callback, which is hard
+// real-time: it measures each block in one vectorized pass over the samples,
+// allocates nothing and only pushes onto the lock-free marker queue.
+
+struct audio_trigger_settings {
+    char source[256];    // audio source to listen to; empty = an output track
+    uint32_t track;      // output track 1-6 when source is empty (0 = off)
+    float threshold_db;  // a block at or above this level (dBFS) fires a marker
+    float hysteresis_db; // the level must fall this far below the threshold...
+    uint32_t hold_ms;    // ...for at least this long before the next can fire
+    bool use_peak;       // compare the block's peak instead of its RMS level
+};
+
+// Called on the audio thread with the start time of the block that crossed
+// the threshold (os_gettime_ns() clock) and its level in dBFS
+typedef void (*audio_trigger_callback)(void *param, const char *label, uint64_t timestamp_ns, float level_db);
+
+struct audio_trigger;
+
+bool audio_trigger_enabled(const struct audio_trigger_settings *settings);
+
+// Attach a detector to the source or track; NULL if it doesn't exist. The
+// callback may run as soon as this returns.
+struct audio_trigger *audio_trigger_create(const struct audio_trigger_settings *settings,
+                                           audio_trigger_callback callback, void *param);
+
+// Detach (no callback runs after this returns), log the per-block cost and free
+void audio_trigger_destroy(struct audio_trigger *trigger);
+
+// The block kernel: largest absolute sample and sum of squares of count
+// samples, added into *peak and *sum_squares
+void audio_trigger_measure(const float *samples, size_t count, float *peak, float *sum_squares);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,776 @@
+#include "chapter-export.h"
+#include "timestamp-plugin.h"
+#include <util/darray.h>
+#include <util/dstr.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Both formats are patched where they lie: nothing that is already in the file
+// moves, so sample offsets, cues and the like stay valid and the cost is a few
+// hundred bytes of I/O however long the recording is. New data is always
+// written before the sizes/pointers that make it reachable, so an interrupted
+// write leaves a file that still plays, just without chapters.
+
+// Titles longer than this are cut (the chpl length field is one byte)
+#define CHAPTER_TITLE_MAX 255
+
+// chpl stores the chapter count in one byte
+#define MP4_CHAPTERS_MAX 255
+
+// moov is read into memory when it has to be copied; refuse absurd sizes
+#define MP4_MOOV_MAX_SIZE (256u * 1024 * 1024)
+
+// Matroska element IDs (with their length marker bits, as stored)
+#define EBML_ID_HEADER 0x1A45DFA3
+#define MKV_ID_SEGMENT 0x18538067
+#define MKV_ID_SEEK_HEAD 0x114D9B74
+#define MKV_ID_SEEK 0x4DBB
+#define MKV_ID_SEEK_ID 0x53AB
+#define MKV_ID_SEEK_POSITION 0x53AC
+#define MKV_ID_VOID 0xEC
+#define MKV_ID_CHAPTERS 0x1043A770
+#define MKV_ID_EDITION_ENTRY 0x45B9
+#define MKV_ID_EDITION_UID 0x45BC
+#define MKV_ID_CHAPTER_ATOM 0xB6
+#define MKV_ID_CHAPTER_UID 0x73C4
+#define MKV_ID_CHAPTER_TIME_START 0x91
+#define MKV_ID_CHAPTER_DISPLAY 0x80
+#define MKV_ID_CHAP_STRING 0x85
+#define MKV_ID_CHAP_LANGUAGE 0x437C
+
+// A SeekHead bigger than this is not something a muxer wrote
+#define MKV_SEEK_HEAD_MAX_SIZE (64 * 1024)
+
+struct chapter {
+    uint64_t start_ns;
+    const char *title;
+    size_t title_len;
+};
+
+struct byte_buffer {
+    DARRAY(uint8_t) data;
+};
+
+static void put_bytes(struct byte_buffer *buffer, const void *bytes, size_t size)
+{
+    da_push_back_array(buffer->data, (const uint8_t *)bytes, size);
+}
+
+// Big-endian, the byte order of both formats
+static void put_be(struct byte_buffer *buffer, uint64_t value, int size)
+{
+    uint8_t bytes[8];
+    for (int i = 0; i < size; i++) {
+        bytes[i] = (uint8_t)(value >> (8 * (size - 1 - i)));
+    }
+    put_bytes(buffer, bytes, (size_t)size);
+}
+
+static void store_be(uint8_t *bytes, uint64_t value, int size)
+{
+    for (int i = 0; i < size; i++) {
+        bytes[i] = (uint8_t)(value >> (8 * (size - 1 - i)));
+    }
+}
+
+static uint64_t load_be(const uint8_t *bytes, int size)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+static bool read_at(FILE *file, int64_t offset, void *bytes, size_t size)
+{
+    return os_fseeki64(file, offset, SEEK_SET) == 0 && fread(bytes, 1, size, file) == size;
+}
+
+static bool write_at(FILE *file, int64_t offset, const void *bytes, size_t size)
+{
+    return os_fseeki64(file, offset, SEEK_SET) == 0 && fwrite(bytes, 1, size, file) == size &&
+           fflush(file) == 0;
+}
+
+// Cut a title to max bytes without splitting a UTF-8 sequence
+static size_t title_length(const char *title, size_t max)
+{
+    size_t length = strlen(title);
+    if (length <= max) {
+        return length;
+    }
+
+    length = max;
+    while (length > 0 && ((uint8_t)title[length] & 0xC0) == 0x80) {
+        length--;
+    }
+    return length;
+}
+
+// One chapter per marker, titled with its name or else its comment. The
+// trailing "Recording End" marker would only be an empty chapter.
+static size_t collect_chapters(const struct marker_store *store, struct chapter **chapters)
+{
+    size_t count = store->markers.num;
+    if (count > 0 && strcmp(store->markers.array[count - 1].comment, "Recording End") == 0) {
+        count--;
+    }
+
+    *chapters = count ? bmalloc(count * sizeof(**chapters)) : NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        const struct stored_marker *marker = &store->markers.array[i];
+        struct chapter *chapter = &(*chapters)[i];
+
+        chapter->start_ns = marker->timestamp_ns;
+        chapter->title = *marker->name ? marker->name : marker->comment;
+        chapter->title_len = title_length(chapter->title, CHAPTER_TITLE_MAX);
+    }
+
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// Matroska
+
+struct ebml_element {
+    uint32_t id;
+    uint64_t size;
+    bool unknown_size;
+    int64_t offset;
+    int header_size;
+    int size_length;
+};
+
+// Length of a variable-size integer from its first byte (0 = invalid)
+static int ebml_vint_length(uint8_t first)
+{
+    for (int length = 1; length <= 8; length++) {
+        if (first & (0x80 >> (length - 1))) {
+            return length;
+        }
+    }
+    return 0;
+}
+
+static bool ebml_read_element(FILE *file, int64_t offset, struct ebml_element *element)
+{
+    uint8_t bytes[12];
+
+    if (os_fseeki64(file, offset, SEEK_SET) != 0) {
+        return false;
+    }
+
+    size_t available = fread(bytes, 1, sizeof(bytes), file);
+    if (available < 2) {
+        return false;
+    }
+
+    int id_length = ebml_vint_length(bytes[0]);
+    if (id_length == 0 || id_length > 4 || (size_t)id_length >= available) {
+        return false;
+    }
+
+    int size_length = ebml_vint_length(bytes[id_length]);
+    if (size_length == 0 || (size_t)(id_length + size_length) > available) {
+        return false;
+    }
+
+    uint64_t size = bytes[id_length] & (0xFF >> size_length);
+    for (int i = 1; i < size_length; i++) {
+        size = (size << 8) | bytes[id_length + i];
+    }
+
+    element->id = (uint32_t)load_be(bytes, id_length);
+    element->size = size;
+    element->unknown_size = size == (1ULL << (7 * size_length)) - 1;
+    element->offset = offset;
+    element->header_size = id_length + size_length;
+    element->size_length = size_length;
+    return true;
+}
+
+static int64_t ebml_element_end(const struct ebml_element *element)
+{
+    return element->offset + element->header_size + (int64_t)element->size;
+}
+
+// Shortest size field that can hold size (all ones is reserved for "unknown")
+static int ebml_size_length(uint64_t size)
+{
+    int length = 1;
+    while (length < 8 && size >= (1ULL << (7 * length)) - 1) {
+        length++;
+    }
+    return length;
+}
+
+static void ebml_put_id(struct byte_buffer *buffer, uint32_t id)
+{
+    int length = id > 0xFFFFFF ? 4 : id > 0xFFFF ? 3 : id > 0xFF ? 2 : 1;
+    put_be(buffer, id, length);
+}
+
+static void ebml_put_size(struct byte_buffer *buffer, uint64_t size, int length)
+{
+    put_be(buffer, size | (1ULL << (7 * length)), length);
+}
+
+static void ebml_put_uint(struct byte_buffer *buffer, uint32_t id, uint64_t value)
+{
+    int length = 1;
+    while (length < 8 && (value >> (8 * length)) != 0) {
+        length++;
+    }
+
+    ebml_put_id(buffer, id);
+    ebml_put_size(buffer, (uint64_t)length, 1);
+    put_be(buffer, value, length);
+}
+
+static void ebml_put_string(struct byte_buffer *buffer, uint32_t id, const char *string, size_t length)
+{
+    ebml_put_id(buffer, id);
+    ebml_put_size(buffer, length, ebml_size_length(length));
+    put_bytes(buffer, string, length);
+}
+
+// Master elements get an 8-byte size field that is filled in once the
+// children are written
+static size_t ebml_begin_master(struct byte_buffer *buffer, uint32_t id)
+{
+    ebml_put_id(buffer, id);
+    size_t position = buffer->data.num;
+    ebml_put_size(buffer, 0, 8);
+    return position;
+}
+
+static void ebml_end_master(struct byte_buffer *buffer, size_t position)
+{
+    uint64_t size = buffer->data.num - position - 8;
+    store_be(buffer->data.array + position, size | (1ULL << 56), 8);
+}
+
+// A Void element filling exactly size bytes (size >= 2)
+static void ebml_put_void(struct byte_buffer *buffer, uint64_t size)
+{
+    int length = size - 2 <= 126 ? 1 : 8;
+    uint64_t payload = size - 1 - (uint64_t)length;
+
+    ebml_put_id(buffer, MKV_ID_VOID);
+    ebml_put_size(buffer, payload, length);
+
+    static const uint8_t zeros[256] = {0};
+    while (payload > 0) {
+        size_t chunk = payload < sizeof(zeros) ? (size_t)payload : sizeof(zeros);
+        put_bytes(buffer, zeros, chunk);
+        payload -= chunk;
+    }
+}
+
+static void mkv_build_chapters(struct byte_buffer *buffer, const struct chapter *chapters, size_t count)
+{
+    size_t chapters_position = ebml_begin_master(buffer, MKV_ID_CHAPTERS);
+    size_t edition_position = ebml_begin_master(buffer, MKV_ID_EDITION_ENTRY);
+    ebml_put_uint(buffer, MKV_ID_EDITION_UID, (os_gettime_ns() & 0xFFFFFFFFFFFFull) | 1);
+
+    for (size_t i = 0; i < count; i++) {
+        size_t atom_position = ebml_begin_master(buffer, MKV_ID_CHAPTER_ATOM);
+        ebml_put_uint(buffer, MKV_ID_CHAPTER_UID, i + 1);
+        ebml_put_uint(buffer, MKV_ID_CHAPTER_TIME_START, chapters[i].start_ns);
+
+        size_t display_position = ebml_begin_master(buffer, MKV_ID_CHAPTER_DISPLAY);
+        ebml_put_string(buffer, MKV_ID_CHAP_STRING, chapters[i].title, chapters[i].title_len);
+        ebml_put_string(buffer, MKV_ID_CHAP_LANGUAGE, "eng", 3);
+        ebml_end_master(buffer, display_position);
+
+        ebml_end_master(buffer, atom_position);
+    }
+
+    ebml_end_master(buffer, edition_position);
+    ebml_end_master(buffer, chapters_position);
+}
+
+// The Chapters element is appended to the segment and announced in the
+// SeekHead, which grows into the Void the muxer reserved right after it
+// (libavformat leaves room for a few more entries).
+static const char *write_mkv_chapters(FILE *file, int64_t file_size, const struct chapter *chapters, size_t count,
+                                      uint64_t *written)
+{
+    struct ebml_element header, segment, element;
+    struct ebml_element seek_head = {0}, space = {0};
+    bool have_seek_head = false, have_space = false;
+
+    if (!ebml_read_element(file, 0, &header) || header.id != EBML_ID_HEADER || header.unknown_size) {
+        return "not a Matroska file";
+    }
+    if (!ebml_read_element(file, ebml_element_end(&header), &segment) || segment.id != MKV_ID_SEGMENT) {
+        return "no Matroska segment";
+    }
+
+    int64_t segment_data = segment.offset + segment.header_size;
+    if (!segment.unknown_size && ebml_element_end(&segment) != file_size) {
+        return "the segment does not end at the end of the file";
+    }
+
+    for (int64_t position = segment_data; position < file_size;) {
+        if (!ebml_read_element(file, position, &element)) {
+            return "damaged segment";
+        }
+        if (element.id == MKV_ID_CHAPTERS) {
+            return "the file already has chapters";
+        }
+
+        if (element.id == MKV_ID_SEEK_HEAD && !have_seek_head) {
+            seek_head = element;
+            have_seek_head = true;
+        } else if (element.id == MKV_ID_VOID && have_seek_head && !have_space &&
+                   position == ebml_element_end(&seek_head)) {
+            space = element;
+            have_space = true;
+        }
+
+        // Nothing after an element of unknown size can be walked
+        if (element.unknown_size) {
+            break;
+        }
+        position = ebml_element_end(&element);
+    }
+
+    if (!have_seek_head || seek_head.unknown_size || seek_head.size > MKV_SEEK_HEAD_MAX_SIZE) {
+        return "no SeekHead to register the chapters in";
+    }
+
+    struct byte_buffer chapters_element = {0};
+    struct byte_buffer seek_region = {0};
+    const char *error = NULL;
+
+    mkv_build_chapters(&chapters_element, chapters, count);
+
+    // Existing entries plus one for the chapters
+    struct byte_buffer content = {0};
+    da_resize(content.data, (size_t)seek_head.size);
+    if (!read_at(file, seek_head.offset + seek_head.header_size, content.data.array, content.data.num)) {
+        error = "could not read the SeekHead";
+        goto done;
+    }
+
+    uint8_t chapters_id[4];
+    store_be(chapters_id, MKV_ID_CHAPTERS, 4);
+
+    size_t seek_position = ebml_begin_master(&content, MKV_ID_SEEK);
+    ebml_put_id(&content, MKV_ID_SEEK_ID);
+    ebml_put_size(&content, sizeof(chapters_id), 1);
+    put_bytes(&content, chapters_id, sizeof(chapters_id));
+    ebml_put_uint(&content, MKV_ID_SEEK_POSITION, (uint64_t)(file_size - segment_data));
+    ebml_end_master(&content, seek_position);
+
+    // The new SeekHead and whatever is left of the Void must fill the old
+    // SeekHead + Void exactly
+    int64_t region = ebml_element_end(have_space ? &space : &seek_head) - seek_head.offset;
+    int size_length = seek_head.size_length;
+    if (size_length < ebml_size_length(content.data.num)) {
+        size_length = ebml_size_length(content.data.num);
+    }
+
+    int64_t remaining = region - (4 + size_length + (int64_t)content.data.num);
+    if (remaining == 1 && size_length < 8) {
+        size_length++;
+        remaining--;
+    }
+    if (remaining < 0 || remaining == 1) {
+        error = "no room left in the SeekHead";
+        da_free(content.data);
+        goto done;
+    }
+
+    ebml_put_id(&seek_region, MKV_ID_SEEK_HEAD);
+    ebml_put_size(&seek_region, content.data.num, size_length);
+    put_bytes(&seek_region, content.data.array, content.data.num);
+    if (remaining > 0) {
+        ebml_put_void(&seek_region, (uint64_t)remaining);
+    }
+    da_free(content.data);
+
+    uint64_t segment_size = segment.size + chapters_element.data.num;
+    bool patch_segment = !segment.unknown_size;
+    if (patch_segment && segment_size >= (1ULL << (7 * segment.size_length)) - 1) {
+        error = "the segment size field is too small";
+        goto done;
+    }
+
+    if (!write_at(file, file_size, chapters_element.data.array, chapters_element.data.num)) {
+        error = "write failed";
+        goto done;
+    }
+    *written += chapters_element.data.num;
+
+    if (patch_segment) {
+        uint8_t size_field[8];
+        store_be(size_field, segment_size | (1ULL << (7 * segment.size_length)), segment.size_length);
+        if (!write_at(file, segment.offset + 4, size_field, (size_t)segment.size_length)) {
+            error = "write failed";
+            goto done;
+        }
+        *written += (uint64_t)segment.size_length;
+    }
+
+    if (!write_at(file, seek_head.offset, seek_region.data.array, seek_region.data.num)) {
+        error = "write failed";
+        goto done;
+    }
+    *written += seek_region.data.num;
+
+done:
+    da_free(chapters_element.data);
+    da_free(seek_region.data);
+    return error;
+}
+
+// ---------------------------------------------------------------------------
+// MP4 / QuickTime
+
+struct mp4_box {
+    int64_t offset;
+    uint64_t size;
+    uint32_t header_size;
+    char type[4];
+};
+
+static bool mp4_read_box(FILE *file, int64_t offset, int64_t end, struct mp4_box *box, bool *to_end)
+{
+    uint8_t bytes[16];
+
+    if (end - offset < 8 || !read_at(file, offset, bytes, 8)) {
+        return false;
+    }
+
+    box->offset = offset;
+    box->size = load_be(bytes, 4);
+    box->header_size = 8;
+    memcpy(box->type, bytes + 4, 4);
+    *to_end = false;
+
+    if (box->size == 1) {
+        if (end - offset < 16 || !read_at(file, offset + 8, bytes + 8, 8)) {
+            return false;
+        }
+        box->size = load_be(bytes + 8, 8);
+        box->header_size = 16;
+    } else if (box->size == 0) {
+        box->size = (uint64_t)(end - offset);
+        *to_end = true;
+    }
+
+    return box->size >= box->header_size && box->size <= (uint64_t)(end - offset);
+}
+
+// Same for a box inside a buffer (0 = size runs to the end of the parent)
+static bool mp4_parse_box(const uint8_t *data, size_t offset, size_t end, struct mp4_box *box)
+{
+    if (end - offset < 8) {
+        return false;
+    }
+
+    box->offset = (int64_t)offset;
+    box->size = load_be(data + offset, 4);
+    box->header_size = 8;
+    memcpy(box->type, data + offset + 4, 4);
+
+    if (box->size == 1) {
+        if (end - offset < 16) {
+            return false;
+        }
+        box->size = load_be(data + offset + 8, 8);
+        box->header_size = 16;
+    } else if (box->size == 0) {
+        box->size = end - offset;
+    }
+
+    return box->size >= box->header_size && box->size <= end - offset;
+}
+
+// Nero chapter list, the layout libavformat reads and writes:
+// version 1, flags, 4 reserved bytes, count, then per chapter the start in
+// 100 ns units and a length-prefixed title
+static void mp4_build_chpl(struct byte_buffer *buffer, const struct chapter *chapters, size_t count)
+{
+    size_t start = buffer->data.num;
+
+    put_be(buffer, 0, 4);
+    put_bytes(buffer, "chpl", 4);
+    put_be(buffer, 0x01000000, 4);
+    put_be(buffer, 0, 4);
+    put_be(buffer, count, 1);
+
+    for (size_t i = 0; i < count; i++) {
+        put_be(buffer, chapters[i].start_ns / 100, 8);
+        put_be(buffer, chapters[i].title_len, 1);
+        put_bytes(buffer, chapters[i].title, chapters[i].title_len);
+    }
+
+    store_be(buffer->data.array + start, buffer->data.num - start, 4);
+}
+
+static const char *write_mp4_chapters(FILE *file, int64_t file_size, const struct chapter *chapters, size_t count,
+                                      uint64_t *written)
+{
+    struct mp4_box box, moov = {0};
+    bool have_moov = false, to_end;
+
+    for (int64_t position = 0; position < file_size; position += (int64_t)box.size) {
+        if (!mp4_read_box(file, position, file_size, &box, &to_end)) {
+            return "damaged box structure";
+        }
+        if (to_end) {
+            return "a box without a size (unfinished recording?)";
+        }
+        if (!have_moov && memcmp(box.type, "moov", 4) == 0) {
+            moov = box;
+            have_moov = true;
+        }
+    }
+
+    if (!have_moov) {
+        return "no moov box";
+    }
+    if (moov.size > MP4_MOOV_MAX_SIZE) {
+        return "moov box too large";
+    }
+
+    struct byte_buffer moov_data = {0};
+    struct byte_buffer chpl = {0};
+    struct byte_buffer output = {0};
+    const char *error = NULL;
+
+    da_resize(moov_data.data, (size_t)moov.size);
+    if (!read_at(file, moov.offset, moov_data.data.array, moov_data.data.num)) {
+        error = "could not read moov";
+        goto done;
+    }
+
+    // Find udta and make sure this isn't a fragmented file (its moov doesn't
+    // describe the samples, and the fragments follow it)
+    struct mp4_box child, udta = {0};
+    bool have_udta = false;
+
+    for (size_t position = moov.header_size; position < moov_data.data.num; position += (size_t)child.size) {
+        if (!mp4_parse_box(moov_data.data.array, position, moov_data.data.num, &child)) {
+            error = "damaged moov box";
+            goto done;
+        }
+        if (memcmp(child.type, "mvex", 4) == 0) {
+            error = "fragmented MP4";
+            goto done;
+        }
+        if (!have_udta && memcmp(child.type, "udta", 4) == 0) {
+            udta = child;
+            have_udta = true;
+        }
+    }
+
+    if (have_udta) {
+        size_t udta_end = (size_t)udta.offset + (size_t)udta.size;
+        for (size_t position = (size_t)udta.offset + udta.header_size; position < udta_end;
+             position += (size_t)child.size) {
+            if (!mp4_parse_box(moov_data.data.array, position, udta_end, &child)) {
+                break;
+            }
+            if (memcmp(child.type, "chpl", 4) == 0) {
+                error = "the file already has chapters";
+                goto done;
+            }
+        }
+    }
+
+    mp4_build_chpl(&chpl, chapters, count);
+
+    size_t udta_header = have_udta ? 0 : 8;
+    uint64_t moov_size = moov.size + udta_header + chpl.data.num;
+    bool udta_last = !have_udta || (uint64_t)udta.offset + udta.size == moov.size;
+
+    if (moov.offset + (int64_t)moov.size == file_size && moov.header_size == 8 && udta_last &&
+        (!have_udta || udta.header_size == 8) && moov_size <= UINT32_MAX) {
+        // moov is the last box: grow it (and udta) in place
+        if (!have_udta) {
+            put_be(&output, 8 + chpl.data.num, 4);
+            put_bytes(&output, "udta", 4);
+        }
+        put_bytes(&output, chpl.data.array, chpl.data.num);
+
+        if (!write_at(file, file_size, output.data.array, output.data.num)) {
+            error = "write failed";
+            goto done;
+        }
+        *written += output.data.num;
+
+        uint8_t size_field[4];
+        if (have_udta) {
+            store_be(size_field, udta.size + chpl.data.num, 4);
+            if (!write_at(file, moov.offset + udta.offset, size_field, 4)) {
+                error = "write failed";
+                goto done;
+            }
+            *written += 4;
+        }
+
+        store_be(size_field, moov_size, 4);
+        if (!write_at(file, moov.offset, size_field, 4)) {
+            error = "write failed";
+            goto done;
+        }
+        *written += 4;
+        goto done;
+    }
+
+    // moov sits in front of the media data: write an extended copy at the end
+    // of the file, then turn the old one into a free box. mdat doesn't move,
+    // so the chunk offsets in the copy are still right.
+    moov_size = 8 + (moov.size - moov.header_size) + chpl.data.num + udta_header;
+    if (have_udta) {
+        moov_size -= udta.header_size - 8;
+    }
+    if (moov_size > UINT32_MAX) {
+        error = "moov box too large";
+        goto done;
+    }
+
+    put_be(&output, moov_size, 4);
+    put_bytes(&output, "moov", 4);
+
+    for (size_t position = moov.header_size; position < moov_data.data.num; position += (size_t)child.size) {
+        mp4_parse_box(moov_data.data.array, position, moov_data.data.num, &child);
+
+        if (have_udta && child.offset == udta.offset) {
+            put_be(&output, 8 + (child.size - child.header_size) + chpl.data.num, 4);
+            put_bytes(&output, "udta", 4);
+            put_bytes(&output, moov_data.data.array + position + child.header_size,
+                      (size_t)(child.size - child.header_size));
+            put_bytes(&output, chpl.data.array, chpl.data.num);
+        } else {
+            put_bytes(&output, moov_data.data.array + position, (size_t)child.size);
+        }
+    }
+
+    if (!have_udta) {
+        put_be(&output, 8 + chpl.data.num, 4);
+        put_bytes(&output, "udta", 4);
+        put_bytes(&output, chpl.data.array, chpl.data.num);
+    }
+
+    if (!write_at(file, file_size, output.data.array, output.data.num)) {
+        error = "write failed";
+        goto done;
+    }
+    *written += output.data.num;
+
+    // The copy must be on disk before the original stops being a moov
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+
+    if (!write_at(file, moov.offset + 4, "free", 4)) {
+        error = "write failed";
+        goto done;
+    }
+    *written += 4;
+
+done:
+    da_free(moov_data.data);
+    da_free(chpl.data);
+    da_free(output.data);
+    return error;
+}
+
+// ---------------------------------------------------------------------------
+
+enum container {
+    CONTAINER_UNSUPPORTED,
+    CONTAINER_MATROSKA,
+    CONTAINER_MP4,
+};
+
+static enum container container_from_path(const char *path)
+{
+    const char *extension = strrchr(path, '.');
+    if (!extension) {
+        return CONTAINER_UNSUPPORTED;
+    }
+    if (astrcmpi(extension, ".mkv") == 0) {
+        return CONTAINER_MATROSKA;
+    }
+    if (astrcmpi(extension, ".mp4") == 0 || astrcmpi(extension, ".mov") == 0 ||
+        astrcmpi(extension, ".m4v") == 0) {
+        return CONTAINER_MP4;
+    }
+    return CONTAINER_UNSUPPORTED;
+}
+
+bool chapter_export_write(const char *video_path, const struct marker_store *store)
+{
+    enum container container = container_from_path(video_path);
+    if (container == CONTAINER_UNSUPPORTED) {
+        blog(LOG_INFO, "Timestamp Plugin: Chapters are only written into .mkv and .mp4/.mov recordings, "
+                       "skipping %s", video_path);
+        return false;
+    }
+
+    struct chapter *chapters;
+    size_t count = collect_chapters(store, &chapters);
+    if (count == 0) {
+        return false;
+    }
+    if (container == CONTAINER_MP4 && count > MP4_CHAPTERS_MAX) {
+        blog(LOG_WARNING, "Timestamp Plugin: MP4 chapter lists hold at most %d entries, dropping the last %zu",
+             MP4_CHAPTERS_MAX, count - MP4_CHAPTERS_MAX);
+        count = MP4_CHAPTERS_MAX;
+    }
+
+    FILE *file = os_fopen(video_path, "r+b");
+    if (!file) {
+        blog(LOG_WARNING, "Timestamp Plugin: Could not open %s to add chapters", video_path);
+        bfree(chapters);
+        return false;
+    }
+
+    uint64_t start_ns = os_gettime_ns();
+    uint64_t written = 0;
+    const char *error = "could not get the file size";
+
+    if (os_fseeki64(file, 0, SEEK_END) == 0) {
+        int64_t file_size = os_ftelli64(file);
+        if (file_size > 0) {
+            error = container == CONTAINER_MATROSKA ? write_mkv_chapters(file, file_size, chapters, count, &written)
+                                                     : write_mp4_chapters(file, file_size, chapters, count, &written);
+        }
+    }
+
+    if (!error) {
+#ifdef _WIN32
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+    }
+    if (fclose(file) != 0 && !error) {
+        error = "write failed";
+    }
+    bfree(chapters);
+
+    if (error) {
+        blog(LOG_WARNING, "Timestamp Plugin: Chapters not written into %s: %s%s", video_path, error,
+             written ? " (the file was partially updated but still plays)" : "");
+        return false;
+    }
+
+    blog(LOG_INFO, "Timestamp Plugin: Wrote %zu chapter(s) into %s (%" PRIu64 " bytes in %.1f ms)", count,
+         video_path, written, (double)(os_gettime_ns() - start_ns) / 1000000.0);
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "marker-store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Add the markers of a finished session to the recording itself as chapters,
+// without remuxing:
+//
+//   .mkv          a Chapters element is appended to the segment, and the
+//                 SeekHead entry for it goes into the space the muxer reserved
+//   .mp4 / .mov   a Nero chpl box is added to moov/udta; appended in place
+//                 when moov is the last box, otherwise moov is copied to the
+//                 end of the file and the old one becomes a free box
+//
+// Chapter titles are the marker name, or the comment when it has none. The
+// "Recording End" marker is left out. Files that already have chapters are
+// left alone. Returns false (and logs why) if the file was not changed.
+bool chapter_export_write(const char *video_path, const struct marker_store *store);
+
+#ifdef __cplusplus
+}
+#endif
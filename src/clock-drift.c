@@ -0,0 +1,221 @@
+#include "clock-drift.h"
+#include "session-log.h"
+#include <inttypes.h>
+#include <stdlib.h>
+
+void clock_drift_init(struct clock_drift *drift, const struct recording_clock *clock)
+{
+    da_init(drift->points);
+    drift->has_pending = false;
+    drift->tolerance_ns = (int64_t)recording_clock_frame_ns(clock, 1);
+    drift->samples = 0;
+    drift->min_ns = 0;
+    drift->max_ns = 0;
+
+    struct clock_drift_point *origin = da_push_back_new(drift->points);
+    origin->timestamp_ns = 0;
+    origin->drift_ns = 0;
+}
+
+void clock_drift_free(struct clock_drift *drift)
+{
+    da_free(drift->points);
+    drift->has_pending = false;
+}
+
+static int64_t distance(int64_t a, int64_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+// Drift on the straight line from a to b at timestamp_ns
+static int64_t interpolate(const struct clock_drift_point *a, const struct clock_drift_point *b,
+                           uint64_t timestamp_ns)
+{
+    if (b->timestamp_ns <= a->timestamp_ns) {
+        return b->drift_ns;
+    }
+    double t = (double)(timestamp_ns - a->timestamp_ns) / (double)(b->timestamp_ns - a->timestamp_ns);
+    return a->drift_ns + (int64_t)((double)(b->drift_ns - a->drift_ns) * t);
+}
+
+void clock_drift_add(struct clock_drift *drift, uint64_t timestamp_ns, int64_t drift_ns)
+{
+    drift->samples++;
+    if (drift_ns < drift->min_ns) {
+        drift->min_ns = drift_ns;
+    }
+    if (drift_ns > drift->max_ns) {
+        drift->max_ns = drift_ns;
+    }
+
+    struct clock_drift_point sample = {timestamp_ns, drift_ns};
+    const struct clock_drift_point *last = da_end(drift->points);
+    if (timestamp_ns <= last->timestamp_ns) {
+        return;
+    }
+
+    if (distance(drift_ns, last->drift_ns) < drift->tolerance_ns) {
+        drift->pending = sample;
+        drift->has_pending = true;
+        return;
+    }
+
+    // The sample before is the knee of the curve, unless it lies on the
+    // line from the last point to this one anyway
+    if (drift->has_pending &&
+        distance(drift->pending.drift_ns, interpolate(last, &sample, drift->pending.timestamp_ns)) >=
+            drift->tolerance_ns) {
+        da_push_back(drift->points, &drift->pending);
+    }
+    da_push_back(drift->points, &sample);
+    drift->has_pending = false;
+}
+
+void clock_drift_finish(struct clock_drift *drift)
+{
+    if (drift->has_pending) {
+        da_push_back(drift->points, &drift->pending);
+        drift->has_pending = false;
+    }
+}
+
+int64_t clock_drift_at(const struct clock_drift *drift, uint64_t timestamp_ns)
+{
+    const struct clock_drift_point *points = drift->points.array;
+    size_t count = drift->points.num;
+
+    if (!count) {
+        return 0;
+    }
+    if (timestamp_ns >= points[count - 1].timestamp_ns) {
+        return points[count - 1].drift_ns;
+    }
+
+    // First point after timestamp_ns; points[0] is at 0, so low >= 1
+    size_t low = 0, high = count - 1;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (points[mid].timestamp_ns <= timestamp_ns) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low ? interpolate(&points[low - 1], &points[low], timestamp_ns) : points[0].drift_ns;
+}
+
+void clock_drift_apply(const struct clock_drift *drift, const struct recording_clock *clock,
+                       struct marker_store *store)
+{
+    if (drift->points.num < 2) {
+        return;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    for (size_t i = 0; i < store->markers.num; i++) {
+        struct stored_marker *marker = &store->markers.array[i];
+
+        int64_t drift_ns = clock_drift_at(drift, marker->timestamp_ns);
+        uint64_t media_ns = marker->timestamp_ns;
+        if (drift_ns > 0) {
+            media_ns = (uint64_t)drift_ns < media_ns ? media_ns - (uint64_t)drift_ns : 0;
+        } else {
+            media_ns += (uint64_t)(-drift_ns);
+        }
+
+        // Frames move by as many as the time does, so the exact indices the
+        // writer recorded stay exact relative to each other
+        uint64_t from = recording_clock_frame(clock, marker->timestamp_ns);
+        uint64_t to = recording_clock_frame(clock, media_ns);
+        if (to <= from) {
+            marker->frame = marker->frame > from - to ? marker->frame - (from - to) : 0;
+        } else {
+            marker->frame += to - from;
+        }
+        marker->timestamp_ns = media_ns;
+    }
+    pthread_mutex_unlock(&store->mutex);
+}
+
+bool clock_drift_write(const struct clock_drift *drift, FILE *file)
+{
+    char line[SESSION_LOG_LINE_SIZE];
+    bool ok = true;
+
+    // A table that never left the origin says nothing
+    if (drift->points.num < 2) {
+        return true;
+    }
+
+    for (size_t first = 0; ok && first < drift->points.num; first += CLOCK_DRIFT_LINE_POINTS) {
+        size_t end = first + CLOCK_DRIFT_LINE_POINTS;
+        if (end > drift->points.num) {
+            end = drift->points.num;
+        }
+
+        int length = session_log_put_raw(line, sizeof(line), 0, "{\"metadata\": {\"drift\": [");
+        for (size_t i = first; i < end; i++) {
+            const struct clock_drift_point *point = &drift->points.array[i];
+            length = session_log_put_raw(line, sizeof(line), length, i > first ? ", [" : "[");
+            length = session_log_put_uint(line, sizeof(line), length, point->timestamp_ns / 1000000);
+            length = session_log_put_raw(line, sizeof(line), length, ", ");
+            length = session_log_put_int(line, sizeof(line), length, point->drift_ns / 1000);
+            length = session_log_put_raw(line, sizeof(line), length, "]");
+        }
+        length = session_log_put_raw(line, sizeof(line), length, "]}");
+        ok = session_log_write_line(file, line, length);
+    }
+    return ok;
+}
+
+void clock_drift_log(const struct clock_drift *drift)
+{
+    if (!drift->samples) {
+        return;
+    }
+
+    const struct clock_drift_point *last = da_end(drift->points);
+    double frame_ms = (double)drift->tolerance_ns / 1000000.0;
+    double final_ms = (double)last->drift_ns / 1000000.0;
+
+    blog(LOG_INFO,
+         "Timestamp Plugin: Clock drift: %" PRIu64 " sample(s), %zu table point(s), final %+.1f ms (%+.1f frames), "
+         "range %+.1f to %+.1f ms",
+         drift->samples, drift->points.num, final_ms, frame_ms > 0 ? final_ms / frame_ms : 0.0,
+         (double)drift->min_ns / 1000000.0, (double)drift->max_ns / 1000000.0);
+}
+
+bool clock_drift_parse(struct clock_drift *drift, const char *line, size_t length)
+{
+    static const char prefix[] = "{\"metadata\": {\"drift\": [";
+    const size_t prefix_length = sizeof(prefix) - 1;
+    if (length < prefix_length || memcmp(line, prefix, prefix_length) != 0) {
+        return false;
+    }
+
+    // [timestamp_ms, drift_us] pairs as clock_drift_write puts them
+    const char *end = line + length;
+    const char *p = line + prefix_length;
+    while (p < end && *p == '[') {
+        char *next;
+        long long timestamp_ms = strtoll(p + 1, &next, 10);
+        if (next >= end || *next != ',' || timestamp_ms < 0) {
+            return false;
+        }
+        long long drift_us = strtoll(next + 1, &next, 10);
+        if (next >= end || *next != ']') {
+            return false;
+        }
+
+        struct clock_drift_point *point = da_push_back_new(drift->points);
+        point->timestamp_ns = (uint64_t)timestamp_ms * 1000000ULL;
+        point->drift_ns = (int64_t)drift_us * 1000;
+
+        p = next + 1;
+        if (p + 1 < end && p[0] == ',' && p[1] == ' ') {
+            p += 2;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "marker-store.h"
+#include "recording-clock.h"
+#include <util/darray.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// How far the recorded media falls behind the clock markers are timed by.
+// Markers are placed with os_gettime_ns(), but frames the encoder skips or
+// OBS drops never make it into the file, so over hours the file gets shorter
+// than the wall time that passed and markers land late in it.
+//
+// The writer samples the recording output's frame count against the clock
+// every CLOCK_DRIFT_SAMPLE_MS. drift = clock time - media time, so a marker
+// at clock time t belongs at t - drift(t) in the file. Only the samples where
+// the drift moved by at least a frame are kept, which makes the table a
+// piecewise-linear curve within a frame of every sample, a few points for a
+// steady recording. It goes into the session log after the markers:
+//
+//   {"metadata": {"drift": [[0, 0], [3600000, 33366], [7200000, 66733]]}, "crc": ...}
+//
+// Each point is [timestamp_ms, drift_us] on the log's own timeline; long
+// tables are split across several such lines, in order.
+
+#define CLOCK_DRIFT_SAMPLE_MS 10000
+#define CLOCK_DRIFT_LINE_POINTS 64
+
+struct clock_drift_point {
+    uint64_t timestamp_ns;
+    int64_t drift_ns;
+};
+
+struct clock_drift {
+    DARRAY(struct clock_drift_point) points;
+    struct clock_drift_point pending; // last sample, kept if the next one bends the curve
+    bool has_pending;
+    int64_t tolerance_ns; // one frame
+    uint64_t samples;
+    int64_t min_ns;
+    int64_t max_ns;
+};
+
+// Start an empty table; the drift at timestamp 0 is taken as 0
+void clock_drift_init(struct clock_drift *drift, const struct recording_clock *clock);
+void clock_drift_free(struct clock_drift *drift);
+
+// Account for one sample at timestamp_ns (in increasing order)
+void clock_drift_add(struct clock_drift *drift, uint64_t timestamp_ns, int64_t drift_ns);
+
+// Keep the last sample, so the table reaches as far as the measurements did
+void clock_drift_finish(struct clock_drift *drift);
+
+// Drift at timestamp_ns, interpolated between the points around it (binary
+// search) and held flat past the last one
+int64_t clock_drift_at(const struct clock_drift *drift, uint64_t timestamp_ns);
+
+// Move every marker of a finished session to where it is in the media,
+// recomputing frames on the session's clock. Media can't fall behind faster
+// than time passes, so the markers stay in order.
+void clock_drift_apply(const struct clock_drift *drift, const struct recording_clock *clock,
+                       struct marker_store *store);
+
+// Append the table to a session log as sealed metadata lines; false on a
+// write error
+bool clock_drift_write(const struct clock_drift *drift, FILE *file);
+
+// Append the points of one such (already checked) line to the table; false
+// if the line isn't part of a drift table
+bool clock_drift_parse(struct clock_drift *drift, const char *line, size_t length);
+
+// Log the drift statistics of a session
+void clock_drift_log(const struct clock_drift *drift);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,68 @@
+#include "marker-export.h"
+#include "timestamp-plugin.h"
+
+// CMX3600 EDL holding one zero-length event per marker, with the marker in
+// the comment line the way DaVinci Resolve exports and imports timeline
+// markers:
+//
+//   001  001      V     C        00:00:15:00 00:00:15:01 00:00:15:00 00:00:15:01
+//    |C:ResolveColorBlue |M:Marker 1 |D:1
+//
+// Timecodes start at 00:00:00:00, like the Premiere sequence.
+
+struct edl_export {
+    FILE *file;
+    uint32_t timebase;
+    size_t events;
+};
+
+// Marker text on the comment line: '|' separates the fields there and the
+// line must not break
+static void write_edl_text(FILE *file, const char *text)
+{
+    for (const char *c = text; *c; c++) {
+        fputc(*c == '|' || (unsigned char)*c < 0x20 ? ' ' : *c, file);
+    }
+}
+
+static void *edl_begin(FILE *file, const struct marker_session_info *info, const struct marker_store *store)
+{
+    UNUSED_PARAMETER(store);
+
+    struct edl_export *export = bzalloc(sizeof(*export));
+    export->file = file;
+    export->timebase = marker_export_timebase(info);
+
+    fputs("TITLE: ", file);
+    write_edl_text(file, info->start_time[0] ? info->start_time : "OBS Markers");
+    fputs("\nFCM: NON-DROP FRAME\n\n", file);
+    return export;
+}
+
+static void edl_marker(void *data, const struct stored_marker *marker)
+{
+    struct edl_export *export = data;
+
+    char in[32], out[32];
+    marker_export_timecode(marker->frame, export->timebase, in, sizeof(in));
+    marker_export_timecode(marker->frame + 1, export->timebase, out, sizeof(out));
+
+    fprintf(export->file, "%03zu  001      V     C        %s %s %s %s\n", ++export->events, in, out, in, out);
+    fprintf(export->file, " |C:ResolveColor%s |M:", marker_export_resolve_color(marker->color));
+    write_edl_text(export->file, marker_export_title(marker));
+    fputs(" |D:1\n\n", export->file);
+}
+
+static bool edl_end(void *data)
+{
+    bfree(data);
+    return true;
+}
+
+const struct marker_exporter edl_exporter = {
+    .name = "edl",
+    .suffix = "_markers.edl",
+    .begin = edl_begin,
+    .marker = edl_marker,
+    .end = edl_end,
+};
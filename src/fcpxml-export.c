@@ -0,0 +1,120 @@
+#include "marker-export.h"
+#include "timestamp-plugin.h"
+#include <util/util_uint64.h>
+
+// Final Cut Pro X project (FCPXML 1.9) whose timeline is a single gap clip
+// carrying the markers, the counterpart of the Premiere generator item.
+// Times are rational seconds in units of the frame duration, so markers land
+// exactly on their frames at NTSC rates too.
+
+struct fcpxml_export {
+    FILE *file;
+    uint32_t fps_num;
+    uint32_t fps_den;
+};
+
+// Attribute value with XML escaping; line breaks are kept as references
+static void write_attribute(FILE *file, const char *name, const char *value)
+{
+    fprintf(file, " %s=\"", name);
+    for (const char *c = value; *c; c++) {
+        switch (*c) {
+        case '&': fputs("&amp;", file); break;
+        case '<': fputs("&lt;", file); break;
+        case '>': fputs("&gt;", file); break;
+        case '"': fputs("&quot;", file); break;
+        case '\n': fputs("&#10;", file); break;
+        case '\r': fputs("&#13;", file); break;
+        case '\t': fputs("&#9;", file); break;
+        default:
+            // Invalid in XML 1.0 even as a reference
+            if ((unsigned char)*c >= 0x20) {
+                fputc(*c, file);
+            }
+            break;
+        }
+    }
+    fputc('"', file);
+}
+
+// Time of a frame as rational seconds
+static void write_time(FILE *file, const char *name, const struct fcpxml_export *export, uint64_t frames)
+{
+    if (!frames) {
+        fprintf(file, " %s=\"0s\"", name);
+        return;
+    }
+    fprintf(file, " %s=\"%" PRIu64 "/%us\"", name, frames * export->fps_den, export->fps_num);
+}
+
+static void *fcpxml_begin(FILE *file, const struct marker_session_info *info, const struct marker_store *store)
+{
+    struct fcpxml_export *export = bzalloc(sizeof(*export));
+    export->file = file;
+    export->fps_num = info->fps_num ? info->fps_num : 60;
+    export->fps_den = info->fps_den ? info->fps_den : 1;
+
+    // Last marker + 60 seconds, like the Premiere sequence
+    uint64_t max_frame = 0;
+    for (size_t i = 0; i < store->markers.num; i++) {
+        if (store->markers.array[i].frame > max_frame) {
+            max_frame = store->markers.array[i].frame;
+        }
+    }
+    uint64_t duration = max_frame + util_mul_div64(60, export->fps_num, export->fps_den);
+
+    const char *name = info->start_time[0] ? info->start_time : "OBS Markers";
+
+    fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", file);
+    fputs("<!DOCTYPE fcpxml>\n", file);
+    fputs("<fcpxml version=\"1.9\">\n", file);
+    fputs("  <resources>\n", file);
+    fprintf(file, "    <format id=\"r1\" frameDuration=\"%u/%us\" width=\"%u\" height=\"%u\"/>\n", export->fps_den,
+            export->fps_num, info->width ? info->width : 1920, info->height ? info->height : 1080);
+    fputs("  </resources>\n", file);
+    fputs("  <library>\n", file);
+    fputs("    <event", file);
+    write_attribute(file, "name", "OBS Markers");
+    fputs(">\n      <project", file);
+    write_attribute(file, "name", name);
+    fputs(">\n        <sequence format=\"r1\" tcStart=\"0s\" tcFormat=\"NDF\"", file);
+    write_time(file, "duration", export, duration);
+    fputs(">\n          <spine>\n            <gap name=\"OBS Marker Holder\" offset=\"0s\" start=\"0s\"", file);
+    write_time(file, "duration", export, duration);
+    fputs(">\n", file);
+    return export;
+}
+
+static void fcpxml_marker(void *data, const struct stored_marker *marker)
+{
+    struct fcpxml_export *export = data;
+    FILE *file = export->file;
+
+    fputs("              <marker", file);
+    write_time(file, "start", export, marker->frame);
+    write_time(file, "duration", export, 1);
+    write_attribute(file, "value", marker_export_title(marker));
+    if (marker->name[0] && marker->comment[0]) {
+        write_attribute(file, "note", marker->comment);
+    }
+    fputs("/>\n", file);
+}
+
+static bool fcpxml_end(void *data)
+{
+    struct fcpxml_export *export = data;
+
+    fputs("            </gap>\n          </spine>\n        </sequence>\n      </project>\n    </event>\n"
+          "  </library>\n</fcpxml>\n",
+          export->file);
+    bfree(export);
+    return true;
+}
+
+const struct marker_exporter fcpxml_exporter = {
+    .name = "fcpxml",
+    .suffix = "_markers.fcpxml",
+    .begin = fcpxml_begin,
+    .marker = fcpxml_marker,
+    .end = fcpxml_end,
+};
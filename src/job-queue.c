@@ -0,0 +1,184 @@
+#include "job-queue.h"
+#include <util/platform.h>
+#include <util/threading.h>
+
+// Number of worker threads; two lets an export overlap a slow conversion
+#define JOB_QUEUE_WORKERS 2
+
+struct job {
+    char name[64];
+    job_func_t func;
+    job_func_t free_func;
+    void *data;
+    uint64_t queued_ns;
+    struct job *next;
+};
+
+static pthread_mutex_t job_mutex;
+static os_sem_t *job_sem = NULL;
+static pthread_t workers[JOB_QUEUE_WORKERS];
+static size_t worker_count = 0;
+static struct job *job_head = NULL;
+static struct job *job_tail = NULL;
+static bool queue_running = false;
+static bool queue_stopping = false;
+static long jobs_pending = 0;
+
+// Take the oldest job, or NULL when the queue is shutting down and empty
+static struct job *pop_job(void)
+{
+    for (;;) {
+        os_sem_wait(job_sem);
+
+        pthread_mutex_lock(&job_mutex);
+        struct job *job = job_head;
+        if (job) {
+            job_head = job->next;
+            if (!job_head) {
+                job_tail = NULL;
+            }
+            jobs_pending--;
+        }
+        bool stopping = queue_stopping;
+        pthread_mutex_unlock(&job_mutex);
+
+        if (job || stopping) {
+            return job;
+        }
+    }
+}
+
+static void *job_worker_func(void *data)
+{
+    UNUSED_PARAMETER(data);
+
+    os_set_thread_name("timestamp-jobs");
+
+    struct job *job;
+    while ((job = pop_job()) != NULL) {
+        uint64_t start_ns = os_gettime_ns();
+        job->func(job->data);
+        uint64_t end_ns = os_gettime_ns();
+
+        blog(LOG_INFO, "Timestamp Plugin: Job '%s' completed in %.1fms (queued for %.1fms)",
+             job->name,
+             (double)(end_ns - start_ns) / 1000000.0,
+             (double)(start_ns - job->queued_ns) / 1000000.0);
+
+        if (job->free_func) {
+            job->free_func(job->data);
+        }
+        bfree(job);
+    }
+
+    return NULL;
+}
+
+bool job_queue_start(void)
+{
+    if (queue_running) {
+        return true;
+    }
+
+    if (pthread_mutex_init(&job_mutex, NULL) != 0) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to create job queue mutex");
+        return false;
+    }
+
+    if (os_sem_init(&job_sem, 0) != 0) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to create job queue semaphore");
+        pthread_mutex_destroy(&job_mutex);
+        return false;
+    }
+
+    queue_stopping = false;
+    jobs_pending = 0;
+    worker_count = 0;
+
+    for (size_t i = 0; i < JOB_QUEUE_WORKERS; i++) {
+        if (pthread_create(&workers[worker_count], NULL, job_worker_func, NULL) != 0) {
+            blog(LOG_WARNING, "Timestamp Plugin: Failed to start job worker %zu", i);
+            continue;
+        }
+        worker_count++;
+    }
+
+    if (!worker_count) {
+        blog(LOG_ERROR, "Timestamp Plugin: No job workers could be started");
+        os_sem_destroy(job_sem);
+        job_sem = NULL;
+        pthread_mutex_destroy(&job_mutex);
+        return false;
+    }
+
+    queue_running = true;
+    blog(LOG_INFO, "Timestamp Plugin: Job queue started (%zu worker(s))", worker_count);
+    return true;
+}
+
+void job_queue_stop(void)
+{
+    if (!queue_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&job_mutex);
+    long pending = jobs_pending;
+    queue_stopping = true;
+    pthread_mutex_unlock(&job_mutex);
+
+    if (pending > 0) {
+        blog(LOG_INFO, "Timestamp Plugin: Waiting for %ld background job(s) to finish", pending);
+    }
+
+    // Wake every worker; each exits once the queue is empty
+    for (size_t i = 0; i < worker_count; i++) {
+        os_sem_post(job_sem);
+    }
+    for (size_t i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    os_sem_destroy(job_sem);
+    job_sem = NULL;
+    pthread_mutex_destroy(&job_mutex);
+    worker_count = 0;
+    queue_running = false;
+
+    blog(LOG_INFO, "Timestamp Plugin: Job queue stopped");
+}
+
+bool job_queue_push(const char *name, job_func_t func, job_func_t free_func, void *data)
+{
+    if (!queue_running) {
+        return false;
+    }
+
+    struct job *job = bzalloc(sizeof(*job));
+    snprintf(job->name, sizeof(job->name), "%s", name);
+    job->func = func;
+    job->free_func = free_func;
+    job->data = data;
+    job->queued_ns = os_gettime_ns();
+
+    pthread_mutex_lock(&job_mutex);
+    if (queue_stopping) {
+        pthread_mutex_unlock(&job_mutex);
+        bfree(job);
+        return false;
+    }
+
+    if (job_tail) {
+        job_tail->next = job;
+    } else {
+        job_head = job;
+    }
+    job_tail = job;
+    long pending = ++jobs_pending;
+    pthread_mutex_unlock(&job_mutex);
+
+    os_sem_post(job_sem);
+
+    blog(LOG_INFO, "Timestamp Plugin: Job '%s' queued (%ld pending)", name, pending);
+    return true;
+}
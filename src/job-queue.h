@@ -0,0 +1,25 @@
+#pragma once
+
+#include <obs-module.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Background queue for post-recording work (exports, conversions, sidecars).
+// Jobs run on worker threads so the UI and writer threads never wait on them.
+typedef void (*job_func_t)(void *data);
+
+bool job_queue_start(void);
+
+// Runs every job still queued, then joins the worker threads
+void job_queue_stop(void);
+
+// Queue func(data) to run in the background. free_func (optional) is called
+// with data once the job has run. Returns false if the queue isn't running,
+// in which case the caller still owns data.
+bool job_queue_push(const char *name, job_func_t func, job_func_t free_func, void *data);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,214 @@
+#include "marker-api.h"
+#include "marker-stats.h"
+#include "marker-store.h"
+#include "timestamp-plugin.h"
+
+#define MARKER_API_VENDOR "timestamp-marker"
+
+// obs-websocket's vendor interface, reached through the proc handler it
+// publishes; these are the calls obs-websocket-api.h wraps
+typedef void (*vendor_request_callback)(obs_data_t *request, obs_data_t *response, void *param);
+
+struct vendor_request {
+    vendor_request_callback callback;
+    void *param;
+};
+
+static void add_markers(obs_data_t *request, obs_data_t *response)
+{
+    obs_data_array_t *array = request ? obs_data_get_array(request, "markers") : NULL;
+    size_t count = array ? obs_data_array_count(array) : 0;
+
+    if (count == 0 || count > MARKER_API_MAX_MARKERS) {
+        obs_data_set_string(response, "error", count ? "Too many markers in one request" : "No markers given");
+        obs_data_set_int(response, "added", 0);
+        obs_data_set_int(response, "dropped", (long long)count);
+        obs_data_array_release(array);
+        return;
+    }
+
+    // The items own the strings the requests point to until the batch is queued
+    struct timestamp_request *requests = bzalloc(sizeof(*requests) * count);
+    obs_data_t **items = bzalloc(sizeof(*items) * count);
+
+    for (size_t i = 0; i < count; i++) {
+        obs_data_t *item = obs_data_array_item(array, i);
+        items[i] = item;
+        if (!item) {
+            continue;
+        }
+
+        long long timestamp_ms = obs_data_get_int(item, "timestamp_ms");
+        requests[i].has_timestamp = obs_data_has_user_value(item, "timestamp_ms");
+        requests[i].timestamp_ms = timestamp_ms > 0 ? (uint64_t)timestamp_ms : 0;
+        requests[i].offset_ms = (int64_t)obs_data_get_int(item, "offset_ms");
+        requests[i].comment = obs_data_get_string(item, "comment");
+        requests[i].name = obs_data_get_string(item, "name");
+        requests[i].color = obs_data_get_string(item, "color");
+    }
+
+    size_t added = save_timestamps(requests, count);
+
+    for (size_t i = 0; i < count; i++) {
+        obs_data_release(items[i]);
+    }
+    bfree(items);
+    bfree(requests);
+    obs_data_array_release(array);
+
+    if (added == 0) {
+        obs_data_set_string(response, "error", "Not recording, or the marker queue is full");
+    }
+    obs_data_set_int(response, "added", (long long)added);
+    obs_data_set_int(response, "dropped", (long long)(count - added));
+}
+
+static void get_markers(obs_data_t *request, obs_data_t *response)
+{
+    uint64_t start_ms = 0;
+    uint64_t end_ms = UINT64_MAX / 1000000 - 1;
+
+    if (request && obs_data_has_user_value(request, "start_ms") && obs_data_get_int(request, "start_ms") > 0) {
+        start_ms = (uint64_t)obs_data_get_int(request, "start_ms");
+    }
+    if (request && obs_data_has_user_value(request, "end_ms") && obs_data_get_int(request, "end_ms") >= 0) {
+        end_ms = (uint64_t)obs_data_get_int(request, "end_ms");
+    }
+
+    // One more than fits tells a full answer from a cut one
+    struct marker_record *markers = bmalloc(sizeof(*markers) * (MARKER_API_MAX_MARKERS + 1));
+    size_t count = start_ms <= end_ms ? timestamp_marker_copy(start_ms, end_ms + 1, markers, MARKER_API_MAX_MARKERS + 1)
+                                      : 0;
+    bool truncated = count > MARKER_API_MAX_MARKERS;
+    if (truncated) {
+        count = MARKER_API_MAX_MARKERS;
+    }
+
+    obs_data_array_t *array = obs_data_array_create();
+    for (size_t i = 0; i < count; i++) {
+        obs_data_t *item = obs_data_create();
+        obs_data_set_int(item, "timestamp_ms", (long long)markers[i].timestamp_ms);
+        obs_data_set_int(item, "frame", (long long)markers[i].frame);
+        obs_data_set_string(item, "comment", markers[i].comment);
+        obs_data_set_string(item, "name", markers[i].name);
+        obs_data_set_string(item, "color", markers[i].color);
+        obs_data_set_int(item, "count", markers[i].count > 1 ? markers[i].count : 1);
+        obs_data_array_push_back(array, item);
+        obs_data_release(item);
+    }
+    bfree(markers);
+
+    uint64_t segment_start_ms = 0;
+    uint32_t segment = timestamp_marker_segment(&segment_start_ms);
+    obs_data_set_int(response, "segment", segment);
+    obs_data_set_int(response, "segment_start_ms", (long long)segment_start_ms);
+    obs_data_set_array(response, "markers", array);
+    obs_data_set_bool(response, "truncated", truncated);
+    obs_data_array_release(array);
+}
+
+// Proc handler side: JSON text in, JSON text out
+static void call_with_json(calldata_t *cd, void (*handler)(obs_data_t *, obs_data_t *))
+{
+    const char *json = calldata_string(cd, "json");
+    obs_data_t *request = json && *json ? obs_data_create_from_json(json) : NULL;
+    obs_data_t *response = obs_data_create();
+
+    handler(request, response);
+    calldata_set_string(cd, "result", obs_data_get_json(response));
+
+    obs_data_release(response);
+    obs_data_release(request);
+}
+
+static void proc_add_markers(void *param, calldata_t *cd)
+{
+    UNUSED_PARAMETER(param);
+    call_with_json(cd, add_markers);
+}
+
+static void proc_get_markers(void *param, calldata_t *cd)
+{
+    UNUSED_PARAMETER(param);
+    call_with_json(cd, get_markers);
+}
+
+void marker_api_register_procs(void)
+{
+    proc_handler_t *ph = obs_get_proc_handler();
+    if (!ph) {
+        return;
+    }
+
+    proc_handler_add(ph, "void timestamp_add_markers(in string json, out string result)", proc_add_markers, NULL);
+    proc_handler_add(ph, "void timestamp_get_markers(in string json, out string result)", proc_get_markers, NULL);
+}
+
+// obs-websocket side: it hands over its own request and response objects
+static void vendor_add_markers(obs_data_t *request, obs_data_t *response, void *param)
+{
+    UNUSED_PARAMETER(param);
+    add_markers(request, response);
+}
+
+static void vendor_get_markers(obs_data_t *request, obs_data_t *response, void *param)
+{
+    UNUSED_PARAMETER(param);
+    get_markers(request, response);
+}
+
+// obs-websocket keeps these for as long as it runs
+static struct vendor_request add_markers_request = {vendor_add_markers, NULL};
+static struct vendor_request get_markers_request = {vendor_get_markers, NULL};
+
+static bool register_vendor_request(proc_handler_t *ph, void *vendor, const char *type, struct vendor_request *request)
+{
+    calldata_t cd = {0};
+    calldata_set_string(&cd, "type", type);
+    calldata_set_ptr(&cd, "callback", request);
+    calldata_set_ptr(&cd, "vendor", vendor);
+
+    bool ok = proc_handler_call(ph, "vendor_request_register", &cd) && calldata_bool(&cd, "success");
+    calldata_free(&cd);
+
+    if (!ok) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to register obs-websocket request %s", type);
+    }
+    return ok;
+}
+
+void marker_api_register_vendor(void)
+{
+    proc_handler_t *global = obs_get_proc_handler();
+    if (!global) {
+        return;
+    }
+
+    calldata_t cd = {0};
+    proc_handler_t *ph = NULL;
+    if (proc_handler_call(global, "obs_websocket_api_get_ph", &cd)) {
+        ph = calldata_ptr(&cd, "ph");
+    }
+    calldata_free(&cd);
+
+    if (!ph) {
+        blog(LOG_INFO, "Timestamp Plugin: obs-websocket not loaded, vendor requests not available");
+        return;
+    }
+
+    // calldata_free leaves cd unusable, so the registration gets its own
+    calldata_t vendor_cd = {0};
+    calldata_set_string(&vendor_cd, "name", MARKER_API_VENDOR);
+    void *vendor = proc_handler_call(ph, "vendor_register", &vendor_cd) ? calldata_ptr(&vendor_cd, "vendor") : NULL;
+    calldata_free(&vendor_cd);
+
+    if (!vendor) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to register obs-websocket vendor %s", MARKER_API_VENDOR);
+        return;
+    }
+
+    if (register_vendor_request(ph, vendor, "AddMarkers", &add_markers_request) &&
+        register_vendor_request(ph, vendor, "GetMarkers", &get_markers_request)) {
+        blog(LOG_INFO, "Timestamp Plugin: obs-websocket vendor %s registered", MARKER_API_VENDOR);
+    }
+}
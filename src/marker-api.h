@@ -0,0 +1,44 @@
+#pragma once
+
+#include <obs-module.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Markers for other programs: stream decks, show controllers, score feeds.
+// The same two requests are offered two ways, both taking and returning
+// JSON objects:
+//
+//   libobs proc handler (scripts and other plugins):
+//     void timestamp_add_markers(in string json, out string result)
+//     void timestamp_get_markers(in string json, out string result)
+//
+//   obs-websocket vendor "timestamp-marker" (remote clients):
+//     AddMarkers, GetMarkers
+//
+// AddMarkers takes {"markers": [{"comment": ..., "name": ..., "color": ...,
+// "timestamp_ms": ... or "offset_ms": ...}, ...]}; every field is optional.
+// timestamp_ms is on the recording timeline, offset_ms is relative to now,
+// and without either the marker lands at the time of the request. The whole
+// array goes into the writer queue in one push and answers {"added": n,
+// "dropped": n}.
+//
+// GetMarkers takes {"start_ms": ..., "end_ms": ...} (both optional, end
+// inclusive) and answers {"segment": ..., "segment_start_ms": ..., "markers":
+// [...], "truncated": bool} with the markers of the file being recorded,
+// timed from its start like its session log.
+
+// Most markers one request adds or returns (a full marker queue)
+#define MARKER_API_MAX_MARKERS 1024
+
+// Register the proc handler calls; at module load
+void marker_api_register_procs(void);
+
+// Register the obs-websocket vendor and its requests, if obs-websocket is
+// loaded; from obs_module_post_load, once every module has loaded
+void marker_api_register_vendor(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,261 @@
+#include "marker-broadcast.h"
+#include "session-log.h"
+#include "timestamp-plugin.h"
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET broadcast_socket_t;
+#define BROADCAST_INVALID_SOCKET INVALID_SOCKET
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int broadcast_socket_t;
+#define BROADCAST_INVALID_SOCKET (-1)
+#endif
+
+// Fits an Ethernet frame without IP fragmentation
+#define BROADCAST_MAX_DATAGRAM 1472
+
+// Multicast hop limit: the local network, not beyond the first router
+#define BROADCAST_MULTICAST_TTL 1
+
+// Room for a burst of datagrams while the network stack catches up
+#define BROADCAST_SEND_BUFFER (256 * 1024)
+
+struct marker_broadcast {
+    broadcast_socket_t socket;
+    struct sockaddr_in target;
+    char address[64];
+    char session[128];
+    long generation;
+    uint64_t sent;
+    uint64_t failed;
+
+    // Every datagram is formatted here, once, and sent from here
+    char buffer[BROADCAST_MAX_DATAGRAM];
+};
+
+static void close_socket(broadcast_socket_t socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+    WSACleanup();
+#else
+    close(socket);
+#endif
+}
+
+static bool set_nonblocking(broadcast_socket_t socket)
+{
+#ifdef _WIN32
+    u_long enabled = 1;
+    return ioctlsocket(socket, FIONBIO, &enabled) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// "a.b.c.d[:port]" -> target
+static bool parse_address(const char *address, struct sockaddr_in *target)
+{
+    char host[64];
+    snprintf(host, sizeof(host), "%s", address);
+
+    unsigned long port = MARKER_BROADCAST_DEFAULT_PORT;
+    char *colon = strrchr(host, ':');
+    if (colon) {
+        char *end;
+        *colon = '\0';
+        port = strtoul(colon + 1, &end, 10);
+        if (*end || port == 0 || port > 65535) {
+            return false;
+        }
+    }
+
+    memset(target, 0, sizeof(*target));
+    target->sin_family = AF_INET;
+    target->sin_port = htons((unsigned short)port);
+    return inet_pton(AF_INET, host, &target->sin_addr) == 1;
+}
+
+// Unix time in microseconds of a moment taken with os_gettime_ns()
+static int64_t unix_us(uint64_t monotonic_ns)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    int64_t now_us = (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    return now_us - (int64_t)((os_gettime_ns() - monotonic_ns) / 1000);
+}
+
+// Session name as the receivers see it: the log's file name without extension
+static void session_name_from_path(const char *path, char *buffer, size_t size)
+{
+    const char *name = session_log_file_name(path);
+    size_t len = session_log_stem_length(path) - (size_t)(name - path);
+
+    // A name that is all extension stays whole
+    snprintf(buffer, size, "%.*s", (int)(len ? len : strlen(name)), name);
+}
+
+static void send_datagram(struct marker_broadcast *broadcast, int length)
+{
+    if (length <= 0 || length >= (int)sizeof(broadcast->buffer)) {
+        broadcast->failed++;
+        return;
+    }
+
+    int sent = (int)sendto(broadcast->socket, broadcast->buffer, length, 0,
+                           (const struct sockaddr *)&broadcast->target, sizeof(broadcast->target));
+    if (sent == length) {
+        broadcast->sent++;
+    } else {
+        broadcast->failed++;
+    }
+}
+
+// Datagrams are built with the session log's serializer, so strings are
+// escaped the same way
+static int put_field(struct marker_broadcast *broadcast, int length, const char *key)
+{
+    return session_log_put_raw(broadcast->buffer, sizeof(broadcast->buffer), length, key);
+}
+
+static int put_string(struct marker_broadcast *broadcast, int length, const char *value)
+{
+    return session_log_put_string(broadcast->buffer, sizeof(broadcast->buffer), length, value);
+}
+
+static int put_int(struct marker_broadcast *broadcast, int length, int64_t value)
+{
+    return session_log_put_int(broadcast->buffer, sizeof(broadcast->buffer), length, value);
+}
+
+// Every datagram starts with the event and the session it belongs to
+static int put_header(struct marker_broadcast *broadcast, const char *event)
+{
+    int length = put_field(broadcast, 0, "{\"event\": ");
+    length = put_string(broadcast, length, event);
+    length = put_field(broadcast, length, ", \"session\": ");
+    length = put_string(broadcast, length, broadcast->session);
+    length = put_field(broadcast, length, ", \"generation\": ");
+    return put_int(broadcast, length, broadcast->generation);
+}
+
+static void send_event(struct marker_broadcast *broadcast, const char *event)
+{
+    int length = put_header(broadcast, event);
+    length = put_field(broadcast, length, ", \"sent_us\": ");
+    length = put_int(broadcast, length, unix_us(os_gettime_ns()));
+    length = put_field(broadcast, length, "}");
+    send_datagram(broadcast, length);
+}
+
+struct marker_broadcast *marker_broadcast_open(const char *address, const struct marker_session_info *info)
+{
+    struct sockaddr_in target;
+    if (!parse_address(address, &target)) {
+        blog(LOG_WARNING, "Timestamp Plugin: Invalid BroadcastAddress '%s' (expected a.b.c.d:port)", address);
+        return NULL;
+    }
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        blog(LOG_WARNING, "Timestamp Plugin: Could not initialize Winsock for the marker broadcast");
+        return NULL;
+    }
+#endif
+
+    broadcast_socket_t socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (socket_fd == BROADCAST_INVALID_SOCKET) {
+        blog(LOG_WARNING, "Timestamp Plugin: Could not create the marker broadcast socket");
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return NULL;
+    }
+
+    if (!set_nonblocking(socket_fd)) {
+        blog(LOG_WARNING, "Timestamp Plugin: Could not make the marker broadcast socket non-blocking");
+        close_socket(socket_fd);
+        return NULL;
+    }
+
+    int send_buffer = BROADCAST_SEND_BUFFER;
+    setsockopt(socket_fd, SOL_SOCKET, SO_SNDBUF, (const char *)&send_buffer, sizeof(send_buffer));
+
+    // 224.0.0.0/4; loopback stays on (the default) for receivers on this machine
+    if ((ntohl(target.sin_addr.s_addr) & 0xF0000000u) == 0xE0000000u) {
+#ifdef _WIN32
+        DWORD ttl = BROADCAST_MULTICAST_TTL;
+#else
+        unsigned char ttl = BROADCAST_MULTICAST_TTL;
+#endif
+        setsockopt(socket_fd, IPPROTO_IP, IP_MULTICAST_TTL, (const char *)&ttl, sizeof(ttl));
+    }
+
+    struct marker_broadcast *broadcast = bzalloc(sizeof(*broadcast));
+    broadcast->socket = socket_fd;
+    broadcast->target = target;
+    broadcast->generation = info->generation;
+    snprintf(broadcast->address, sizeof(broadcast->address), "%s", address);
+    session_name_from_path(info->path, broadcast->session, sizeof(broadcast->session));
+
+    send_event(broadcast, "begin");
+
+    blog(LOG_INFO, "Timestamp Plugin: Broadcasting markers to %s", broadcast->address);
+    return broadcast;
+}
+
+void marker_broadcast_marker(struct marker_broadcast *broadcast, const struct marker_record *record)
+{
+    uint64_t now_ns = os_gettime_ns();
+
+    // Markers the writer creates itself are "pressed" as they are written
+    uint64_t pressed_ns = record->queued_ns ? record->queued_ns : now_ns;
+    int64_t sent_us = unix_us(now_ns);
+    int64_t latency_us = (int64_t)((now_ns - pressed_ns) / 1000);
+
+    int length = put_header(broadcast, "marker");
+    length = put_field(broadcast, length, ", \"timestamp_ms\": ");
+    length = put_int(broadcast, length, (int64_t)record->timestamp_ms);
+    length = put_field(broadcast, length, ", \"frame\": ");
+    length = put_int(broadcast, length, (int64_t)record->frame);
+    length = put_field(broadcast, length, ", \"comment\": ");
+    length = put_string(broadcast, length, record->comment);
+    length = put_field(broadcast, length, ", \"name\": ");
+    length = put_string(broadcast, length, record->name);
+    length = put_field(broadcast, length, ", \"color\": ");
+    length = put_string(broadcast, length, record->color[0] ? record->color : "blue");
+    length = put_field(broadcast, length, ", \"count\": ");
+    length = put_int(broadcast, length, record->count ? record->count : 1);
+    length = put_field(broadcast, length, ", \"pressed_us\": ");
+    length = put_int(broadcast, length, sent_us - latency_us);
+    length = put_field(broadcast, length, ", \"sent_us\": ");
+    length = put_int(broadcast, length, sent_us);
+    length = put_field(broadcast, length, ", \"latency_us\": ");
+    length = put_int(broadcast, length, latency_us);
+    length = put_field(broadcast, length, "}");
+    send_datagram(broadcast, length);
+}
+
+void marker_broadcast_close(struct marker_broadcast *broadcast)
+{
+    if (!broadcast) {
+        return;
+    }
+
+    send_event(broadcast, "end");
+    close_socket(broadcast->socket);
+
+    blog(LOG_INFO, "Timestamp Plugin: Broadcast %" PRIu64 " datagram(s) to %s, %" PRIu64 " failed",
+         broadcast->sent, broadcast->address, broadcast->failed);
+    bfree(broadcast);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "marker-writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Live marker feed for other processes: every marker the writer accepts is
+// sent as one JSON datagram to a UDP address, normally a multicast group, so
+// any number of receivers subscribe by joining it and the plugin still sends
+// each datagram exactly once.
+//
+//   {"event": "marker", "session": "2024-05-01 20-15-00", "generation": 2, "timestamp_ms": 15000,
+//    "frame": 900, "comment": "Marker 1", "name": "", "color": "blue", "count": 1,
+//    "pressed_us": 1714587315000123, "sent_us": 1714587315000171, "latency_us": 48}
+//
+// "begin" and "end" events bracket each session. pressed_us and sent_us are
+// Unix times in microseconds, so a receiver can take its own clock minus
+// pressed_us for the full press-to-delivery lag; latency_us is the part spent
+// inside OBS (for a coalesced burst, from its first press to the end of its
+// window). Only the writer thread uses a broadcast, and sending never
+// blocks it: a datagram that can't go out right away is counted and dropped.
+
+// BroadcastAddress default port when the setting has none
+#define MARKER_BROADCAST_DEFAULT_PORT 41500
+
+struct marker_broadcast;
+
+// address is "a.b.c.d[:port]" (IPv4); returns NULL and logs why on failure
+struct marker_broadcast *marker_broadcast_open(const char *address, const struct marker_session_info *info);
+
+void marker_broadcast_marker(struct marker_broadcast *broadcast, const struct marker_record *record);
+
+// Sends the end event and closes the socket
+void marker_broadcast_close(struct marker_broadcast *broadcast);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,268 @@
+#include "marker-export.h"
+#include "session-log.h"
+#include "timestamp-plugin.h"
+#include <util/dstr.h>
+#include <time.h>
+
+static const struct marker_exporter *exporters[MARKER_EXPORT_COUNT] = {
+    [MARKER_EXPORT_PREMIERE] = &premiere_exporter,
+    [MARKER_EXPORT_EDL] = &edl_exporter,
+    [MARKER_EXPORT_FCPXML] = &fcpxml_exporter,
+    [MARKER_EXPORT_RESOLVE_CSV] = &resolve_csv_exporter,
+};
+
+// Video extensions the converter considers when matching a recording
+static const char *video_extensions[] = {".mp4", ".mkv", ".flv", ".mov", ".avi", ".ts"};
+
+uint32_t marker_export_parse_formats(const char *list)
+{
+    if (!list || !*list) {
+        return MARKER_EXPORT_DEFAULT;
+    }
+
+    uint32_t formats = 0;
+    const char *c = list;
+    while (*c) {
+        while (*c == ',' || *c == ' ' || *c == '\t') {
+            c++;
+        }
+        const char *start = c;
+        while (*c && *c != ',' && *c != ' ' && *c != '\t') {
+            c++;
+        }
+        if (c == start) {
+            break;
+        }
+
+        size_t len = (size_t)(c - start);
+        bool known = false;
+        for (int i = 0; i < MARKER_EXPORT_COUNT; i++) {
+            if (strlen(exporters[i]->name) == len && astrcmpi_n(start, exporters[i]->name, len) == 0) {
+                formats |= 1u << i;
+                known = true;
+            }
+        }
+        if (!known) {
+            blog(LOG_WARNING, "Timestamp Plugin: Unknown export format '%.*s' in ExportFormats", (int)len, start);
+        }
+    }
+    return formats;
+}
+
+static bool has_video_extension(const char *filename)
+{
+    const char *ext = strrchr(filename, '.');
+    if (!ext) {
+        return false;
+    }
+
+    for (size_t i = 0; i < sizeof(video_extensions) / sizeof(video_extensions[0]); i++) {
+        if (astrcmpi(ext, video_extensions[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Find the video written during this session: the newest file modified within
+// five minutes of the session start, otherwise the newest file overall
+static bool find_latest_video_file(const struct marker_session_info *info, char *buffer, size_t size)
+{
+    if (!info->recording_path[0]) {
+        return false;
+    }
+
+    os_dir_t *dir = os_opendir(info->recording_path);
+    if (!dir) {
+        return false;
+    }
+
+    char path[1024];
+    char newest[1024] = {0};
+    char closest[1024] = {0};
+    time_t newest_mtime = 0;
+    time_t closest_mtime = 0;
+    struct os_dirent *ent;
+
+    while ((ent = os_readdir(dir)) != NULL) {
+        if (ent->directory || !has_video_extension(ent->d_name)) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s", info->recording_path, ent->d_name);
+
+        struct stat st;
+        if (os_stat(path, &st) != 0) {
+            continue;
+        }
+
+        if (!newest[0] || st.st_mtime > newest_mtime) {
+            newest_mtime = st.st_mtime;
+            snprintf(newest, sizeof(newest), "%s", path);
+        }
+
+        int64_t diff = (int64_t)st.st_mtime - info->start_epoch;
+        if (diff < 0) {
+            diff = -diff;
+        }
+        if (diff < 300 && (!closest[0] || st.st_mtime > closest_mtime)) {
+            closest_mtime = st.st_mtime;
+            snprintf(closest, sizeof(closest), "%s", path);
+        }
+    }
+
+    os_closedir(dir);
+
+    const char *found = closest[0] ? closest : newest;
+    if (!found[0]) {
+        return false;
+    }
+
+    snprintf(buffer, size, "%s", found);
+    return true;
+}
+
+void marker_export_base_path(const struct marker_session_info *info, char *buffer, size_t size)
+{
+    // The frontend told us the file; only search the directory without it
+    if (info->video_path[0] && os_file_exists(info->video_path)) {
+        snprintf(buffer, size, "%s", info->video_path);
+    } else if (!find_latest_video_file(info, buffer, size)) {
+        // Fallback: next to the session log
+        snprintf(buffer, size, "%s", info->path);
+    }
+    buffer[session_log_stem_length(buffer)] = '\0';
+}
+
+void marker_export_output_path(const struct marker_session_info *info, enum marker_export_format format,
+                               char *buffer, size_t size)
+{
+    marker_export_base_path(info, buffer, size);
+
+    size_t len = strlen(buffer);
+    snprintf(buffer + len, size - len, "%s", exporters[format]->suffix);
+}
+
+uint32_t marker_export_timebase(const struct marker_session_info *info)
+{
+    uint32_t fps_num = info->fps_num ? info->fps_num : 60;
+    uint32_t fps_den = info->fps_den ? info->fps_den : 1;
+
+    // NTSC rates count whole frames per timecode second (29.97 -> 30)
+    uint32_t timebase = (fps_num + fps_den - 1) / fps_den;
+    return timebase ? timebase : 1;
+}
+
+void marker_export_timecode(uint64_t frame, uint32_t timebase, char *buffer, size_t size)
+{
+    uint64_t seconds = frame / timebase;
+    snprintf(buffer, size, "%02" PRIu64 ":%02" PRIu64 ":%02" PRIu64 ":%02" PRIu64, seconds / 3600,
+             (seconds / 60) % 60, seconds % 60, frame % timebase);
+}
+
+const char *marker_export_title(const struct stored_marker *marker)
+{
+    return marker->name[0] ? marker->name : marker->comment;
+}
+
+const char *marker_export_resolve_color(enum marker_color color)
+{
+    // Resolve has no orange or magenta; Sand and Fuchsia are the nearest
+    static const char *names[MARKER_COLOR_COUNT] = {
+        [MARKER_COLOR_BLUE] = "Blue",
+        [MARKER_COLOR_CYAN] = "Cyan",
+        [MARKER_COLOR_GREEN] = "Green",
+        [MARKER_COLOR_YELLOW] = "Yellow",
+        [MARKER_COLOR_RED] = "Red",
+        [MARKER_COLOR_MAGENTA] = "Fuchsia",
+        [MARKER_COLOR_PURPLE] = "Purple",
+        [MARKER_COLOR_ORANGE] = "Sand",
+    };
+    return (unsigned)color < MARKER_COLOR_COUNT ? names[color] : names[MARKER_COLOR_BLUE];
+}
+
+// One enabled format while the pass is running
+struct export_output {
+    enum marker_export_format format;
+    const struct marker_exporter *exporter;
+    FILE *file;
+    void *data;
+    char path[1024];
+    char temp_path[1040];
+};
+
+uint32_t marker_export_run(const struct marker_session_info *info, const struct marker_store *store,
+                           uint32_t formats)
+{
+    uint64_t start_ns = os_gettime_ns();
+    struct export_output outputs[MARKER_EXPORT_COUNT];
+    size_t count = 0;
+
+    // The session is over, nothing adds to the store any more
+    if (!store->markers.num) {
+        blog(LOG_WARNING, "Timestamp Plugin: No timestamps to convert");
+        return 0;
+    }
+
+    // Looked up once; it may mean a scan of the recording directory
+    char base[1024];
+    marker_export_base_path(info, base, sizeof(base));
+
+    for (int i = 0; i < MARKER_EXPORT_COUNT; i++) {
+        if (!(formats & (1u << i))) {
+            continue;
+        }
+
+        struct export_output *output = &outputs[count];
+        output->format = (enum marker_export_format)i;
+        output->exporter = exporters[i];
+        snprintf(output->path, sizeof(output->path), "%s%s", base, output->exporter->suffix);
+
+        // Written next to the target and renamed over it, so a file an
+        // editor has open (like the live sidecar) is replaced in one step
+        snprintf(output->temp_path, sizeof(output->temp_path), "%s%s.tmp", base, output->exporter->suffix);
+        output->file = os_fopen(output->temp_path, "wb");
+        if (!output->file) {
+            blog(LOG_ERROR, "Timestamp Plugin: Failed to create %s", output->path);
+            continue;
+        }
+
+        output->data = output->exporter->begin(output->file, info, store);
+        if (!output->data) {
+            fclose(output->file);
+            os_unlink(output->temp_path);
+            continue;
+        }
+        count++;
+    }
+
+    for (size_t m = 0; m < store->markers.num; m++) {
+        const struct stored_marker *marker = &store->markers.array[m];
+        for (size_t i = 0; i < count; i++) {
+            outputs[i].exporter->marker(outputs[i].data, marker);
+        }
+    }
+
+    uint32_t written = 0;
+    for (size_t i = 0; i < count; i++) {
+        struct export_output *output = &outputs[i];
+
+        bool ok = output->exporter->end(output->data);
+        ok = ferror(output->file) == 0 && ok;
+        if (fclose(output->file) != 0) {
+            ok = false;
+        }
+
+        if (ok && os_rename(output->temp_path, output->path) == 0) {
+            written |= 1u << output->format;
+            blog(LOG_INFO, "Timestamp Plugin: Wrote %s", output->path);
+        } else {
+            blog(LOG_ERROR, "Timestamp Plugin: Failed to write %s", output->path);
+            os_unlink(output->temp_path);
+        }
+    }
+
+    blog(LOG_INFO, "Timestamp Plugin: Exported %zu marker(s) in %zu format(s) in %.1f ms", store->markers.num,
+         count, (double)(os_gettime_ns() - start_ns) / 1000000.0);
+    return written;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "marker-writer.h"
+#include "marker-store.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Edit decision formats the markers of a finished session are exported to.
+// Each is a small vtable; marker_export_run opens every enabled one, makes
+// one pass over the session store calling marker() on all of them, then
+// ends them, so adding a format costs its own bytes and nothing more.
+
+enum marker_export_format {
+    MARKER_EXPORT_PREMIERE,    // Premiere Pro xmeml, <base>_markers.xml
+    MARKER_EXPORT_EDL,         // CMX3600 EDL with Resolve marker comments, <base>_markers.edl
+    MARKER_EXPORT_FCPXML,      // Final Cut Pro X, <base>_markers.fcpxml
+    MARKER_EXPORT_RESOLVE_CSV, // DaVinci Resolve marker list, <base>_markers.csv
+    MARKER_EXPORT_COUNT,
+};
+
+#define MARKER_EXPORT_DEFAULT (1u << MARKER_EXPORT_PREMIERE)
+
+struct marker_exporter {
+    const char *name;   // as listed in the ExportFormats setting
+    const char *suffix; // appended to the output base path
+
+    // Write what comes before the markers; returns the exporter's state or
+    // NULL on failure. The store is complete, so totals are known up front.
+    void *(*begin)(FILE *file, const struct marker_session_info *info, const struct marker_store *store);
+
+    // Called once per marker, in timestamp order
+    void (*marker)(void *data, const struct stored_marker *marker);
+
+    // Finish the document and free the state; false if it couldn't be completed
+    bool (*end)(void *data);
+};
+
+extern const struct marker_exporter premiere_exporter;
+extern const struct marker_exporter edl_exporter;
+extern const struct marker_exporter fcpxml_exporter;
+extern const struct marker_exporter resolve_csv_exporter;
+
+// "premiere, edl" -> bit mask of enum marker_export_format; unknown names
+// are logged and ignored, NULL or "" gives MARKER_EXPORT_DEFAULT
+uint32_t marker_export_parse_formats(const char *list);
+
+// Output path without suffix: the recording's path without its extension
+// when the video can be found (the one the frontend reported, else the best
+// match in the recording directory), otherwise the session log's
+void marker_export_base_path(const struct marker_session_info *info, char *buffer, size_t size);
+
+// Where a format's file goes
+void marker_export_output_path(const struct marker_session_info *info, enum marker_export_format format,
+                               char *buffer, size_t size);
+
+// Export the session in every format of the formats mask. Each file is
+// written next to its target and renamed over it. Returns the mask of the
+// formats that were written.
+uint32_t marker_export_run(const struct marker_session_info *info, const struct marker_store *store,
+                           uint32_t formats);
+
+// Sequence and clip timecode helpers shared by the exporters
+uint32_t marker_export_timebase(const struct marker_session_info *info); // frames per timecode second
+void marker_export_timecode(uint64_t frame, uint32_t timebase, char *buffer, size_t size);
+
+// The marker's title: its name, or its comment when it has none
+const char *marker_export_title(const struct stored_marker *marker);
+
+// Resolve's name for the closest of its marker colors
+const char *marker_export_resolve_color(enum marker_color color);
+
+#ifdef __cplusplus
+}
+#endif
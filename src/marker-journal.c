@@ -0,0 +1,381 @@
+#include "marker-journal.h"
+#include "session-log.h"
+#include "timestamp-plugin.h"
+#include <util/darray.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The on-disk layout is the in-memory layout, so pin it down
+#define JOURNAL_STATIC_ASSERT(cond, name) typedef char journal_assert_##name[(cond) ? 1 : -1]
+JOURNAL_STATIC_ASSERT(sizeof(struct marker_journal_header) == 664, header_size);
+JOURNAL_STATIC_ASSERT(offsetof(struct marker_journal_header, drift_offset) == MARKER_JOURNAL_V1_HEADER_SIZE, v1_header);
+JOURNAL_STATIC_ASSERT(sizeof(struct marker_journal_record) == 32, record_size);
+JOURNAL_STATIC_ASSERT(sizeof(struct clock_drift_point) == 16, drift_point_size);
+
+struct marker_journal_writer {
+    FILE *file;
+    struct marker_journal_header header;
+    DARRAY(char) strings;
+};
+
+// Append a string to the in-memory string table and return its offset
+static uint32_t add_string(struct marker_journal_writer *journal, const char *str)
+{
+    if (!str || !*str) {
+        return 0;
+    }
+
+    size_t offset = journal->strings.num;
+    da_push_back_array(journal->strings, str, strlen(str) + 1);
+    return (uint32_t)offset;
+}
+
+struct marker_journal_writer *marker_journal_create(const char *path, const struct marker_session_info *info)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to create journal: %s", path);
+        return NULL;
+    }
+
+    struct marker_journal_writer *journal = bzalloc(sizeof(*journal));
+    journal->file = file;
+
+    struct marker_journal_header *header = &journal->header;
+    memcpy(header->magic, MARKER_JOURNAL_MAGIC, sizeof(header->magic));
+    header->version = MARKER_JOURNAL_VERSION;
+    header->header_size = sizeof(struct marker_journal_header);
+    header->record_size = sizeof(struct marker_journal_record);
+    header->fps_num = info->fps_num;
+    header->fps_den = info->fps_den;
+    header->start_epoch = info->start_epoch;
+    header->records_offset = sizeof(struct marker_journal_header);
+    snprintf(header->start_time, sizeof(header->start_time), "%s", info->start_time);
+    snprintf(header->recording_path, sizeof(header->recording_path), "%s", info->recording_path);
+
+    // Offset 0 of the string table is the empty string
+    char empty = '\0';
+    da_push_back(journal->strings, &empty);
+
+    if (fwrite(header, sizeof(*header), 1, file) != 1) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to write journal header: %s", path);
+        fclose(file);
+        da_free(journal->strings);
+        bfree(journal);
+        return NULL;
+    }
+
+    return journal;
+}
+
+bool marker_journal_append(struct marker_journal_writer *journal, const struct marker_record *record)
+{
+    struct marker_journal_record entry = {0};
+    entry.timestamp_ns = record->timestamp_ns;
+    entry.frame = record->frame;
+    entry.comment = add_string(journal, record->comment);
+    entry.name = add_string(journal, record->name);
+    entry.color = (uint32_t)marker_color_from_name(record->color);
+    entry.count = record->count > 1 ? record->count : 0;
+
+    if (fwrite(&entry, sizeof(entry), 1, journal->file) != 1) {
+        return false;
+    }
+
+    journal->header.record_count++;
+    return true;
+}
+
+void marker_journal_sync(struct marker_journal_writer *journal, bool durable)
+{
+    fflush(journal->file);
+
+    if (durable) {
+#ifdef _WIN32
+        _commit(_fileno(journal->file));
+#else
+        fsync(fileno(journal->file));
+#endif
+    }
+}
+
+bool marker_journal_close(struct marker_journal_writer *journal, const struct clock_drift *drift)
+{
+    struct marker_journal_header *header = &journal->header;
+    bool ok = true;
+
+    header->strings_offset = header->records_offset + header->record_count * header->record_size;
+    header->strings_size = journal->strings.num;
+
+    if (os_fseeki64(journal->file, (int64_t)header->strings_offset, SEEK_SET) != 0 ||
+        fwrite(journal->strings.array, 1, journal->strings.num, journal->file) != journal->strings.num) {
+        ok = false;
+    }
+
+    // The drift points follow the strings, padded so the mapping can be
+    // read in place; a table that never left the origin says nothing
+    if (ok && drift && drift->points.num > 1) {
+        uint64_t strings_end = header->strings_offset + header->strings_size;
+        size_t padding = (size_t)((8 - strings_end % 8) % 8);
+        const char zeros[8] = {0};
+
+        header->drift_offset = strings_end + padding;
+        header->drift_count = drift->points.num;
+        if (fwrite(zeros, 1, padding, journal->file) != padding ||
+            fwrite(drift->points.array, sizeof(*drift->points.array), drift->points.num, journal->file) !=
+                drift->points.num) {
+            ok = false;
+        }
+    }
+
+    // Only mark the header finalized once the string and drift tables are in place
+    if (ok) {
+        header->flags |= MARKER_JOURNAL_FINALIZED;
+        if (os_fseeki64(journal->file, 0, SEEK_SET) != 0 ||
+            fwrite(header, sizeof(*header), 1, journal->file) != 1) {
+            ok = false;
+        }
+    }
+
+    if (fclose(journal->file) != 0) {
+        ok = false;
+    }
+
+    if (!ok) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to finalize marker journal");
+    }
+
+    da_free(journal->strings);
+    bfree(journal);
+    return ok;
+}
+
+// Map the whole file read-only
+static bool map_file(struct marker_journal_reader *reader, const char *path)
+{
+#ifdef _WIN32
+    wchar_t *wpath = NULL;
+    if (!os_utf8_to_wcs_ptr(path, 0, &wpath)) {
+        return false;
+    }
+
+    HANDLE file = CreateFileW(wpath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    bfree(wpath);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!map) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    reader->file_handle = file;
+    reader->mapping_handle = mapping;
+    reader->map = map;
+    reader->map_size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    reader->map = map;
+    reader->map_size = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void marker_journal_unmap(struct marker_journal_reader *reader)
+{
+    if (reader->map) {
+#ifdef _WIN32
+        UnmapViewOfFile(reader->map);
+        CloseHandle(reader->mapping_handle);
+        CloseHandle(reader->file_handle);
+#else
+        munmap(reader->map, reader->map_size);
+#endif
+    }
+    memset(reader, 0, sizeof(*reader));
+}
+
+bool marker_journal_open(struct marker_journal_reader *reader, const char *path)
+{
+    memset(reader, 0, sizeof(*reader));
+
+    if (!map_file(reader, path)) {
+        blog(LOG_WARNING, "Timestamp Plugin: Could not map journal: %s", path);
+        return false;
+    }
+
+    // A version 1 header ends before the drift fields
+    const struct marker_journal_header *header = reader->map;
+    size_t header_size = reader->map_size >= sizeof(*header) && header->version >= MARKER_JOURNAL_VERSION
+                             ? sizeof(*header)
+                             : MARKER_JOURNAL_V1_HEADER_SIZE;
+    if (reader->map_size < header_size || memcmp(header->magic, MARKER_JOURNAL_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version < 1 || header->version > MARKER_JOURNAL_VERSION ||
+        header->record_size != sizeof(struct marker_journal_record) || header->records_offset < header_size ||
+        header->records_offset > reader->map_size) {
+        blog(LOG_WARNING, "Timestamp Plugin: Not a valid marker journal: %s", path);
+        marker_journal_unmap(reader);
+        return false;
+    }
+
+    uint64_t available = (reader->map_size - header->records_offset) / header->record_size;
+
+    reader->header = header;
+    reader->records = (const struct marker_journal_record *)((const uint8_t *)reader->map + header->records_offset);
+
+    if (header->flags & MARKER_JOURNAL_FINALIZED) {
+        if (header->record_count > available || header->strings_offset > reader->map_size ||
+            header->strings_size > reader->map_size - header->strings_offset) {
+            blog(LOG_WARNING, "Timestamp Plugin: Truncated marker journal: %s", path);
+            marker_journal_unmap(reader);
+            return false;
+        }
+        reader->count = (size_t)header->record_count;
+        reader->strings = (const char *)reader->map + header->strings_offset;
+        reader->strings_size = (size_t)header->strings_size;
+
+        if (header->version >= 2 && header->drift_count) {
+            if (header->drift_offset % 8 != 0 || header->drift_offset > reader->map_size ||
+                header->drift_count > (reader->map_size - header->drift_offset) / sizeof(struct clock_drift_point)) {
+                blog(LOG_WARNING, "Timestamp Plugin: Truncated marker journal: %s", path);
+                marker_journal_unmap(reader);
+                return false;
+            }
+            reader->drift = (const struct clock_drift_point *)((const uint8_t *)reader->map + header->drift_offset);
+            reader->drift_count = (size_t)header->drift_count;
+        }
+    } else {
+        // Never closed (e.g. OBS crashed): the records are there, the strings aren't
+        reader->count = (size_t)available;
+    }
+
+    return true;
+}
+
+const char *marker_journal_string(const struct marker_journal_reader *reader, uint32_t offset)
+{
+    if (!reader->strings || offset >= reader->strings_size) {
+        return "";
+    }
+
+    // The table is NUL-terminated per string; guard against a corrupt tail
+    const char *str = reader->strings + offset;
+    if (!memchr(str, '\0', reader->strings_size - offset)) {
+        return "";
+    }
+    return str;
+}
+
+void marker_journal_load_drift(const struct marker_journal_reader *reader, struct clock_drift *drift)
+{
+    if (reader->drift_count) {
+        da_resize(drift->points, 0);
+        da_push_back_array(drift->points, reader->drift, reader->drift_count);
+    }
+}
+
+bool marker_journal_dump_jsonl(const struct marker_journal_reader *reader, const char *path, const char *video_path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to create output file: %s", path);
+        return false;
+    }
+
+    const struct marker_journal_header *header = reader->header;
+    char recording_path[sizeof(header->recording_path) + 1];
+    char start_time[sizeof(header->start_time) + 1];
+    snprintf(recording_path, sizeof(recording_path), "%.*s", (int)sizeof(header->recording_path), header->recording_path);
+    snprintf(start_time, sizeof(start_time), "%.*s", (int)sizeof(header->start_time), header->start_time);
+
+    char line[SESSION_LOG_LINE_SIZE];
+    int length = session_log_format_header(line, sizeof(line), recording_path, start_time, header->fps_num,
+                                           header->fps_den);
+    if (length > 0) {
+        fwrite(line, 1, (size_t)length, file);
+    }
+
+    for (size_t i = 0; i < reader->count; i++) {
+        const struct marker_journal_record *entry = &reader->records[i];
+
+        struct marker_record record = {0};
+        record.timestamp_ms = entry->timestamp_ns / 1000000;
+        record.frame = entry->frame;
+        record.count = entry->count;
+        snprintf(record.comment, sizeof(record.comment), "%s", marker_journal_string(reader, entry->comment));
+        snprintf(record.name, sizeof(record.name), "%s", marker_journal_string(reader, entry->name));
+        snprintf(record.color, sizeof(record.color), "%s", marker_color_name((enum marker_color)entry->color));
+
+        length = session_log_format_marker(line, sizeof(line), &record);
+        if (length > 0) {
+            fwrite(line, 1, (size_t)length, file);
+        }
+    }
+
+    // Same trailing metadata line as the live JSONL log
+    if (video_path && *video_path) {
+        length = session_log_format_trailer(line, sizeof(line), video_path, false);
+        if (length > 0) {
+            fwrite(line, 1, (size_t)length, file);
+        }
+    }
+
+    // And the drift table after it, as close writes it
+    bool ok = true;
+    if (reader->drift_count) {
+        struct clock_drift drift = {0};
+        marker_journal_load_drift(reader, &drift);
+        ok = clock_drift_write(&drift, file);
+        clock_drift_free(&drift);
+    }
+
+    if (ferror(file) != 0) {
+        ok = false;
+    }
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
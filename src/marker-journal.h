@@ -0,0 +1,105 @@
+#pragma once
+
+#include "marker-writer.h"
+#include "marker-store.h"
+#include "clock-drift.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compact binary session log. Layout (little-endian, no padding surprises):
+//
+//   header   struct marker_journal_header (metadata, counts, offsets)
+//   records  record_count x struct marker_journal_record, fixed size
+//   strings  NUL-terminated comment/name strings; offset 0 is ""
+//   drift    drift_count x struct clock_drift_point, 8-byte aligned
+//
+// Records are appended while recording. The string table, the clock drift
+// table and the final counts are written when the journal is closed; a
+// journal that was never closed still exposes its records (with empty
+// strings and no drift) to the reader. Version 1 journals have the shorter
+// header without the drift fields and are still read.
+
+#define MARKER_JOURNAL_MAGIC "OBSTSMJ1"
+#define MARKER_JOURNAL_VERSION 2
+#define MARKER_JOURNAL_V1_HEADER_SIZE 648
+#define MARKER_JOURNAL_EXTENSION ".tsmj"
+
+// Header flags
+#define MARKER_JOURNAL_FINALIZED 0x1
+
+struct marker_journal_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;
+    uint32_t flags;
+    uint32_t fps_num;
+    uint32_t fps_den;
+    int64_t start_epoch;
+    uint64_t record_count;
+    uint64_t records_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    char start_time[64];
+    char recording_path[512];
+    uint64_t drift_offset; // version 2 on
+    uint64_t drift_count;
+};
+
+struct marker_journal_record {
+    uint64_t timestamp_ns;
+    uint64_t frame;
+    uint32_t comment; // string table offset
+    uint32_t name;    // string table offset
+    uint32_t color;   // enum marker_color
+    uint32_t count;   // hotkey presses coalesced into the marker (0 = one)
+};
+
+// Writer side (used by the writer thread only)
+struct marker_journal_writer;
+
+struct marker_journal_writer *marker_journal_create(const char *path, const struct marker_session_info *info);
+bool marker_journal_append(struct marker_journal_writer *journal, const struct marker_record *record);
+void marker_journal_sync(struct marker_journal_writer *journal, bool durable);
+
+// Writes the string table and the session's drift table (NULL for none),
+// finalizes the header and frees the writer
+bool marker_journal_close(struct marker_journal_writer *journal, const struct clock_drift *drift);
+
+// Read-only memory-mapped view of a journal; nothing is parsed or copied
+struct marker_journal_reader {
+    const struct marker_journal_header *header;
+    const struct marker_journal_record *records;
+    size_t count;
+    const char *strings;
+    size_t strings_size;
+    const struct clock_drift_point *drift;
+    size_t drift_count;
+
+    void *map;
+    size_t map_size;
+#ifdef _WIN32
+    void *file_handle;
+    void *mapping_handle;
+#endif
+};
+
+bool marker_journal_open(struct marker_journal_reader *reader, const char *path);
+void marker_journal_unmap(struct marker_journal_reader *reader);
+
+// Resolve a string table offset ("" when out of range or not yet written)
+const char *marker_journal_string(const struct marker_journal_reader *reader, uint32_t offset);
+
+// Copy the journal's drift table into an initialized clock_drift; left at the
+// origin when the journal has none
+void marker_journal_load_drift(const struct marker_journal_reader *reader, struct clock_drift *drift);
+
+// Write the journal out in the JSON Lines format of the text log, drift
+// table included
+bool marker_journal_dump_jsonl(const struct marker_journal_reader *reader, const char *path, const char *video_path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,131 @@
+#include "marker-queue.h"
+
+// Bounded multi-producer/single-consumer queue. Each slot carries a sequence
+// number that tells producers whether it is free and tells the consumer
+// whether it has been filled, so no locks are needed on either side.
+
+bool marker_queue_init(struct marker_queue *queue)
+{
+    memset(queue, 0, sizeof(*queue));
+
+    queue->slots = bzalloc(sizeof(struct marker_slot) * MARKER_QUEUE_CAPACITY);
+    if (!queue->slots) {
+        return false;
+    }
+
+    queue->mask = MARKER_QUEUE_CAPACITY - 1;
+    for (unsigned long i = 0; i < MARKER_QUEUE_CAPACITY; i++) {
+        os_atomic_set_long(&queue->slots[i].sequence, (long)i);
+    }
+
+    return true;
+}
+
+void marker_queue_free(struct marker_queue *queue)
+{
+    bfree(queue->slots);
+    queue->slots = NULL;
+}
+
+bool marker_queue_push(struct marker_queue *queue, const struct marker_record *record)
+{
+    struct marker_slot *slot;
+    long pos = os_atomic_load_long(&queue->head);
+
+    for (;;) {
+        slot = &queue->slots[(unsigned long)pos & queue->mask];
+        long seq = os_atomic_load_long(&slot->sequence);
+        long diff = (long)((unsigned long)seq - (unsigned long)pos);
+
+        if (diff == 0) {
+            // Slot is free for this position, try to claim it
+            if (os_atomic_compare_exchange_long(&queue->head, &pos, (long)((unsigned long)pos + 1))) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Consumer has not released this slot yet - the ring is full
+            os_atomic_inc_long(&queue->dropped);
+            return false;
+        } else {
+            pos = os_atomic_load_long(&queue->head);
+        }
+    }
+
+    slot->record = *record;
+    os_atomic_set_long(&slot->sequence, (long)((unsigned long)pos + 1));
+    return true;
+}
+
+size_t marker_queue_push_batch(struct marker_queue *queue, const struct marker_record *records, size_t count)
+{
+    long pos = os_atomic_load_long(&queue->head);
+    size_t claimed;
+
+    for (;;) {
+        // Count the free slots from pos on; a slot ahead of pos that is still
+        // in use means the ring is full from there
+        claimed = 0;
+        long diff = 0;
+        while (claimed < count) {
+            struct marker_slot *slot = &queue->slots[((unsigned long)pos + claimed) & queue->mask];
+            long seq = os_atomic_load_long(&slot->sequence);
+            diff = (long)((unsigned long)seq - ((unsigned long)pos + claimed));
+            if (diff != 0) {
+                break;
+            }
+            claimed++;
+        }
+
+        if (claimed == 0 && diff < 0) {
+            break;
+        }
+        if (claimed == 0) {
+            pos = os_atomic_load_long(&queue->head);
+            continue;
+        }
+
+        // One claim for the whole run of slots; on failure pos is reloaded
+        if (os_atomic_compare_exchange_long(&queue->head, &pos, (long)((unsigned long)pos + claimed))) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < claimed; i++) {
+        struct marker_slot *slot = &queue->slots[((unsigned long)pos + i) & queue->mask];
+        slot->record = records[i];
+        os_atomic_set_long(&slot->sequence, (long)((unsigned long)pos + i + 1));
+    }
+
+    for (size_t i = claimed; i < count; i++) {
+        os_atomic_inc_long(&queue->dropped);
+    }
+    return claimed;
+}
+
+bool marker_queue_pop(struct marker_queue *queue, struct marker_record *record)
+{
+    long pos = queue->tail;
+    struct marker_slot *slot = &queue->slots[(unsigned long)pos & queue->mask];
+    long seq = os_atomic_load_long(&slot->sequence);
+
+    if ((long)((unsigned long)seq - ((unsigned long)pos + 1)) < 0) {
+        return false;
+    }
+
+    *record = slot->record;
+
+    // Hand the slot back to producers for the next lap around the ring
+    os_atomic_set_long(&slot->sequence, (long)((unsigned long)pos + queue->mask + 1));
+    queue->tail = (long)((unsigned long)pos + 1);
+    return true;
+}
+
+unsigned long marker_queue_pushed(struct marker_queue *queue)
+{
+    return (unsigned long)os_atomic_load_long(&queue->head);
+}
+
+unsigned long marker_queue_dropped(struct marker_queue *queue)
+{
+    return (unsigned long)os_atomic_load_long(&queue->dropped);
+}
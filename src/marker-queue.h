@@ -0,0 +1,89 @@
+#pragma once
+
+#include <obs-module.h>
+#include <util/threading.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed field sizes so a marker record can live in a preallocated ring slot
+#define MARKER_COMMENT_SIZE 128
+#define MARKER_NAME_SIZE 64
+#define MARKER_COLOR_SIZE 16
+
+// Number of slots in the marker ring (must be a power of two)
+#define MARKER_QUEUE_CAPACITY 1024
+
+enum marker_record_type {
+    MARKER_RECORD_MARKER,
+    MARKER_RECORD_SESSION_BEGIN,
+    MARKER_RECORD_SESSION_END,
+    MARKER_RECORD_SESSION_RECOVER, // data: session directory to check for an unfinished session
+    MARKER_RECORD_SESSION_SPLIT,   // data: file the output continues in, timestamp_ns: where it starts
+    MARKER_RECORD_SESSION_PAUSE,   // data: the session's clock after a pause or resume
+};
+
+// How a hotkey press relates to the coalescing window (see CoalesceMs)
+enum marker_burst {
+    MARKER_BURST_NONE,  // stands alone
+    MARKER_BURST_START, // first press of a possible burst
+    MARKER_BURST_MERGE, // within the window of the previous press, adds to its marker
+    MARKER_BURST_SCENE, // scene switch; one within SceneCoalesceMs of the last takes its marker over
+};
+
+// A single marker as it travels from the hotkey thread to the writer thread.
+// Session begin/end records use the same slots so they stay ordered with
+// the markers around them; a begin record carries its session info in data.
+struct marker_record {
+    enum marker_record_type type;
+    void *data;
+    uint64_t timestamp_ns; // since the first recorded frame
+    uint64_t queued_ns;    // os_gettime_ns() when pushed, for latency stats
+    uint64_t timestamp_ms;
+    uint64_t frame;        // exact frame index on the recording timeline
+    long generation;       // session the marker was taken in, 0 = whichever is open
+    enum marker_burst burst;
+    uint32_t count;        // presses merged into this marker (0 = one)
+    char comment[MARKER_COMMENT_SIZE];
+    char name[MARKER_NAME_SIZE];
+    char color[MARKER_COLOR_SIZE];
+};
+
+struct marker_slot {
+    volatile long sequence;
+    struct marker_record record;
+};
+
+// Bounded lock-free ring buffer. Any number of threads may push, exactly
+// one thread (the writer) may pop.
+struct marker_queue {
+    struct marker_slot *slots;
+    unsigned long mask;
+    volatile long head;
+    volatile long tail;
+    volatile long dropped;
+};
+
+bool marker_queue_init(struct marker_queue *queue);
+void marker_queue_free(struct marker_queue *queue);
+
+// Never blocks; returns false and bumps the dropped counter when the ring is full
+bool marker_queue_push(struct marker_queue *queue, const struct marker_record *record);
+
+// Push records in order with a single claim on the ring. Pushes as many as
+// fit, counts the rest as dropped and returns the number pushed.
+size_t marker_queue_push_batch(struct marker_queue *queue, const struct marker_record *records, size_t count);
+
+// Consumer side only
+bool marker_queue_pop(struct marker_queue *queue, struct marker_record *record);
+
+// Number of records ever accepted by marker_queue_push
+unsigned long marker_queue_pushed(struct marker_queue *queue);
+
+// Number of records rejected because the ring was full
+unsigned long marker_queue_dropped(struct marker_queue *queue);
+
+#ifdef __cplusplus
+}
+#endif
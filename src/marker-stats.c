@@ -0,0 +1,242 @@
+#include "marker-stats.h"
+#include <util/platform.h>
+#include <util/threading.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Bucket i counts latencies below 2^i ns (bucket 0 is exactly 0)
+#define STATS_BUCKETS 64
+
+struct latency_histogram {
+    volatile long buckets[STATS_BUCKETS];
+    volatile int64_t sum_us; // 64-bit: a long is 32 bits on Windows, ~36 min of summed latency
+    volatile int64_t max_us;
+};
+
+static struct latency_histogram histograms[MARKER_STAT_COUNT];
+static volatile long counters[MARKER_COUNTER_COUNT];
+static volatile long events_recorded = 0;
+static long events_summarized = 0;
+
+static const char *stat_names[MARKER_STAT_COUNT] = {
+    "hotkey_to_enqueue", "enqueue_to_write", "write_to_durable", "recording_start", "recording_stop",
+    "audio_block", "video_frame", "api_batch",
+};
+
+static const char *counter_names[MARKER_COUNTER_COUNT] = {
+    "written",
+    "failed_writes",
+    "stale",
+    "coalesced",
+    "repeat",
+    "scene",
+    "scene_merged",
+    "api",
+    "paused",
+};
+
+// Number of significant bits, so 1 -> 1, 1000 -> 10
+static int bit_length(uint64_t value)
+{
+    if (!value) {
+        return 0;
+    }
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (int)index + 1;
+#else
+    return 64 - __builtin_clzll(value);
+#endif
+}
+
+// libobs has no 64-bit atomics, so build load/add/max from the compiler's
+// compare-exchange, which every target OBS runs on has for 64 bits
+static bool atomic_compare_exchange64(volatile int64_t *target, int64_t *expected, int64_t value)
+{
+#ifdef _MSC_VER
+    int64_t old = _InterlockedCompareExchange64((volatile __int64 *)target, value, *expected);
+    bool done = old == *expected;
+    *expected = old;
+    return done;
+#else
+    return __atomic_compare_exchange_n(target, expected, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static int64_t atomic_load64(volatile int64_t *target)
+{
+#ifdef _MSC_VER
+    return _InterlockedCompareExchange64((volatile __int64 *)target, 0, 0);
+#else
+    return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static void atomic_add64(volatile int64_t *target, int64_t value)
+{
+    int64_t old = atomic_load64(target);
+    while (!atomic_compare_exchange64(target, &old, old + value)) {
+    }
+}
+
+static void atomic_max64(volatile int64_t *target, int64_t value)
+{
+    int64_t old = atomic_load64(target);
+    while (old < value && !atomic_compare_exchange64(target, &old, value)) {
+    }
+}
+
+void marker_stats_record(enum marker_stat stat, uint64_t latency_ns)
+{
+    struct latency_histogram *histogram = &histograms[stat];
+    int bucket = bit_length(latency_ns);
+    if (bucket >= STATS_BUCKETS) {
+        bucket = STATS_BUCKETS - 1;
+    }
+
+    int64_t latency_us = (int64_t)(latency_ns / 1000);
+
+    os_atomic_inc_long(&histogram->buckets[bucket]);
+    atomic_add64(&histogram->sum_us, latency_us);
+    atomic_max64(&histogram->max_us, latency_us);
+    os_atomic_inc_long(&events_recorded);
+}
+
+void marker_stats_count(enum marker_counter counter)
+{
+    os_atomic_inc_long(&counters[counter]);
+    os_atomic_inc_long(&events_recorded);
+}
+
+bool marker_stats_changed(void)
+{
+    return os_atomic_load_long(&events_recorded) != events_summarized;
+}
+
+// Consistent-enough copy of one histogram; writers may race ahead slightly
+struct histogram_snapshot {
+    long buckets[STATS_BUCKETS];
+    long count;
+    int64_t sum_us;
+    int64_t max_us;
+};
+
+static void snapshot(enum marker_stat stat, struct histogram_snapshot *out)
+{
+    struct latency_histogram *histogram = &histograms[stat];
+
+    out->count = 0;
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        out->buckets[i] = os_atomic_load_long(&histogram->buckets[i]);
+        out->count += out->buckets[i];
+    }
+    out->sum_us = atomic_load64(&histogram->sum_us);
+    out->max_us = atomic_load64(&histogram->max_us);
+}
+
+// Upper bound of the bucket holding the given percentile, in microseconds
+// (log2 buckets, so this overestimates by up to 2x)
+static double percentile_us(const struct histogram_snapshot *snap, int percentile)
+{
+    if (!snap->count) {
+        return 0.0;
+    }
+
+    long target = (long)(((int64_t)snap->count * percentile + 99) / 100);
+    long seen = 0;
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        seen += snap->buckets[i];
+        if (seen >= target) {
+            // The top bucket's bound can overshoot the worst sample seen
+            double bound_us = i ? (double)(1ULL << i) / 1000.0 : 0.0;
+            return bound_us < (double)snap->max_us ? bound_us : (double)snap->max_us;
+        }
+    }
+    return (double)snap->max_us;
+}
+
+static double mean_us(const struct histogram_snapshot *snap)
+{
+    return snap->count ? (double)snap->sum_us / (double)snap->count : 0.0;
+}
+
+void marker_stats_log_summary(uint64_t dropped)
+{
+    events_summarized = os_atomic_load_long(&events_recorded);
+
+    blog(LOG_INFO, "Timestamp Plugin: Marker stats: %ld written, %ld failed, %ld stale, %ld coalesced, %" PRIu64 " dropped",
+         os_atomic_load_long(&counters[MARKER_COUNTER_WRITTEN]),
+         os_atomic_load_long(&counters[MARKER_COUNTER_FAILED_WRITES]),
+         os_atomic_load_long(&counters[MARKER_COUNTER_STALE]),
+         os_atomic_load_long(&counters[MARKER_COUNTER_COALESCED]), dropped);
+
+    for (int i = 0; i < MARKER_STAT_COUNT; i++) {
+        struct histogram_snapshot snap;
+        snapshot((enum marker_stat)i, &snap);
+        if (!snap.count) {
+            continue;
+        }
+
+        blog(LOG_INFO, "Timestamp Plugin:   %-17s n=%ld mean=%.1fus p50<%.1fus p99<%.1fus max=%" PRId64 "us",
+             stat_names[i], snap.count, mean_us(&snap), percentile_us(&snap, 50), percentile_us(&snap, 99),
+             snap.max_us);
+    }
+}
+
+bool marker_stats_write_json(const char *path, uint64_t dropped)
+{
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    FILE *file = fopen(temp_path, "w");
+    if (!file) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to write stats file: %s", temp_path);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"updated_ns\": %" PRIu64 ",\n  \"dropped\": %" PRIu64, os_gettime_ns(), dropped);
+    for (int i = 0; i < MARKER_COUNTER_COUNT; i++) {
+        fprintf(file, ",\n  \"%s\": %ld", counter_names[i], os_atomic_load_long(&counters[i]));
+    }
+
+    fputs(",\n  \"latency\": {", file);
+    for (int i = 0; i < MARKER_STAT_COUNT; i++) {
+        struct histogram_snapshot snap;
+        snapshot((enum marker_stat)i, &snap);
+
+        fprintf(file,
+                "%s\n    \"%s\": {\"count\": %ld, \"mean_us\": %.1f, \"p50_us\": %.1f, \"p90_us\": %.1f, "
+                "\"p99_us\": %.1f, \"max_us\": %" PRId64 ", \"buckets\": [",
+                i ? "," : "", stat_names[i], snap.count, mean_us(&snap), percentile_us(&snap, 50),
+                percentile_us(&snap, 90), percentile_us(&snap, 99), snap.max_us);
+
+        // Sparse [upper bound ns, count] pairs
+        bool first = true;
+        for (int b = 0; b < STATS_BUCKETS; b++) {
+            if (snap.buckets[b]) {
+                fprintf(file, "%s[%" PRIu64 ", %ld]", first ? "" : ", ", b ? (uint64_t)1 << b : (uint64_t)0, snap.buckets[b]);
+                first = false;
+            }
+        }
+        fputs("]}", file);
+    }
+    fputs("\n  }\n}\n", file);
+
+    bool ok = ferror(file) == 0;
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+
+    // Readers never see a half-written file
+    if (!ok || os_rename(temp_path, path) != 0) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to write stats file: %s", path);
+        os_unlink(temp_path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <obs-module.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Latencies measured along the marker path
+enum marker_stat {
+    MARKER_STAT_HOTKEY_TO_ENQUEUE, // marker requested -> in the writer queue
+    MARKER_STAT_ENQUEUE_TO_WRITE,  // in the queue -> line written by the writer
+    MARKER_STAT_WRITE_TO_DURABLE,  // line written -> flushed (or fsynced) by the policy
+    MARKER_STAT_RECORDING_START,   // RECORDING_STARTED handler
+    MARKER_STAT_RECORDING_STOP,    // RECORDING_STOPPED handler
+    MARKER_STAT_AUDIO_BLOCK,       // audio trigger's work on one block, on the audio thread
+    MARKER_STAT_VIDEO_FRAME,       // video trigger's work on one frame, on its worker thread
+    MARKER_STAT_API_BATCH,         // AddMarkers request parsed and its batch in the writer queue
+    MARKER_STAT_COUNT,
+};
+
+// Event counters
+enum marker_counter {
+    MARKER_COUNTER_WRITTEN,
+    MARKER_COUNTER_FAILED_WRITES,
+    MARKER_COUNTER_STALE,         // marker from another session, rejected
+    MARKER_COUNTER_COALESCED,     // hotkey press merged into the marker of an earlier one
+    MARKER_COUNTER_REPEAT,        // marker added by the auto-repeat timer
+    MARKER_COUNTER_SCENE,         // scene switch marker
+    MARKER_COUNTER_SCENE_MERGED,  // scene switch that took over the marker of the one before it
+    MARKER_COUNTER_API,           // marker queued through the proc handler or obs-websocket
+    MARKER_COUNTER_PAUSED,        // marker refused while the recording was paused
+    MARKER_COUNTER_COUNT,
+};
+
+// Record a latency into the stat's log2 histogram. Lock-free, callable from
+// any thread including the hotkey and UI threads.
+void marker_stats_record(enum marker_stat stat, uint64_t latency_ns);
+void marker_stats_count(enum marker_counter counter);
+
+// Whether anything was recorded since the last summary was logged
+bool marker_stats_changed(void);
+
+// Write a summary of every histogram to the OBS log. `dropped` is the number
+// of markers the writer queue rejected so far.
+void marker_stats_log_summary(uint64_t dropped);
+
+// Write the same data as JSON to path (replaced atomically)
+bool marker_stats_write_json(const char *path, uint64_t dropped);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,178 @@
+#include "marker-store.h"
+#include <util/bmem.h>
+#include <util/dstr.h>
+#include <stdio.h>
+#include <string.h>
+
+// Arena blocks are never moved or resized, so string pointers stay stable
+// while the marker array itself grows
+#define MARKER_ARENA_BLOCK_SIZE 4096
+
+struct marker_arena_block {
+    struct marker_arena_block *next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+static const char *color_names[MARKER_COLOR_COUNT] = {
+    "blue", "cyan", "green", "yellow", "red", "magenta", "purple", "orange",
+};
+
+enum marker_color marker_color_from_name(const char *name)
+{
+    if (name && *name) {
+        for (int i = 0; i < MARKER_COLOR_COUNT; i++) {
+            if (astrcmpi(name, color_names[i]) == 0) {
+                return (enum marker_color)i;
+            }
+        }
+    }
+    return MARKER_COLOR_BLUE;
+}
+
+const char *marker_color_name(enum marker_color color)
+{
+    if ((int)color < 0 || color >= MARKER_COLOR_COUNT) {
+        return color_names[MARKER_COLOR_BLUE];
+    }
+    return color_names[color];
+}
+
+// Copy a string into the arena; empty strings share a static ""
+static const char *arena_strdup(struct marker_store *store, const char *str)
+{
+    if (!str || !*str) {
+        return "";
+    }
+
+    size_t len = strlen(str) + 1;
+    struct marker_arena_block *block = store->blocks;
+
+    if (!block || block->size - block->used < len) {
+        size_t size = len > MARKER_ARENA_BLOCK_SIZE ? len : MARKER_ARENA_BLOCK_SIZE;
+        block = bmalloc(sizeof(*block) + size);
+        block->next = store->blocks;
+        block->used = 0;
+        block->size = size;
+        store->blocks = block;
+    }
+
+    char *copy = block->data + block->used;
+    memcpy(copy, str, len);
+    block->used += len;
+    return copy;
+}
+
+struct marker_store *marker_store_create(void)
+{
+    struct marker_store *store = bzalloc(sizeof(*store));
+    pthread_mutex_init(&store->mutex, NULL);
+    da_reserve(store->markers, 64);
+    return store;
+}
+
+void marker_store_destroy(struct marker_store *store)
+{
+    if (!store) {
+        return;
+    }
+
+    struct marker_arena_block *block = store->blocks;
+    while (block) {
+        struct marker_arena_block *next = block->next;
+        bfree(block);
+        block = next;
+    }
+
+    da_free(store->markers);
+    pthread_mutex_destroy(&store->mutex);
+    bfree(store);
+}
+
+// First index whose timestamp is >= timestamp_ns (caller holds the lock)
+static size_t lower_bound(const struct marker_store *store, uint64_t timestamp_ns)
+{
+    size_t lo = 0;
+    size_t hi = store->markers.num;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (store->markers.array[mid].timestamp_ns < timestamp_ns) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void marker_store_add(struct marker_store *store, const struct marker_record *record)
+{
+    pthread_mutex_lock(&store->mutex);
+
+    struct stored_marker marker;
+    marker.timestamp_ns = record->timestamp_ns;
+    marker.frame = record->frame;
+    marker.comment = arena_strdup(store, record->comment);
+    marker.name = arena_strdup(store, record->name);
+    marker.color = marker_color_from_name(record->color);
+    marker.count = record->count ? record->count : 1;
+
+    // Producers race each other into the queue, so a marker can arrive a
+    // little behind a newer one; in the usual case this appends
+    size_t num = store->markers.num;
+    if (!num || store->markers.array[num - 1].timestamp_ns <= marker.timestamp_ns) {
+        da_push_back(store->markers, &marker);
+    } else {
+        size_t index = lower_bound(store, marker.timestamp_ns + 1);
+        da_insert(store->markers, index, &marker);
+    }
+
+    pthread_mutex_unlock(&store->mutex);
+}
+
+size_t marker_store_count(struct marker_store *store)
+{
+    pthread_mutex_lock(&store->mutex);
+    size_t count = store->markers.num;
+    pthread_mutex_unlock(&store->mutex);
+    return count;
+}
+
+bool marker_store_get(struct marker_store *store, size_t index, struct marker_record *record)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&store->mutex);
+    if (index < store->markers.num) {
+        const struct stored_marker *marker = &store->markers.array[index];
+
+        memset(record, 0, sizeof(*record));
+        record->type = MARKER_RECORD_MARKER;
+        record->timestamp_ns = marker->timestamp_ns;
+        record->timestamp_ms = marker->timestamp_ns / 1000000;
+        record->frame = marker->frame;
+        snprintf(record->comment, sizeof(record->comment), "%s", marker->comment);
+        snprintf(record->name, sizeof(record->name), "%s", marker->name);
+        snprintf(record->color, sizeof(record->color), "%s", marker_color_name(marker->color));
+        record->count = marker->count;
+        found = true;
+    }
+    pthread_mutex_unlock(&store->mutex);
+
+    return found;
+}
+
+size_t marker_store_range(struct marker_store *store, uint64_t start_ns, uint64_t end_ns, size_t *first)
+{
+    pthread_mutex_lock(&store->mutex);
+    size_t begin = lower_bound(store, start_ns);
+    size_t end = end_ns > start_ns ? lower_bound(store, end_ns) : begin;
+    pthread_mutex_unlock(&store->mutex);
+
+    if (first) {
+        *first = begin;
+    }
+    return end - begin;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "marker-queue.h"
+#include <util/darray.h>
+#include <util/threading.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Marker colors as stored in the session store and the binary journal
+enum marker_color {
+    MARKER_COLOR_BLUE,
+    MARKER_COLOR_CYAN,
+    MARKER_COLOR_GREEN,
+    MARKER_COLOR_YELLOW,
+    MARKER_COLOR_RED,
+    MARKER_COLOR_MAGENTA,
+    MARKER_COLOR_PURPLE,
+    MARKER_COLOR_ORANGE,
+    MARKER_COLOR_COUNT,
+};
+
+// Unknown names map to blue
+enum marker_color marker_color_from_name(const char *name);
+const char *marker_color_name(enum marker_color color);
+
+// One marker of a session. The strings point into the store's arena and stay
+// valid until the store is destroyed.
+struct stored_marker {
+    uint64_t timestamp_ns;
+    uint64_t frame;
+    const char *comment;
+    const char *name;
+    enum marker_color color;
+    uint32_t count; // hotkey presses coalesced into the marker
+};
+
+struct marker_arena_block;
+
+// All markers of one recording session, kept sorted by timestamp. The writer
+// thread adds to it; any thread may read through the locked accessors.
+struct marker_store {
+    pthread_mutex_t mutex;
+    DARRAY(struct stored_marker) markers;
+    struct marker_arena_block *blocks;
+};
+
+struct marker_store *marker_store_create(void);
+
+// Frees the markers and every string of the session in one go
+void marker_store_destroy(struct marker_store *store);
+
+void marker_store_add(struct marker_store *store, const struct marker_record *record);
+
+size_t marker_store_count(struct marker_store *store);
+
+// Copy marker `index` out into a record (strings included)
+bool marker_store_get(struct marker_store *store, size_t index, struct marker_record *record);
+
+// Index range [*first, *first + return value) of the markers with
+// start_ns <= timestamp_ns < end_ns
+size_t marker_store_range(struct marker_store *store, uint64_t start_ns, uint64_t end_ns, size_t *first);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,1306 @@
+#include "marker-writer.h"
+#include "chapter-export.h"
+#include "clock-drift.h"
+#include "job-queue.h"
+#include "marker-broadcast.h"
+#include "marker-export.h"
+#include "marker-journal.h"
+#include "marker-stats.h"
+#include "marker-store.h"
+#include "premiere-export.h"
+#include "session-index.h"
+#include "session-log.h"
+#include "session-manifest.h"
+#include "session-recovery.h"
+#include "timestamp-plugin.h"
+#include <util/darray.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// How long the writer sleeps when nobody signals it
+#define WRITER_IDLE_WAIT_MS 250
+
+// Upper bound for marker_writer_flush so a stuck disk can't hang the UI
+#define WRITER_FLUSH_TIMEOUT_MS 2000
+
+// How long session begin/end records wait for room in a full queue
+#define WRITER_CONTROL_TIMEOUT_MS 500
+
+// How often the latency summary is logged and the stats file rewritten
+#define WRITER_STATS_INTERVAL_MS 60000
+
+// How long a burst stays open past its window for presses still in the queue
+#define WRITER_COALESCE_GRACE_MS 20
+
+static struct marker_queue queue;
+static pthread_t writer_thread;
+static os_event_t *wake_event = NULL;
+static volatile bool writer_running = false;
+static volatile long records_processed = 0;
+static unsigned long dropped_reported = 0;
+
+// Session log state, only touched by the writer thread
+static bool session_open = false;
+static FILE *session_file = NULL;
+static struct marker_journal_writer *session_journal = NULL;
+static struct premiere_live_export *session_live_xml = NULL;
+static struct marker_broadcast *session_broadcast = NULL;
+static char session_live_path[1024];
+static struct marker_flush_policy session_flush;
+static char session_manifest[512];
+static int64_t session_manifest_offset = -1;
+static uint64_t session_data_offset = 0;
+static uint64_t session_log_offset = 0;     // where the next JSONL line goes
+static struct session_index session_index; // blocks of the JSONL log's marker lines
+static uint32_t unflushed_markers = 0;
+static uint64_t last_flush_ns = 0;
+static uint64_t last_stats_ns = 0;
+
+// Hotkey burst waiting for more presses, and the auto-repeat schedule
+static struct marker_record burst_record;
+static bool burst_open = false;
+static uint64_t burst_deadline_ns = 0;
+static struct marker_record scene_record; // scene switch waiting for the next one
+static bool scene_open = false;
+static uint64_t scene_deadline_ns = 0;
+static uint64_t repeat_next_ns = 0; // on the recording timeline
+static uint32_t repeat_number = 0;
+
+// Media time against the clock: the open file's correction table, sampled
+// every CLOCK_DRIFT_SAMPLE_MS. The drift of the first sample of a recording
+// is the pipeline's latency rather than drift, so the tables count from it.
+static struct clock_drift session_drift;
+static uint64_t drift_next_ns = 0;
+static int64_t drift_origin_ns = 0; // drift the open file's table counts from
+static bool drift_origin_set = false;
+static int64_t drift_last_ns = 0; // latest sample, the origin of the next file
+
+// Write times of the markers not flushed yet, for the write-to-durable stat
+static DARRAY(uint64_t) unflushed_write_ns;
+
+// Markers of the open session, kept for the exporter that runs at stop. The
+// writer swaps session_store under store_mutex so the public query API can
+// read it from any thread.
+static struct marker_session_info *session_info = NULL;
+static struct marker_store *session_store = NULL;
+static uint32_t session_segment = 0;          // session_info's, for the query API
+static uint64_t session_segment_start_ns = 0;
+static pthread_mutex_t store_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Push buffered data to the OS, and to the disk itself when asked to
+static void sync_session_file(bool durable)
+{
+    if (session_file) {
+        if (fflush(session_file) != 0) {
+            blog(LOG_WARNING, "Timestamp Plugin: Failed to flush timestamp file");
+            marker_stats_count(MARKER_COUNTER_FAILED_WRITES);
+        }
+
+        if (durable) {
+#ifdef _WIN32
+            _commit(_fileno(session_file));
+#else
+            fsync(fileno(session_file));
+#endif
+        }
+    }
+
+    if (session_journal) {
+        marker_journal_sync(session_journal, durable);
+    }
+
+    // The sidecar is a convenience copy; it never needs to hit the disk
+    if (session_live_xml) {
+        premiere_live_flush(session_live_xml);
+    }
+
+    uint64_t now = os_gettime_ns();
+    for (size_t i = 0; i < unflushed_write_ns.num; i++) {
+        marker_stats_record(MARKER_STAT_WRITE_TO_DURABLE, now - unflushed_write_ns.array[i]);
+    }
+    da_clear(unflushed_write_ns);
+
+    unflushed_markers = 0;
+    last_flush_ns = now;
+}
+
+// Apply the session's durability policy after a line has been written
+static void apply_flush_policy(void)
+{
+    unflushed_markers++;
+
+    switch (session_flush.mode) {
+    case MARKER_FLUSH_FSYNC:
+        sync_session_file(true);
+        break;
+    case MARKER_FLUSH_COUNT:
+        if (unflushed_markers >= session_flush.every_markers) {
+            sync_session_file(false);
+        }
+        break;
+    case MARKER_FLUSH_INTERVAL:
+        // Handled by the writer loop timer
+        break;
+    }
+}
+
+// Move a marker from the recording timeline onto the open segment's. One
+// taken before the split but queued after it lands on the segment's start.
+static const struct marker_record *to_segment_time(struct marker_record *record)
+{
+    uint64_t start_ns = session_info->segment_start_ns;
+    uint64_t start_frame = recording_clock_frame(&session_info->clock, start_ns);
+
+    if (record->timestamp_ns < start_ns) {
+        blog(LOG_INFO, "Timestamp Plugin: Marker at %" PRIu64 "ms predates the file split, moved to its start",
+             record->timestamp_ms);
+        record->timestamp_ns = start_ns;
+    }
+
+    record->timestamp_ns -= start_ns;
+    record->timestamp_ms = record->timestamp_ns / 1000000;
+    record->frame = record->frame > start_frame ? record->frame - start_frame : 0;
+    return record;
+}
+
+// Write one marker to the session log (JSON Lines and/or binary journal)
+static void write_marker_record(const struct marker_record *record)
+{
+    if (!session_open) {
+        blog(LOG_WARNING, "Timestamp Plugin: Marker at %" PRIu64 "ms dropped, no session log open",
+             record->timestamp_ms);
+        return;
+    }
+
+    // Taken in a recording that has stopped (or not started) by now; it
+    // would land at a meaningless position in this one
+    if (record->generation && record->generation != session_info->generation) {
+        blog(LOG_WARNING, "Timestamp Plugin: Marker at %" PRIu64 "ms rejected, it belongs to another session",
+             record->timestamp_ms);
+        marker_stats_count(MARKER_COUNTER_STALE);
+        return;
+    }
+
+    // The log of a later file of a split recording counts from the split,
+    // like the file itself
+    struct marker_record segment_record;
+    if (session_info->segment_start_ns) {
+        segment_record = *record;
+        record = to_segment_time(&segment_record);
+    }
+
+    // Receivers react to markers as they happen, so they get them before the disk
+    if (session_broadcast) {
+        marker_broadcast_marker(session_broadcast, record);
+    }
+
+    bool ok = true;
+
+    // One sealed line, written in one piece, so a crash can only tear the last one
+    if (session_file) {
+        char line[SESSION_LOG_LINE_SIZE];
+        int length = session_log_format_marker(line, sizeof(line), record);
+        ok = length > 0 && fwrite(line, 1, (size_t)length, session_file) == (size_t)length;
+
+        if (ok) {
+            session_index_add(&session_index, session_log_offset, (uint64_t)length, record->timestamp_ms);
+            session_log_offset += (uint64_t)length;
+        } else {
+            // A partial line breaks the block it would have joined
+            int64_t offset = os_ftelli64(session_file);
+            session_log_offset = offset > 0 ? (uint64_t)offset : session_log_offset;
+        }
+    }
+
+    if (session_journal && !marker_journal_append(session_journal, record)) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to append marker to journal");
+        ok = false;
+    }
+
+    if (session_live_xml && !premiere_live_add(session_live_xml, record)) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to update live XML sidecar");
+    }
+
+    uint64_t written_ns = os_gettime_ns();
+    if (ok) {
+        marker_stats_count(MARKER_COUNTER_WRITTEN);
+    } else {
+        marker_stats_count(MARKER_COUNTER_FAILED_WRITES);
+    }
+
+    // Markers the writer creates itself were never queued
+    if (record->queued_ns) {
+        marker_stats_record(MARKER_STAT_ENQUEUE_TO_WRITE, written_ns - record->queued_ns);
+    }
+    da_push_back(unflushed_write_ns, &written_ns);
+
+    apply_flush_policy();
+
+    marker_store_add(session_store, record);
+
+    blog(LOG_INFO, "Timestamp Plugin: Saved marker at %" PRIu64 "ms: %s",
+         record->timestamp_ms, record->comment[0] ? record->comment : "(no comment)");
+}
+
+// Write out the open burst as one marker carrying its press count
+static void close_burst(void)
+{
+    if (!burst_open) {
+        return;
+    }
+    burst_open = false;
+
+    if (burst_record.count > 1) {
+        size_t len = strlen(burst_record.comment);
+        snprintf(burst_record.comment + len, sizeof(burst_record.comment) - len, " (x%u)", burst_record.count);
+    }
+    write_marker_record(&burst_record);
+}
+
+// Write out the held scene marker, with the number of switches it stands for
+static void close_scene(void)
+{
+    if (!scene_open) {
+        return;
+    }
+    scene_open = false;
+
+    if (scene_record.count > 1) {
+        size_t len = strlen(scene_record.comment);
+        snprintf(scene_record.comment + len, sizeof(scene_record.comment) - len, " (x%u)", scene_record.count);
+    }
+    write_marker_record(&scene_record);
+    marker_stats_count(MARKER_COUNTER_SCENE);
+}
+
+// Whether a marker held for coalescing lies at or before ns on the timeline.
+// Repeat markers wait for it, so the log stays in time order.
+static bool held_before(uint64_t ns)
+{
+    return (burst_open && burst_record.timestamp_ns <= ns) || (scene_open && scene_record.timestamp_ns <= ns);
+}
+
+// Add the auto-repeat markers due up to until_ns on the recording timeline.
+// They sit on exact multiples of the interval however late the writer wakes.
+static void emit_repeat_markers(uint64_t until_ns)
+{
+    if (!session_open || !session_info->repeat_ms) {
+        return;
+    }
+
+    while (repeat_next_ns <= until_ns) {
+        // A held marker from before this point goes into the log first
+        if (held_before(repeat_next_ns)) {
+            return;
+        }
+
+        struct marker_record record = {0};
+        record.type = MARKER_RECORD_MARKER;
+        record.generation = session_info->generation;
+        record.timestamp_ns = repeat_next_ns;
+        record.timestamp_ms = repeat_next_ns / 1000000;
+        record.frame = recording_clock_frame(&session_info->clock, repeat_next_ns);
+        record.count = 1;
+        snprintf(record.comment, sizeof(record.comment), "Auto %u", ++repeat_number);
+        snprintf(record.color, sizeof(record.color), "cyan");
+
+        write_marker_record(&record);
+        marker_stats_count(MARKER_COUNTER_REPEAT);
+
+        repeat_next_ns += (uint64_t)session_info->repeat_ms * 1000000ULL;
+    }
+}
+
+// A queued marker: presses inside the coalescing window add to the open
+// burst, everything else closes it and is written in order behind it. Scene
+// switches are held the same way, each one replacing the last.
+static void handle_marker(const struct marker_record *record)
+{
+    if (record->burst == MARKER_BURST_MERGE && burst_open && record->generation == burst_record.generation) {
+        burst_record.count++;
+        burst_deadline_ns = record->queued_ns +
+                            (uint64_t)(session_info->coalesce_ms + WRITER_COALESCE_GRACE_MS) * 1000000ULL;
+        marker_stats_count(MARKER_COUNTER_COALESCED);
+        return;
+    }
+
+    // The scene the operator settles on names the marker, at the time it
+    // went to program; the ones flicked past on the way only add to the count
+    if (record->burst == MARKER_BURST_SCENE && scene_open && record->generation == scene_record.generation) {
+        uint32_t count = scene_record.count + 1;
+        scene_record = *record;
+        scene_record.count = count;
+        scene_deadline_ns = record->queued_ns +
+                            (uint64_t)(session_info->scene_coalesce_ms + WRITER_COALESCE_GRACE_MS) * 1000000ULL;
+        marker_stats_count(MARKER_COUNTER_SCENE_MERGED);
+        return;
+    }
+
+    // At most one of them is open, since opening either closes the other
+    close_burst();
+    close_scene();
+
+    // Repeat markers due before this one go first, but never ahead of the
+    // clock: save_timestamp callers may pass any time they like
+    if (session_open) {
+        uint64_t now_ns = recording_clock_elapsed_ns(&session_info->clock, os_gettime_ns());
+        emit_repeat_markers(record->timestamp_ns < now_ns ? record->timestamp_ns : now_ns);
+    }
+
+    if (record->burst == MARKER_BURST_SCENE) {
+        if (session_open && session_info->scene_coalesce_ms) {
+            scene_record = *record;
+            scene_record.count = 1;
+            scene_open = true;
+            scene_deadline_ns = record->queued_ns +
+                                (uint64_t)(session_info->scene_coalesce_ms + WRITER_COALESCE_GRACE_MS) * 1000000ULL;
+            return;
+        }
+
+        write_marker_record(record);
+        marker_stats_count(MARKER_COUNTER_SCENE);
+        return;
+    }
+
+    if (record->burst != MARKER_BURST_NONE && session_open && session_info->coalesce_ms) {
+        burst_record = *record;
+        burst_record.count = 1;
+        burst_open = true;
+        burst_deadline_ns = record->queued_ns +
+                            (uint64_t)(session_info->coalesce_ms + WRITER_COALESCE_GRACE_MS) * 1000000ULL;
+        return;
+    }
+
+    write_marker_record(record);
+}
+
+// Close a burst or scene marker whose window has passed and add the repeat
+// markers that are due
+static void run_marker_timers(void)
+{
+    if (!session_open) {
+        return;
+    }
+
+    uint64_t now = os_gettime_ns();
+    if (burst_open && now >= burst_deadline_ns) {
+        close_burst();
+    }
+    if (scene_open && now >= scene_deadline_ns) {
+        close_scene();
+    }
+    emit_repeat_markers(recording_clock_elapsed_ns(&session_info->clock, now));
+
+    if (now >= drift_next_ns) {
+        drift_next_ns = now + (uint64_t)CLOCK_DRIFT_SAMPLE_MS * 1000000ULL;
+
+        uint64_t elapsed_ns;
+        int64_t drift_ns;
+        if (recording_clock_measure(&session_info->clock, &elapsed_ns, &drift_ns)) {
+            if (!drift_origin_set) {
+                drift_origin_ns = drift_ns;
+                drift_origin_set = true;
+            }
+            drift_last_ns = drift_ns;
+
+            if (elapsed_ns > session_info->segment_start_ns) {
+                clock_drift_add(&session_drift, elapsed_ns - session_info->segment_start_ns,
+                                drift_ns - drift_origin_ns);
+            }
+        }
+    }
+}
+
+// Log the latency summary and rewrite the stats file in the config directory
+static void report_stats(void)
+{
+    last_stats_ns = os_gettime_ns();
+    if (!marker_stats_changed()) {
+        return;
+    }
+
+    uint64_t dropped = marker_queue_dropped(&queue);
+    marker_stats_log_summary(dropped);
+
+    // Counters cover every session, so there is one file for the plugin
+    char *stats_path = obs_module_config_path("timestamps_stats.json");
+    if (stats_path) {
+        marker_stats_write_json(stats_path, dropped);
+        bfree(stats_path);
+    }
+}
+
+// A finished session handed from the writer to the job queue
+struct export_job {
+    struct marker_session_info *info;
+    struct marker_store *store;
+    struct clock_drift drift; // applied to the store before export
+    char live_path[1024]; // live sidecar the export supersedes, if any
+};
+
+// Export the markers collected in memory in every enabled format (and write
+// chapters, if enabled)
+static void export_job_run(void *data)
+{
+    struct export_job *job = data;
+    uint32_t formats = job->info->export_formats ? job->info->export_formats : MARKER_EXPORT_DEFAULT;
+
+    blog(LOG_INFO, "Timestamp Plugin: %zu marker(s) created, exporting", job->store->markers.num - 2);
+
+    // Every format, and the chapters, get the media times
+    clock_drift_apply(&job->drift, &job->info->clock, job->store);
+
+    uint32_t written = marker_export_run(job->info, job->store, formats);
+
+    if (formats & (1u << MARKER_EXPORT_PREMIERE)) {
+        if (written & (1u << MARKER_EXPORT_PREMIERE)) {
+            blog(LOG_INFO, "Timestamp Plugin: XML markers generated successfully");
+
+            // The video turned out to have another name than at start
+            char xml_path[1024];
+            marker_export_output_path(job->info, MARKER_EXPORT_PREMIERE, xml_path, sizeof(xml_path));
+            if (job->live_path[0] && strcmp(job->live_path, xml_path) != 0) {
+                os_unlink(job->live_path);
+            }
+        } else {
+            blog(LOG_WARNING, "Timestamp Plugin: XML export failed, you can run timestamp_to_premiere.py on %s",
+                 job->info->path);
+        }
+    }
+
+    // The recording is complete by now (this runs after RECORDING_STOPPED)
+    if (job->info->chapters && job->info->video_path[0]) {
+        chapter_export_write(job->info->video_path, job->store);
+    }
+}
+
+static void export_job_free(void *data)
+{
+    struct export_job *job = data;
+
+    marker_store_destroy(job->store);
+    clock_drift_free(&job->drift);
+    bfree(job->info);
+    bfree(job);
+}
+
+// Recreate the JSON Lines log from a closed binary journal
+static void journal_dump_job_run(void *data)
+{
+    struct marker_session_info *info = data;
+    struct marker_journal_reader reader;
+    char journal_path[512];
+
+    session_log_sibling_path(info->path, MARKER_JOURNAL_EXTENSION, journal_path, sizeof(journal_path));
+    if (!marker_journal_open(&reader, journal_path)) {
+        return;
+    }
+
+    if (marker_journal_dump_jsonl(&reader, info->path, info->video_path)) {
+        blog(LOG_INFO, "Timestamp Plugin: Dumped %zu journal record(s) to %s", reader.count, info->path);
+    }
+
+    marker_journal_unmap(&reader);
+}
+
+static void queue_journal_dump(const struct marker_session_info *info)
+{
+    struct marker_session_info *copy = bmalloc(sizeof(*copy));
+    *copy = *info;
+
+    if (!job_queue_push("journal-dump", journal_dump_job_run, bfree, copy)) {
+        journal_dump_job_run(copy);
+        bfree(copy);
+    }
+}
+
+// Take the store away from the query API; the caller now owns it
+static struct marker_store *detach_session_store(void)
+{
+    pthread_mutex_lock(&store_mutex);
+    struct marker_store *store = session_store;
+    session_store = NULL;
+    session_segment = 0;
+    session_segment_start_ns = 0;
+    pthread_mutex_unlock(&store_mutex);
+    return store;
+}
+
+// Hand a finished session to the job queue so the writer is free for the
+// next recording straight away; takes ownership of info, store and the drift
+// table (if any)
+static void queue_export(struct marker_session_info *info, struct marker_store *store, const char *live_path,
+                         struct clock_drift *drift)
+{
+    // The start and end markers are always present; only export when the
+    // user created markers of their own in between
+    if (store->markers.num <= 2) {
+        blog(LOG_INFO, "Timestamp Plugin: No markers created, skipping XML conversion");
+        marker_store_destroy(store);
+        if (drift) {
+            clock_drift_free(drift);
+        }
+        if (live_path[0]) {
+            os_unlink(live_path);
+        }
+        bfree(info);
+        return;
+    }
+
+    struct export_job *job = bzalloc(sizeof(*job));
+    job->info = info;
+    job->store = store;
+    if (drift) {
+        job->drift = *drift;
+        da_init(drift->points);
+    }
+    snprintf(job->live_path, sizeof(job->live_path), "%s", live_path);
+
+    if (!job_queue_push("marker-export", export_job_run, export_job_free, job)) {
+        // No job queue (shutting down), export on this thread instead
+        export_job_run(job);
+        export_job_free(job);
+    }
+}
+
+static void export_session(void)
+{
+    queue_export(session_info, detach_session_store(), session_live_path, &session_drift);
+    session_info = NULL;
+}
+
+static void close_session(const char *video_path)
+{
+    if (session_open) {
+        close_burst();
+        close_scene();
+
+        if (video_path && *video_path) {
+            snprintf(session_info->video_path, sizeof(session_info->video_path), "%s", video_path);
+        }
+
+        struct session_manifest_summary summary = {0};
+        summary.begin_offset = session_manifest_offset;
+        summary.markers = marker_store_count(session_store);
+
+        if (session_file) {
+            int64_t end_offset = os_ftelli64(session_file);
+            summary.data_offset = session_data_offset;
+            summary.end_offset = end_offset > 0 ? (uint64_t)end_offset : 0;
+
+            // The header went out before the file name was final, so the
+            // path follows the markers as a second metadata line
+            if (session_info->video_path[0]) {
+                char line[SESSION_LOG_LINE_SIZE];
+                int length = session_log_format_trailer(line, sizeof(line), session_info->video_path, false);
+                if (length > 0) {
+                    fwrite(line, 1, (size_t)length, session_file);
+                }
+            }
+        }
+
+        clock_drift_finish(&session_drift);
+        clock_drift_log(&session_drift);
+        if (session_file && !clock_drift_write(&session_drift, session_file)) {
+            blog(LOG_WARNING, "Timestamp Plugin: Failed to write the clock drift table");
+        }
+
+        sync_session_file(session_flush.mode == MARKER_FLUSH_FSYNC);
+
+        if (session_file) {
+            fclose(session_file);
+            session_file = NULL;
+
+            if (session_index.blocks.num && session_index_write(&session_index, session_info->path)) {
+                summary.index_blocks = session_index.blocks.num;
+            }
+        }
+        session_index_free(&session_index);
+
+        premiere_live_close(session_live_xml);
+        session_live_xml = NULL;
+
+        marker_broadcast_close(session_broadcast);
+        session_broadcast = NULL;
+
+        if (session_journal) {
+            bool finalized = marker_journal_close(session_journal, &session_drift);
+            session_journal = NULL;
+
+            char journal_path[512];
+            session_log_sibling_path(session_info->path, MARKER_JOURNAL_EXTENSION, journal_path, sizeof(journal_path));
+            int64_t journal_size = os_get_file_size(journal_path);
+            summary.journal_size = journal_size > 0 ? (uint64_t)journal_size : 0;
+
+            if (finalized && session_info->log_format == MARKER_LOG_BINARY && session_info->dump_jsonl) {
+                queue_journal_dump(session_info);
+            }
+        }
+
+        session_open = false;
+        session_manifest_end(session_manifest, session_info, &summary);
+        report_stats();
+        export_session();
+        session_live_path[0] = '\0';
+    }
+    da_free(unflushed_write_ns);
+
+    bfree(session_info);
+    session_info = NULL;
+}
+
+// Whether a session log (or its journal) already exists at path
+static bool session_exists(const char *path)
+{
+    char journal_path[512];
+    session_log_sibling_path(path, MARKER_JOURNAL_EXTENSION, journal_path, sizeof(journal_path));
+    return os_file_exists(path) || os_file_exists(journal_path);
+}
+
+// Never overwrite an earlier session: "name.jsonl" -> "name (2).jsonl".
+// False if the numbered name doesn't fit, rather than open a cut-off one.
+static bool make_session_path_unique(struct marker_session_info *info)
+{
+    char base[512];
+    session_log_sibling_path(info->path, "", base, sizeof(base));
+
+    for (int n = 2; session_exists(info->path) && n < 1000; n++) {
+        int length = snprintf(info->path, sizeof(info->path), "%s (%d).jsonl", base, n);
+        if (length < 0 || (size_t)length >= sizeof(info->path)) {
+            blog(LOG_ERROR, "Timestamp Plugin: Session log path too long: %s (%d).jsonl", base, n);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Create the session log, write its metadata header and index it in the manifest
+static void open_session(struct marker_session_info *info)
+{
+    close_session(NULL);
+    if (!make_session_path_unique(info)) {
+        bfree(info);
+        return;
+    }
+
+    if (info->log_format != MARKER_LOG_BINARY) {
+        session_file = fopen(info->path, "w");
+        if (!session_file) {
+            blog(LOG_ERROR, "Timestamp Plugin: Failed to create output file: %s", info->path);
+        }
+    }
+
+    if (info->log_format != MARKER_LOG_JSONL) {
+        char journal_path[512];
+        session_log_sibling_path(info->path, MARKER_JOURNAL_EXTENSION, journal_path, sizeof(journal_path));
+        session_journal = marker_journal_create(journal_path, info);
+    }
+
+    if (!session_file && !session_journal) {
+        bfree(info);
+        return;
+    }
+
+    session_open = true;
+    session_info = info;
+
+    struct marker_store *store = marker_store_create();
+    pthread_mutex_lock(&store_mutex);
+    session_store = store;
+    session_segment = info->segment;
+    session_segment_start_ns = info->segment_start_ns;
+    pthread_mutex_unlock(&store_mutex);
+
+    session_flush = info->flush;
+    if (session_flush.every_markers == 0) {
+        session_flush.every_markers = 1;
+    }
+    if (session_flush.interval_ms == 0) {
+        session_flush.interval_ms = 1000;
+    }
+    unflushed_markers = 0;
+
+    burst_open = false;
+    scene_open = false;
+    repeat_next_ns = info->segment_start_ns + (uint64_t)info->repeat_ms * 1000000ULL;
+    repeat_number = 0;
+
+    // A later file's table counts from the drift at the split
+    clock_drift_init(&session_drift, &info->clock);
+    drift_next_ns = os_gettime_ns() + (uint64_t)CLOCK_DRIFT_SAMPLE_MS * 1000000ULL;
+    if (!info->segment) {
+        drift_origin_set = false;
+    } else {
+        drift_origin_ns = drift_last_ns;
+    }
+
+    if (info->live_xml) {
+        marker_export_output_path(info, MARKER_EXPORT_PREMIERE, session_live_path, sizeof(session_live_path));
+        session_live_xml = premiere_live_open(session_live_path, info);
+        if (!session_live_xml) {
+            session_live_path[0] = '\0';
+        }
+    }
+
+    if (info->broadcast_address[0]) {
+        session_broadcast = marker_broadcast_open(info->broadcast_address, info);
+    }
+
+    // Write metadata header (the journal carries it in its binary header)
+    if (session_file) {
+        char line[SESSION_LOG_LINE_SIZE];
+        int length = session_log_format_header(line, sizeof(line), info->recording_path, info->start_time,
+                                               info->fps_num, info->fps_den);
+        if (length > 0) {
+            fwrite(line, 1, (size_t)length, session_file);
+        }
+
+        if (info->segment) {
+            length = session_log_format_segment(line, sizeof(line), info->segment, info->segment_start_ns / 1000000,
+                                                recording_clock_frame(&info->clock, info->segment_start_ns),
+                                                info->previous_segment);
+            if (length > 0) {
+                fwrite(line, 1, (size_t)length, session_file);
+            }
+        }
+
+        int64_t data_offset = os_ftelli64(session_file);
+        session_data_offset = data_offset > 0 ? (uint64_t)data_offset : 0;
+    }
+    session_log_offset = session_data_offset;
+    session_index_init(&session_index);
+
+    session_manifest_path(info->path, session_manifest, sizeof(session_manifest));
+    session_manifest_offset = session_manifest_begin(session_manifest, info);
+
+    // Add initial marker at 0 (of the file, for a later segment)
+    struct marker_record start = {0};
+    start.type = MARKER_RECORD_MARKER;
+    start.timestamp_ns = info->segment_start_ns;
+    start.frame = recording_clock_frame(&info->clock, info->segment_start_ns);
+    snprintf(start.comment, sizeof(start.comment), info->segment ? "Segment Start" : "Recording Start");
+    snprintf(start.color, sizeof(start.color), "blue");
+    write_marker_record(&start);
+
+    // Make sure the header is visible even if no marker follows
+    sync_session_file(session_flush.mode == MARKER_FLUSH_FSYNC);
+}
+
+// Log for the file a split recording continues in: next to the current log
+// and named after the file, like the first ("part 2.mkv" -> "part 2.jsonl");
+// false if the path does not fit
+static bool get_segment_path(const char *session_path, const char *video_path, char *buffer, size_t size)
+{
+    const char *name = session_log_file_name(video_path);
+    size_t name_len = session_log_stem_length(video_path) - (size_t)(name - video_path);
+    size_t dir_len = (size_t)(session_log_file_name(session_path) - session_path);
+
+    int length;
+    if (name_len) {
+        length = snprintf(buffer, size, "%.*s%.*s.jsonl", (int)dir_len, session_path, (int)name_len, name);
+    } else {
+        char stamp[64];
+        time_t now = time(NULL);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H-%M-%S", localtime(&now));
+        length = snprintf(buffer, size, "%.*s%s.jsonl", (int)dir_len, session_path, stamp);
+    }
+    return length >= 0 && (size_t)length < size;
+}
+
+// The output finished one file and carries on in the next: close and export
+// the session of the finished file as stop would, and open one for the next.
+// The recording timeline, and with it the repeat schedule, runs on.
+static void split_session(const struct marker_record *record)
+{
+    if (!session_open) {
+        return;
+    }
+    if (record->generation && record->generation != session_info->generation) {
+        blog(LOG_WARNING, "Timestamp Plugin: File split rejected, it belongs to another session");
+        return;
+    }
+
+    // The new file starts on a frame, and so does its timeline. Rounded up,
+    // so a marker taken before the signal stays in the finished file.
+    const struct recording_clock *clock = &session_info->clock;
+    uint64_t split_frame = recording_clock_frame(clock, record->timestamp_ns);
+    uint64_t split_ns = recording_clock_frame_ns(clock, split_frame);
+    if (split_ns < record->timestamp_ns) {
+        split_ns = recording_clock_frame_ns(clock, split_frame + 1);
+    }
+    if (split_ns < session_info->segment_start_ns) {
+        split_ns = session_info->segment_start_ns;
+    }
+
+    // Everything up to the split belongs to the finished file
+    close_burst();
+    close_scene();
+    emit_repeat_markers(split_ns);
+
+    struct marker_record end = {0};
+    end.type = MARKER_RECORD_MARKER;
+    end.generation = session_info->generation;
+    end.timestamp_ns = split_ns;
+    end.timestamp_ms = split_ns / 1000000;
+    end.frame = recording_clock_frame(clock, split_ns);
+    end.count = 1;
+    snprintf(end.comment, sizeof(end.comment), "Segment End");
+    snprintf(end.color, sizeof(end.color), "green");
+    write_marker_record(&end);
+
+    struct marker_session_info *next = bmalloc(sizeof(*next));
+    *next = *session_info;
+    next->segment = session_info->segment + 1;
+    next->segment_start_ns = split_ns;
+    snprintf(next->previous_segment, sizeof(next->previous_segment), "%s", session_info->path);
+    snprintf(next->video_path, sizeof(next->video_path), "%s", record->data ? (const char *)record->data : "");
+    if (!get_segment_path(session_info->path, next->video_path, next->path, sizeof(next->path))) {
+        blog(LOG_ERROR, "Timestamp Plugin: Session log path too long for %s, the rest of the recording is not logged",
+             next->video_path);
+        bfree(next);
+        close_session(NULL);
+        return;
+    }
+
+    time_t now = time(NULL);
+    next->start_epoch = (int64_t)now;
+    strftime(next->start_time, sizeof(next->start_time), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+    uint64_t next_repeat_ns = repeat_next_ns;
+    uint32_t number = repeat_number;
+
+    // The finished file keeps the name it had at its start
+    close_session(NULL);
+    open_session(next);
+
+    if (session_open) {
+        repeat_next_ns = next_repeat_ns;
+        repeat_number = number;
+        blog(LOG_INFO, "Timestamp Plugin: Recording split at %" PRIu64 "ms, segment %u log: %s",
+             split_ns / 1000000, session_info->segment, session_info->path);
+    }
+}
+
+// The recording was paused or resumed. Only the pause state is taken over;
+// the timers stop with the timeline and continue from where it stopped.
+static void pause_session(const struct marker_record *record)
+{
+    const struct recording_clock *clock = record->data;
+    if (!session_open) {
+        return;
+    }
+    if (record->generation && record->generation != session_info->generation) {
+        blog(LOG_WARNING, "Timestamp Plugin: Pause rejected, it belongs to another session");
+        return;
+    }
+
+    session_info->clock.first_frame_ns = clock->first_frame_ns;
+    session_info->clock.pause_ns = clock->pause_ns;
+    session_info->clock.paused_ns = clock->paused_ns;
+}
+
+// Close the session a crash left open in session_dir and export it the way
+// stop would have. Runs before any new session can open, so the files are
+// not in use.
+static void recover_session(const char *session_dir)
+{
+    char manifest[512];
+    snprintf(manifest, sizeof(manifest), "%s/%s", session_dir, SESSION_MANIFEST_NAME);
+
+    struct session_manifest_summary summary = {0};
+    struct marker_session_info *info = session_recovery_find(manifest, &summary.begin_offset);
+    if (!info) {
+        return;
+    }
+
+    blog(LOG_WARNING, "Timestamp Plugin: %s was not closed by the last run, recovering it", info->path);
+
+    // Closed in the manifest even when nothing was readable, so the next
+    // load doesn't try again
+    struct clock_drift drift = {0};
+    struct marker_store *store = session_recovery_repair(info, &summary, &drift);
+    summary.recovered = true;
+    session_manifest_end(manifest, info, &summary);
+
+    if (store) {
+        queue_export(info, store, "", &drift);
+    } else {
+        clock_drift_free(&drift);
+        bfree(info);
+    }
+}
+
+// Drain everything currently in the queue
+static void drain_queue(void)
+{
+    struct marker_record record;
+
+    while (marker_queue_pop(&queue, &record)) {
+        switch (record.type) {
+        case MARKER_RECORD_MARKER:
+            handle_marker(&record);
+            break;
+        case MARKER_RECORD_SESSION_BEGIN:
+            open_session(record.data);
+            break;
+        case MARKER_RECORD_SESSION_END:
+            close_session(record.data);
+            bfree(record.data);
+            break;
+        case MARKER_RECORD_SESSION_RECOVER:
+            recover_session(record.data);
+            bfree(record.data);
+            break;
+        case MARKER_RECORD_SESSION_SPLIT:
+            split_session(&record);
+            bfree(record.data);
+            break;
+        case MARKER_RECORD_SESSION_PAUSE:
+            pause_session(&record);
+            bfree(record.data);
+            break;
+        }
+
+        os_atomic_inc_long(&records_processed);
+    }
+
+    unsigned long dropped = marker_queue_dropped(&queue);
+    if (dropped != dropped_reported) {
+        blog(LOG_WARNING, "Timestamp Plugin: Marker queue full, %lu marker(s) dropped (%lu total)",
+             dropped - dropped_reported, dropped);
+        dropped_reported = dropped;
+    }
+}
+
+// Whether the interval flush policy wants the buffered markers written now
+static bool interval_flush_due(void)
+{
+    return session_open && session_flush.mode == MARKER_FLUSH_INTERVAL && unflushed_markers > 0 &&
+           (os_gettime_ns() - last_flush_ns) / 1000000 >= session_flush.interval_ms;
+}
+
+// Milliseconds from now_ns until deadline_ns, rounded up
+static unsigned long ms_until(uint64_t deadline_ns, uint64_t now_ns)
+{
+    return deadline_ns > now_ns ? (unsigned long)((deadline_ns - now_ns + 999999) / 1000000) : 0;
+}
+
+// How long to sleep before a flush, a held marker or a repeat marker is due
+static unsigned long next_wait_ms(void)
+{
+    unsigned long wait_ms = WRITER_IDLE_WAIT_MS;
+    if (!session_open) {
+        return wait_ms;
+    }
+
+    uint64_t now = os_gettime_ns();
+    unsigned long due;
+
+    if (session_flush.mode == MARKER_FLUSH_INTERVAL && unflushed_markers > 0) {
+        due = ms_until(last_flush_ns + (uint64_t)session_flush.interval_ms * 1000000ULL, now);
+        wait_ms = due < wait_ms ? due : wait_ms;
+    }
+    if (burst_open) {
+        due = ms_until(burst_deadline_ns, now);
+        wait_ms = due < wait_ms ? due : wait_ms;
+    }
+    if (scene_open) {
+        due = ms_until(scene_deadline_ns, now);
+        wait_ms = due < wait_ms ? due : wait_ms;
+    }
+    // A repeat marker held back behind a burst or scene waits for its
+    // deadline, and none is due before a pause ends
+    if (session_info->repeat_ms && !held_before(repeat_next_ns) && !recording_clock_paused(&session_info->clock)) {
+        due = ms_until(session_info->clock.first_frame_ns + repeat_next_ns, now);
+        wait_ms = due < wait_ms ? due : wait_ms;
+    }
+    return wait_ms;
+}
+
+static void *writer_thread_func(void *data)
+{
+    UNUSED_PARAMETER(data);
+
+    os_set_thread_name("timestamp-writer");
+
+    while (os_atomic_load_bool(&writer_running)) {
+        unsigned long wait_ms = next_wait_ms();
+        if (wait_ms > 0) {
+            os_event_timedwait(wake_event, wait_ms);
+        }
+
+        drain_queue();
+        run_marker_timers();
+
+        if (interval_flush_due()) {
+            sync_session_file(false);
+        }
+
+        if (os_gettime_ns() - last_stats_ns >= (uint64_t)WRITER_STATS_INTERVAL_MS * 1000000ULL) {
+            report_stats();
+        }
+    }
+
+    // Write out whatever was queued before shutdown
+    drain_queue();
+    close_session(NULL);
+    return NULL;
+}
+
+// Start the writer thread
+bool marker_writer_start(void)
+{
+    if (os_atomic_load_bool(&writer_running)) {
+        return true;
+    }
+
+    if (!marker_queue_init(&queue)) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to allocate marker queue");
+        return false;
+    }
+
+    if (os_event_init(&wake_event, OS_EVENT_TYPE_AUTO) != 0) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to create writer event");
+        marker_queue_free(&queue);
+        return false;
+    }
+
+    os_atomic_set_long(&records_processed, 0);
+    dropped_reported = 0;
+    last_stats_ns = os_gettime_ns();
+    os_atomic_set_bool(&writer_running, true);
+
+    if (pthread_create(&writer_thread, NULL, writer_thread_func, NULL) != 0) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to start writer thread");
+        os_atomic_set_bool(&writer_running, false);
+        os_event_destroy(wake_event);
+        wake_event = NULL;
+        marker_queue_free(&queue);
+        return false;
+    }
+
+    blog(LOG_INFO, "Timestamp Plugin: Writer thread started (%d slots)", MARKER_QUEUE_CAPACITY);
+    return true;
+}
+
+// Stop the writer thread after it has written all pending markers
+void marker_writer_stop(void)
+{
+    if (!os_atomic_load_bool(&writer_running)) {
+        return;
+    }
+
+    os_atomic_set_bool(&writer_running, false);
+    os_event_signal(wake_event);
+    pthread_join(writer_thread, NULL);
+
+    os_event_destroy(wake_event);
+    wake_event = NULL;
+
+    blog(LOG_INFO, "Timestamp Plugin: Writer thread stopped (%lu marker(s) dropped)",
+         marker_queue_dropped(&queue));
+
+    marker_queue_free(&queue);
+}
+
+// Enqueue a marker, never blocks the caller
+bool marker_writer_push(const struct marker_record *record)
+{
+    if (!os_atomic_load_bool(&writer_running)) {
+        return false;
+    }
+
+    if (!marker_queue_push(&queue, record)) {
+        return false;
+    }
+
+    os_event_signal(wake_event);
+    return true;
+}
+
+size_t marker_writer_push_batch(const struct marker_record *records, size_t count)
+{
+    if (!os_atomic_load_bool(&writer_running) || count == 0) {
+        return 0;
+    }
+
+    size_t pushed = marker_queue_push_batch(&queue, records, count);
+    if (pushed) {
+        os_event_signal(wake_event);
+    }
+    return pushed;
+}
+
+// Session records must not be dropped, so wait briefly for room instead
+static bool push_control_record(const struct marker_record *record)
+{
+    uint64_t deadline = os_gettime_ns() + (uint64_t)WRITER_CONTROL_TIMEOUT_MS * 1000000ULL;
+
+    while (!marker_writer_push(record)) {
+        if (!os_atomic_load_bool(&writer_running) || os_gettime_ns() > deadline) {
+            return false;
+        }
+        os_event_signal(wake_event);
+        os_sleep_ms(1);
+    }
+
+    return true;
+}
+
+void marker_writer_begin_session(struct marker_session_info *info)
+{
+    struct marker_record record = {0};
+    record.type = MARKER_RECORD_SESSION_BEGIN;
+    record.data = info;
+
+    if (!push_control_record(&record)) {
+        blog(LOG_ERROR, "Timestamp Plugin: Could not queue session start for %s", info->path);
+        bfree(info);
+    }
+}
+
+void marker_writer_end_session(const char *video_path)
+{
+    struct marker_record record = {0};
+    record.type = MARKER_RECORD_SESSION_END;
+    record.data = video_path && *video_path ? bstrdup(video_path) : NULL;
+
+    if (!push_control_record(&record)) {
+        blog(LOG_ERROR, "Timestamp Plugin: Could not queue session end");
+        bfree(record.data);
+    }
+}
+
+void marker_writer_split_session(long generation, uint64_t timestamp_ns, const char *next_file)
+{
+    struct marker_record record = {0};
+    record.type = MARKER_RECORD_SESSION_SPLIT;
+    record.generation = generation;
+    record.timestamp_ns = timestamp_ns;
+    record.timestamp_ms = timestamp_ns / 1000000;
+    record.data = bstrdup(next_file ? next_file : "");
+
+    if (!push_control_record(&record)) {
+        blog(LOG_ERROR, "Timestamp Plugin: Could not queue file split at %" PRIu64 "ms", record.timestamp_ms);
+        bfree(record.data);
+    }
+}
+
+void marker_writer_pause_session(long generation, const struct recording_clock *clock)
+{
+    struct marker_record record = {0};
+    record.type = MARKER_RECORD_SESSION_PAUSE;
+    record.generation = generation;
+    record.data = bmemdup(clock, sizeof(*clock));
+
+    if (!push_control_record(&record)) {
+        blog(LOG_ERROR, "Timestamp Plugin: Could not queue recording %s", clock->pause_ns ? "pause" : "resume");
+        bfree(record.data);
+    }
+}
+
+void marker_writer_recover(const char *session_dir)
+{
+    struct marker_record record = {0};
+    record.type = MARKER_RECORD_SESSION_RECOVER;
+    record.data = bstrdup(session_dir);
+
+    if (!push_control_record(&record)) {
+        blog(LOG_ERROR, "Timestamp Plugin: Could not queue session recovery for %s", session_dir);
+        bfree(record.data);
+    }
+}
+
+// Wait until the writer has caught up with everything pushed so far
+void marker_writer_flush(void)
+{
+    if (!os_atomic_load_bool(&writer_running)) {
+        return;
+    }
+
+    unsigned long target = marker_queue_pushed(&queue);
+    uint64_t deadline = os_gettime_ns() + (uint64_t)WRITER_FLUSH_TIMEOUT_MS * 1000000ULL;
+
+    os_event_signal(wake_event);
+    while ((long)((unsigned long)os_atomic_load_long(&records_processed) - target) < 0) {
+        if (os_gettime_ns() > deadline) {
+            blog(LOG_WARNING, "Timestamp Plugin: Timed out waiting for marker writer");
+            return;
+        }
+        os_sleep_ms(1);
+    }
+}
+
+uint64_t marker_writer_dropped(void)
+{
+    if (!queue.slots) {
+        return 0;
+    }
+    return marker_queue_dropped(&queue);
+}
+
+// Public query API (timestamp-plugin.h), valid for the recording in progress
+
+size_t timestamp_marker_count(void)
+{
+    pthread_mutex_lock(&store_mutex);
+    size_t count = session_store ? marker_store_count(session_store) : 0;
+    pthread_mutex_unlock(&store_mutex);
+    return count;
+}
+
+bool timestamp_marker_get(size_t index, struct marker_record *marker)
+{
+    pthread_mutex_lock(&store_mutex);
+    bool found = session_store && marker_store_get(session_store, index, marker);
+    pthread_mutex_unlock(&store_mutex);
+    return found;
+}
+
+size_t timestamp_marker_range(uint64_t start_ms, uint64_t end_ms, size_t *first)
+{
+    size_t count = 0;
+
+    if (first) {
+        *first = 0;
+    }
+
+    pthread_mutex_lock(&store_mutex);
+    if (session_store) {
+        count = marker_store_range(session_store, start_ms * 1000000ULL, end_ms * 1000000ULL, first);
+    }
+    pthread_mutex_unlock(&store_mutex);
+    return count;
+}
+
+size_t timestamp_marker_copy(uint64_t start_ms, uint64_t end_ms, struct marker_record *markers, size_t max)
+{
+    size_t copied = 0;
+
+    pthread_mutex_lock(&store_mutex);
+    if (session_store) {
+        size_t first;
+        size_t count = marker_store_range(session_store, start_ms * 1000000ULL, end_ms * 1000000ULL, &first);
+        while (copied < count && copied < max && marker_store_get(session_store, first + copied, &markers[copied])) {
+            copied++;
+        }
+    }
+    pthread_mutex_unlock(&store_mutex);
+    return copied;
+}
+
+uint32_t timestamp_marker_segment(uint64_t *start_ms)
+{
+    pthread_mutex_lock(&store_mutex);
+    uint32_t segment = session_segment;
+    if (start_ms) {
+        *start_ms = session_segment_start_ns / 1000000;
+    }
+    pthread_mutex_unlock(&store_mutex);
+    return segment;
+}
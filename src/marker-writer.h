@@ -0,0 +1,102 @@
+#pragma once
+
+#include "marker-queue.h"
+#include "recording-clock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// When the writer pushes buffered markers out to the disk
+enum marker_flush_mode {
+    MARKER_FLUSH_COUNT,    // fflush after every N markers
+    MARKER_FLUSH_INTERVAL, // fflush at most every T milliseconds
+    MARKER_FLUSH_FSYNC,    // fflush + fsync after every marker
+};
+
+struct marker_flush_policy {
+    enum marker_flush_mode mode;
+    uint32_t every_markers;
+    uint32_t interval_ms;
+};
+
+// Which session log files the writer produces
+enum marker_log_format {
+    MARKER_LOG_JSONL,  // timestamps.jsonl only
+    MARKER_LOG_BINARY, // binary journal only (see marker-journal.h)
+    MARKER_LOG_BOTH,
+};
+
+// Everything the writer needs to open a session log and export it at stop.
+// Allocated with bzalloc by the caller and freed by the writer thread once
+// the session is closed.
+struct marker_session_info {
+    char path[512];
+    char recording_path[512];
+    char video_path[512]; // recording file: the output's path at start, the frontend's at stop
+    char start_time[64];
+    int64_t start_epoch;
+    uint32_t fps_num;
+    uint32_t fps_den;
+    uint32_t width;
+    uint32_t height;
+    struct marker_flush_policy flush;
+    enum marker_log_format log_format;
+    bool dump_jsonl; // binary format: recreate the JSONL log from the journal at stop
+    bool live_xml;   // keep the Premiere XML sidecar up to date while recording
+    bool chapters;   // write the markers into the finished recording as chapters
+    long generation; // markers tagged with another generation are rejected
+    struct recording_clock clock; // timeline of the recording, for markers the writer times itself
+    uint32_t coalesce_ms; // hotkey bursts are held this long for more presses (0 = off)
+    uint32_t scene_coalesce_ms; // a scene marker is held this long for the next switch (0 = off)
+    uint32_t repeat_ms;   // add a marker every repeat_ms of recording (0 = off)
+    char broadcast_address[64]; // send every marker to this UDP address too (empty = off)
+    uint32_t export_formats;    // formats written at stop, bits of enum marker_export_format (0 = Premiere only)
+    uint32_t segment;           // index of the file among the recording's file splits (0 = the first)
+    uint64_t segment_start_ns;  // where the file starts on the recording timeline; markers count from here
+    char previous_segment[512]; // session log of the file before (empty for the first)
+};
+
+// Background writer thread that drains the marker queue to disk
+bool marker_writer_start(void);
+void marker_writer_stop(void);
+
+// Enqueue a marker for the writer thread (safe to call from any thread)
+bool marker_writer_push(const struct marker_record *record);
+
+// Enqueue several markers in order with one claim on the queue and one
+// wake-up; returns how many fit (the rest count as dropped)
+size_t marker_writer_push_batch(const struct marker_record *records, size_t count);
+
+// Open a new session log; the writer keeps it open until the session ends.
+// video_path (optional) is the finished recording file, recorded in the
+// session metadata so tools don't have to search for it.
+void marker_writer_begin_session(struct marker_session_info *info);
+void marker_writer_end_session(const char *video_path);
+
+// The recording output split the recording and continues in next_file from
+// timestamp_ns on the recording timeline. The writer closes and exports the
+// log of the finished file as it would at stop, then opens a log for the next
+// one whose markers count from the split. A split tagged with another
+// generation than the open session's is ignored, like a stale marker.
+void marker_writer_split_session(long generation, uint64_t timestamp_ns, const char *next_file);
+
+// The recording was paused or resumed; clock is the session's clock with the
+// change applied, which the writer's timers follow from then on. Ignored for
+// another generation than the open session's.
+void marker_writer_pause_session(long generation, const struct recording_clock *clock);
+
+// Recover the session the last run left unfinished in session_dir (OBS
+// crashed while recording), if any, and export it in the background. The
+// writer does it before anything queued after this call.
+void marker_writer_recover(const char *session_dir);
+
+// Block until every marker queued so far has been written
+void marker_writer_flush(void);
+
+// Markers lost because the queue was full
+uint64_t marker_writer_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
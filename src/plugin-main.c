@@ -1,4 +1,5 @@
 #include "timestamp-plugin.h"
+#include "marker-api.h"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE("obs-timestamp-plugin", "en-US")
@@ -31,6 +32,9 @@ void obs_module_post_load(void)
 {
     blog(LOG_INFO, "OBS Timestamp Plugin post_load called");
     load_hotkey_data();
+
+    // obs-websocket registers its vendor API at load, so only now can it be found
+    marker_api_register_vendor();
 }
 
 // This function is called by OBS before saving settings
@@ -0,0 +1,470 @@
+#include "premiere-export.h"
+#include "timestamp-plugin.h"
+#include <util/dstr.h>
+#include <util/util_uint64.h>
+#include <time.h>
+
+// Port of create_premiere_xml from data/timestamp_to_premiere.py, driven
+// directly by the markers the writer collected during the session.
+
+// Premiere Pro color codes (32-bit ARGB values)
+static const struct {
+    const char *name;
+    const char *code;
+} color_map[] = {
+    {"blue", "4294741314"},
+    {"cyan", "4294940928"},
+    {"green", "4278255360"},
+    {"yellow", "4278255615"},
+    {"red", "4294901760"},
+    {"magenta", "4294902015"},
+    {"purple", "4286578816"},
+    {"orange", "4294924800"},
+};
+
+// Get Premiere Pro color code from color name
+static const char *get_color_code(const char *color)
+{
+    for (size_t i = 0; i < sizeof(color_map) / sizeof(color_map[0]); i++) {
+        if (astrcmpi(color, color_map[i].name) == 0) {
+            return color_map[i].code;
+        }
+    }
+    return color_map[0].code;
+}
+
+// Convert milliseconds to frame number (floor, like int() in the converter)
+static uint64_t ms_to_frames(uint64_t milliseconds, uint32_t fps_num, uint32_t fps_den)
+{
+    return util_mul_div64(milliseconds, fps_num, (uint64_t)fps_den * 1000);
+}
+
+static void xml_indent(FILE *file, int depth)
+{
+    for (int i = 0; i < depth; i++) {
+        fputs("  ", file);
+    }
+}
+
+// Escape text the same way minidom does
+static void xml_escaped(FILE *file, const char *text)
+{
+    for (const char *p = text; *p; p++) {
+        switch (*p) {
+        case '&':
+            fputs("&amp;", file);
+            break;
+        case '<':
+            fputs("&lt;", file);
+            break;
+        case '>':
+            fputs("&gt;", file);
+            break;
+        case '"':
+            fputs("&quot;", file);
+            break;
+        default:
+            fputc(*p, file);
+            break;
+        }
+    }
+}
+
+static void xml_open(FILE *file, int depth, const char *tag)
+{
+    xml_indent(file, depth);
+    fprintf(file, "<%s>\n", tag);
+}
+
+static void xml_close(FILE *file, int depth, const char *tag)
+{
+    xml_indent(file, depth);
+    fprintf(file, "</%s>\n", tag);
+}
+
+// Text-only element; empty text collapses to <tag/> like toprettyxml
+static void xml_text(FILE *file, int depth, const char *tag, const char *text)
+{
+    xml_indent(file, depth);
+    if (!text || !*text) {
+        fprintf(file, "<%s/>\n", tag);
+        return;
+    }
+    fprintf(file, "<%s>", tag);
+    xml_escaped(file, text);
+    fprintf(file, "</%s>\n", tag);
+}
+
+static void xml_uint(FILE *file, int depth, const char *tag, uint64_t value)
+{
+    xml_indent(file, depth);
+    fprintf(file, "<%s>%" PRIu64 "</%s>\n", tag, value, tag);
+}
+
+static void write_rate(FILE *file, int depth, uint32_t timebase, bool ntsc)
+{
+    xml_open(file, depth, "rate");
+    xml_uint(file, depth + 1, "timebase", timebase);
+    xml_text(file, depth + 1, "ntsc", ntsc ? "TRUE" : "FALSE");
+    xml_close(file, depth, "rate");
+}
+
+static void write_marker(FILE *file, int depth, const char *comment, const char *name, uint64_t frame,
+                         const char *color)
+{
+    xml_open(file, depth, "marker");
+    xml_text(file, depth + 1, "comment", comment);
+    xml_text(file, depth + 1, "name", name);
+    xml_uint(file, depth + 1, "in", frame);
+    xml_text(file, depth + 1, "out", "-1");
+    xml_text(file, depth + 1, "pproColor", get_color_code(color));
+    xml_close(file, depth, "marker");
+}
+
+static void write_markers(FILE *file, int depth, const struct stored_marker *markers, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        const struct stored_marker *marker = &markers[i];
+        write_marker(file, depth, marker->comment, marker->name, marker->frame, marker_color_name(marker->color));
+    }
+}
+
+// Width of the zero-padded duration fields of a live sidecar, enough for
+// years of recording at any frame rate
+#define LIVE_DURATION_DIGITS 12
+
+// sequence and generator item duration, generator item end and out
+#define DURATION_FIELDS 4
+
+// Everything the document sections need besides the markers
+struct xml_document {
+    FILE *file;
+    uint32_t fps_num;
+    uint32_t fps_den;
+    uint32_t timebase;
+    bool ntsc;
+    uint32_t width;
+    uint32_t height;
+    char sequence_name[128];
+    uint64_t duration;
+
+    // Live sidecar: duration fields are fixed-width so they can be patched
+    bool live;
+    int duration_fields;
+    int64_t duration_offsets[DURATION_FIELDS];
+};
+
+static void init_document(struct xml_document *doc, FILE *file, const struct marker_session_info *info)
+{
+    memset(doc, 0, sizeof(*doc));
+    doc->file = file;
+    doc->fps_num = info->fps_num ? info->fps_num : 60;
+    doc->fps_den = info->fps_den ? info->fps_den : 1;
+
+    // NTSC rates are expressed as the rounded-up integer timebase
+    doc->ntsc = doc->fps_den == 1001;
+    doc->timebase = doc->ntsc ? (doc->fps_num + doc->fps_den - 1) / doc->fps_den : doc->fps_num / doc->fps_den;
+
+    // Default sequence name; runs on a job thread, so no shared localtime buffer
+    time_t now = time(NULL);
+    struct tm tm_info;
+#ifdef _WIN32
+    localtime_s(&tm_info, &now);
+#else
+    localtime_r(&now, &tm_info);
+#endif
+    char time_str[32];
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M", &tm_info);
+    snprintf(doc->sequence_name, sizeof(doc->sequence_name), "OBS Markers (%s)", time_str);
+
+    doc->width = info->width ? info->width : 1920;
+    doc->height = info->height ? info->height : 1080;
+}
+
+// Sequence length for markers up to max_frame (last marker + 60 seconds buffer)
+static uint64_t document_duration(const struct xml_document *doc, uint64_t max_frame)
+{
+    return max_frame + ms_to_frames(60000, doc->fps_num, doc->fps_den);
+}
+
+static void xml_duration(struct xml_document *doc, int depth, const char *tag)
+{
+    if (!doc->live) {
+        xml_uint(doc->file, depth, tag, doc->duration);
+        return;
+    }
+
+    xml_indent(doc->file, depth);
+    fprintf(doc->file, "<%s>", tag);
+    doc->duration_offsets[doc->duration_fields++] = os_ftelli64(doc->file);
+    fprintf(doc->file, "%0*" PRIu64 "</%s>\n", LIVE_DURATION_DIGITS, doc->duration, tag);
+}
+
+// Everything up to the markers of the generator item
+static void write_document_head(struct xml_document *doc)
+{
+    FILE *file = doc->file;
+
+    fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", file);
+    fputs("<!DOCTYPE xmeml>\n", file);
+    fputs("<xmeml version=\"4\">\n", file);
+    fputs("  <sequence id=\"sequence\" explodedTracks=\"true\">\n", file);
+
+    xml_text(file, 2, "uuid", "obs-timestamp-markers-sequence");
+    xml_duration(doc, 2, "duration");
+    write_rate(file, 2, doc->timebase, doc->ntsc);
+    xml_text(file, 2, "name", doc->sequence_name);
+
+    // Media section
+    xml_open(file, 2, "media");
+    xml_open(file, 3, "video");
+    xml_open(file, 4, "format");
+    xml_open(file, 5, "samplecharacteristics");
+    write_rate(file, 6, doc->timebase, doc->ntsc);
+    xml_open(file, 6, "codec");
+    xml_text(file, 7, "name", "Apple ProRes 422");
+    xml_close(file, 6, "codec");
+    xml_uint(file, 6, "width", doc->width);
+    xml_uint(file, 6, "height", doc->height);
+    xml_text(file, 6, "anamorphic", "FALSE");
+    xml_text(file, 6, "pixelaspectratio", "square");
+    xml_text(file, 6, "fielddominance", "none");
+    xml_text(file, 6, "colordepth", "24");
+    xml_close(file, 5, "samplecharacteristics");
+    xml_close(file, 4, "format");
+
+    // Video track with the generator item (invisible color matte that holds the markers)
+    xml_open(file, 4, "track");
+    xml_text(file, 5, "enabled", "TRUE");
+    xml_text(file, 5, "locked", "FALSE");
+    xml_indent(file, 5);
+    fputs("<generatoritem id=\"clipitem-1\">\n", file);
+    xml_text(file, 6, "name", "OBS Marker Holder");
+    xml_text(file, 6, "enabled", "TRUE");
+    xml_duration(doc, 6, "duration");
+    write_rate(file, 6, doc->timebase, doc->ntsc);
+    xml_text(file, 6, "start", "0");
+    xml_duration(doc, 6, "end");
+    xml_text(file, 6, "in", "0");
+    xml_duration(doc, 6, "out");
+    xml_text(file, 6, "alphatype", "none");
+
+    // Color matte effect
+    xml_open(file, 6, "effect");
+    xml_text(file, 7, "name", "Color");
+    xml_text(file, 7, "effectid", "Color");
+    xml_text(file, 7, "effectcategory", "Matte");
+    xml_text(file, 7, "effecttype", "generator");
+    xml_text(file, 7, "mediatype", "video");
+    xml_indent(file, 7);
+    fputs("<parameter authoringApp=\"PremierePro\">\n", file);
+    xml_text(file, 8, "parameterid", "fillcolor");
+    xml_text(file, 8, "name", "Color");
+    xml_open(file, 8, "value");
+    xml_text(file, 9, "alpha", "0");
+    xml_text(file, 9, "red", "0");
+    xml_text(file, 9, "green", "0");
+    xml_text(file, 9, "blue", "0");
+    xml_close(file, 8, "value");
+    xml_close(file, 7, "parameter");
+    xml_close(file, 6, "effect");
+
+    // Opacity filter to make it invisible
+    xml_open(file, 6, "filter");
+    xml_open(file, 7, "effect");
+    xml_text(file, 8, "name", "Opacity");
+    xml_text(file, 8, "effectid", "opacity");
+    xml_text(file, 8, "effectcategory", "motion");
+    xml_text(file, 8, "effecttype", "motion");
+    xml_text(file, 8, "mediatype", "video");
+    xml_indent(file, 8);
+    fputs("<parameter authoringApp=\"PremierePro\">\n", file);
+    xml_text(file, 9, "parameterid", "opacity");
+    xml_text(file, 9, "name", "opacity");
+    xml_text(file, 9, "value", "0");
+    xml_close(file, 8, "parameter");
+    xml_close(file, 7, "effect");
+    xml_close(file, 6, "filter");
+}
+
+// From the end of the generator item to the sequence-level markers
+static void write_document_middle(struct xml_document *doc)
+{
+    FILE *file = doc->file;
+
+    xml_close(file, 5, "generatoritem");
+    xml_close(file, 4, "track");
+    xml_close(file, 3, "video");
+
+    // Audio section
+    xml_open(file, 3, "audio");
+    xml_text(file, 4, "numOutputChannels", "2");
+    xml_open(file, 4, "format");
+    xml_open(file, 5, "samplecharacteristics");
+    xml_text(file, 6, "depth", "16");
+    xml_text(file, 6, "samplerate", "48000");
+    xml_close(file, 5, "samplecharacteristics");
+    xml_close(file, 4, "format");
+    for (int i = 0; i < 2; i++) {
+        xml_open(file, 4, "track");
+        xml_text(file, 5, "enabled", "TRUE");
+        xml_text(file, 5, "locked", "FALSE");
+        xml_uint(file, 5, "outputchannelindex", (uint64_t)i + 1);
+        xml_close(file, 4, "track");
+    }
+    xml_close(file, 3, "audio");
+    xml_close(file, 2, "media");
+
+    // Timecode
+    xml_open(file, 2, "timecode");
+    write_rate(file, 3, doc->timebase, doc->ntsc);
+    xml_text(file, 3, "string", "00:00:00:00");
+    xml_text(file, 3, "frame", "0");
+    xml_text(file, 3, "displayformat", "NDF");
+    xml_close(file, 2, "timecode");
+}
+
+#define DOCUMENT_TAIL "  </sequence>\n</xmeml>\n"
+
+// Check the stream and close it; false if anything failed to write
+static bool close_document(FILE *file, const char *path)
+{
+    bool ok = ferror(file) == 0;
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+
+    if (!ok) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to write XML file: %s", path);
+    }
+    return ok;
+}
+
+// Exporter state for the document written at stop
+struct premiere_export {
+    struct xml_document doc;
+    const struct marker_store *store;
+};
+
+static void *premiere_begin(FILE *file, const struct marker_session_info *info, const struct marker_store *store)
+{
+    struct premiere_export *export = bzalloc(sizeof(*export));
+    export->store = store;
+    init_document(&export->doc, file, info);
+
+    uint64_t max_frame = 0;
+    for (size_t i = 0; i < store->markers.num; i++) {
+        if (store->markers.array[i].frame > max_frame) {
+            max_frame = store->markers.array[i].frame;
+        }
+    }
+    export->doc.duration = document_duration(&export->doc, max_frame);
+
+    write_document_head(&export->doc);
+    return export;
+}
+
+// Markers on the generator item, as the pass goes
+static void premiere_marker(void *data, const struct stored_marker *marker)
+{
+    struct premiere_export *export = data;
+    write_marker(export->doc.file, 6, marker->comment, marker->name, marker->frame, marker_color_name(marker->color));
+}
+
+static bool premiere_end(void *data)
+{
+    struct premiere_export *export = data;
+
+    write_document_middle(&export->doc);
+
+    // Markers at sequence level too (for better compatibility); the document
+    // needs them a second time after the media section
+    write_markers(export->doc.file, 2, export->store->markers.array, export->store->markers.num);
+
+    fputs(DOCUMENT_TAIL, export->doc.file);
+    bfree(export);
+    return true;
+}
+
+const struct marker_exporter premiere_exporter = {
+    .name = "premiere",
+    .suffix = "_markers.xml",
+    .begin = premiere_begin,
+    .marker = premiere_marker,
+    .end = premiere_end,
+};
+
+// Live sidecar: the same document with the markers at sequence level only,
+// since that is the one place they can be appended without moving anything.
+// Markers overwrite the tail, which is written again after them.
+struct premiere_live_export {
+    struct xml_document doc;
+    char path[1024];
+    int64_t tail_offset;
+    uint64_t markers;
+};
+
+struct premiere_live_export *premiere_live_open(const char *path, const struct marker_session_info *info)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to create live XML file: %s", path);
+        return NULL;
+    }
+
+    struct premiere_live_export *live = bzalloc(sizeof(*live));
+    snprintf(live->path, sizeof(live->path), "%s", path);
+
+    init_document(&live->doc, file, info);
+    live->doc.live = true;
+    live->doc.duration = document_duration(&live->doc, 0);
+
+    write_document_head(&live->doc);
+    write_document_middle(&live->doc);
+    live->tail_offset = os_ftelli64(file);
+    fputs(DOCUMENT_TAIL, file);
+    fflush(file);
+
+    blog(LOG_INFO, "Timestamp Plugin: Live XML sidecar: %s", path);
+    return live;
+}
+
+bool premiere_live_add(struct premiere_live_export *live, const struct marker_record *record)
+{
+    FILE *file = live->doc.file;
+
+    // Marker and tail in one go: the document is complete again afterwards
+    os_fseeki64(file, live->tail_offset, SEEK_SET);
+    write_marker(file, 2, record->comment, record->name, record->frame, record->color[0] ? record->color : "blue");
+    live->tail_offset = os_ftelli64(file);
+    fputs(DOCUMENT_TAIL, file);
+    live->markers++;
+
+    // Stretch the sequence when a marker lands past its end; same-width
+    // digits, so nothing moves
+    uint64_t duration = document_duration(&live->doc, record->frame);
+    if (duration > live->doc.duration) {
+        live->doc.duration = duration;
+        for (int i = 0; i < live->doc.duration_fields; i++) {
+            os_fseeki64(file, live->doc.duration_offsets[i], SEEK_SET);
+            fprintf(file, "%0*" PRIu64, LIVE_DURATION_DIGITS, duration);
+        }
+    }
+
+    return ferror(file) == 0;
+}
+
+void premiere_live_flush(struct premiere_live_export *live)
+{
+    fflush(live->doc.file);
+}
+
+void premiere_live_close(struct premiere_live_export *live)
+{
+    if (!live) {
+        return;
+    }
+
+    close_document(live->doc.file, live->path);
+    bfree(live);
+}
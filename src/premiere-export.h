@@ -0,0 +1,27 @@
+#pragma once
+
+#include "marker-export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Premiere Pro xmeml v4 documents. At stop they are written by
+// premiere_exporter (see marker-export.h), at the path the Python converter
+// would pick: next to the matching video file when one can be found,
+// otherwise next to the log.
+
+// Live sidecar kept up to date while recording. Each marker costs one marker
+// element plus the fixed document tail (and a few fixed-width digits when the
+// sequence grows), and the file is valid XML after every flush. Only the
+// writer thread uses it.
+struct premiere_live_export;
+
+struct premiere_live_export *premiere_live_open(const char *path, const struct marker_session_info *info);
+bool premiere_live_add(struct premiere_live_export *live, const struct marker_record *record);
+void premiere_live_flush(struct premiere_live_export *live);
+void premiere_live_close(struct premiere_live_export *live);
+
+#ifdef __cplusplus
+}
+#endif
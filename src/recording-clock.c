@@ -0,0 +1,123 @@
+#include "recording-clock.h"
+#include <obs-frontend-api.h>
+#include <util/platform.h>
+#include <util/util_uint64.h>
+#include <inttypes.h>
+
+void recording_clock_start(struct recording_clock *clock, uint32_t fps_num, uint32_t fps_den)
+{
+    clock->pause_ns = 0;
+    clock->paused_ns = 0;
+    clock->fps_num = fps_num ? fps_num : 60;
+    clock->fps_den = fps_den ? fps_den : 1;
+
+    // The running video output is the real cadence, whatever the profile says
+    video_t *video = obs_get_video();
+    const struct video_output_info *voi = video ? video_output_get_info(video) : NULL;
+    if (voi && voi->fps_num && voi->fps_den) {
+        clock->fps_num = voi->fps_num;
+        clock->fps_den = voi->fps_den;
+    }
+
+    // The last rendered frame is total_frames frames after the first one the
+    // output received, which puts the origin exactly on a frame boundary
+    uint64_t last_frame_ns = obs_get_video_frame_time();
+    uint64_t total_frames = 0;
+
+    obs_output_t *output = obs_frontend_get_recording_output();
+    if (output) {
+        int frames = obs_output_get_total_frames(output);
+        if (frames > 0) {
+            total_frames = (uint64_t)frames;
+        }
+        obs_output_release(output);
+    }
+
+    if (!last_frame_ns) {
+        last_frame_ns = os_gettime_ns();
+    }
+
+    uint64_t recorded_ns = util_mul_div64(total_frames, 1000000000ULL * clock->fps_den, clock->fps_num);
+    clock->first_frame_ns = recorded_ns < last_frame_ns ? last_frame_ns - recorded_ns : 0;
+
+    blog(LOG_INFO, "Timestamp Plugin: Recording clock at %u/%u fps, %" PRIu64 " frame(s) already recorded",
+         clock->fps_num, clock->fps_den, total_frames);
+}
+
+void recording_clock_pause(struct recording_clock *clock, uint64_t now_ns)
+{
+    if (!clock->pause_ns) {
+        clock->pause_ns = now_ns ? now_ns : 1;
+    }
+}
+
+void recording_clock_resume(struct recording_clock *clock, uint64_t now_ns)
+{
+    if (!clock->pause_ns) {
+        return;
+    }
+
+    uint64_t paused = now_ns > clock->pause_ns ? now_ns - clock->pause_ns : 0;
+
+    // libobs times the pause to the frame; the events come a little after
+    obs_output_t *output = obs_frontend_get_recording_output();
+    if (output) {
+        uint64_t offset_ns = obs_output_get_pause_offset(output);
+        if (offset_ns > clock->paused_ns) {
+            paused = offset_ns - clock->paused_ns;
+        }
+        obs_output_release(output);
+    }
+    clock->first_frame_ns += paused;
+    clock->paused_ns += paused;
+    clock->pause_ns = 0;
+}
+
+bool recording_clock_paused(const struct recording_clock *clock)
+{
+    return clock->pause_ns != 0;
+}
+
+uint64_t recording_clock_elapsed_ns(const struct recording_clock *clock, uint64_t now_ns)
+{
+    if (clock->pause_ns && now_ns > clock->pause_ns) {
+        now_ns = clock->pause_ns;
+    }
+    return now_ns > clock->first_frame_ns ? now_ns - clock->first_frame_ns : 0;
+}
+
+uint64_t recording_clock_frame(const struct recording_clock *clock, uint64_t elapsed_ns)
+{
+    return util_mul_div64(elapsed_ns, clock->fps_num, 1000000000ULL * clock->fps_den);
+}
+
+uint64_t recording_clock_frame_ns(const struct recording_clock *clock, uint64_t frame)
+{
+    uint64_t ns = util_mul_div64(frame, 1000000000ULL * clock->fps_den, clock->fps_num);
+
+    // Rounded down, the time may still fall in the frame before
+    return recording_clock_frame(clock, ns) < frame ? ns + 1 : ns;
+}
+
+bool recording_clock_measure(const struct recording_clock *clock, uint64_t *elapsed_ns, int64_t *drift_ns)
+{
+    obs_output_t *output = obs_frontend_get_recording_output();
+    if (!output) {
+        return false;
+    }
+
+    // Read together, as in recording_clock_start, so a drift of 0 means the
+    // file is exactly as long as the time that passed
+    uint64_t last_frame_ns = obs_get_video_frame_time();
+    int frames = obs_output_active(output) ? obs_output_get_total_frames(output) : -1;
+    obs_output_release(output);
+
+    if (frames < 0 || !last_frame_ns) {
+        return false;
+    }
+
+    *elapsed_ns = recording_clock_elapsed_ns(clock, last_frame_ns);
+    uint64_t recorded_ns = util_mul_div64((uint64_t)frames, 1000000000ULL * clock->fps_den, clock->fps_num);
+    *drift_ns = (int64_t)*elapsed_ns - (int64_t)recorded_ns;
+    return true;
+}
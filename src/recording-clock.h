@@ -0,0 +1,52 @@
+#pragma once
+
+#include <obs-module.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maps os_gettime_ns() onto the recording's video timeline. The origin is the
+// pipeline time of the first frame the recording output received, and frame
+// indices come from the video output's exact fps_num/fps_den cadence.
+//
+// A pause stops the timeline: while paused every time maps to where the pause
+// began, and resuming moves the origin on by the time spent paused, so a
+// mapping is always a single subtraction however many pauses came before.
+struct recording_clock {
+    uint64_t first_frame_ns; // moved on by every pause so far
+    uint64_t pause_ns;       // os_gettime_ns() the running pause began at, 0 if none
+    uint64_t paused_ns;      // total time spent paused
+    uint32_t fps_num;
+    uint32_t fps_den;
+};
+
+// Anchor the clock to the current recording output. fps_num/fps_den are used
+// only when libobs has no running video output to take the cadence from.
+void recording_clock_start(struct recording_clock *clock, uint32_t fps_num, uint32_t fps_den);
+
+// Stop the timeline at now_ns, or continue it from there. The time paused is
+// the recording output's own pause offset when libobs has one, else the time
+// since the pause. Repeated calls for the same state are ignored.
+void recording_clock_pause(struct recording_clock *clock, uint64_t now_ns);
+void recording_clock_resume(struct recording_clock *clock, uint64_t now_ns);
+
+bool recording_clock_paused(const struct recording_clock *clock);
+
+// Nanoseconds of recording since the first recorded frame (0 before it)
+uint64_t recording_clock_elapsed_ns(const struct recording_clock *clock, uint64_t now_ns);
+
+// Index of the frame being recorded elapsed_ns into the recording
+uint64_t recording_clock_frame(const struct recording_clock *clock, uint64_t elapsed_ns);
+
+// Where frame `frame` starts on the timeline, the inverse of recording_clock_frame
+uint64_t recording_clock_frame_ns(const struct recording_clock *clock, uint64_t frame);
+
+// Compare the clock with the media actually recorded: *elapsed_ns is the
+// time of the last rendered frame and *drift_ns how far the frames the
+// recording output has taken fall behind it. False while no output records.
+bool recording_clock_measure(const struct recording_clock *clock, uint64_t *elapsed_ns, int64_t *drift_ns);
+
+#ifdef __cplusplus
+}
+#endif
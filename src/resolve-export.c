@@ -0,0 +1,77 @@
+#include "marker-export.h"
+#include "timestamp-plugin.h"
+
+// DaVinci Resolve marker list, one CSV row per marker:
+//
+//   #,Name,Record In,Record Out,Duration,Color,Notes
+//   1,Marker 1,00:00:15:00,00:00:15:01,00:00:00:01,Blue,
+//
+// Timecodes start at 00:00:00:00, like the Premiere sequence. Fields are
+// quoted as RFC 4180 asks when they hold a comma, a quote or a line break.
+
+struct resolve_csv_export {
+    FILE *file;
+    uint32_t timebase;
+    size_t rows;
+};
+
+static void write_csv_field(FILE *file, const char *text)
+{
+    if (!strpbrk(text, ",\"\r\n")) {
+        fputs(text, file);
+        return;
+    }
+
+    fputc('"', file);
+    for (const char *c = text; *c; c++) {
+        if (*c == '"') {
+            fputc('"', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+static void *resolve_csv_begin(FILE *file, const struct marker_session_info *info, const struct marker_store *store)
+{
+    UNUSED_PARAMETER(store);
+
+    struct resolve_csv_export *export = bzalloc(sizeof(*export));
+    export->file = file;
+    export->timebase = marker_export_timebase(info);
+
+    fputs("#,Name,Record In,Record Out,Duration,Color,Notes\n", file);
+    return export;
+}
+
+static void resolve_csv_marker(void *data, const struct stored_marker *marker)
+{
+    struct resolve_csv_export *export = data;
+
+    char in[32], out[32], duration[32];
+    marker_export_timecode(marker->frame, export->timebase, in, sizeof(in));
+    marker_export_timecode(marker->frame + 1, export->timebase, out, sizeof(out));
+    marker_export_timecode(1, export->timebase, duration, sizeof(duration));
+
+    fprintf(export->file, "%zu,", ++export->rows);
+    write_csv_field(export->file, marker_export_title(marker));
+    fprintf(export->file, ",%s,%s,%s,%s,", in, out, duration, marker_export_resolve_color(marker->color));
+
+    // The comment goes into the notes when the name took the title
+    write_csv_field(export->file, marker->name[0] ? marker->comment : "");
+    fputc('\n', export->file);
+}
+
+static bool resolve_csv_end(void *data)
+{
+    bfree(data);
+    return true;
+}
+
+const struct marker_exporter resolve_csv_exporter = {
+    .name = "resolve",
+    .suffix = "_markers.csv",
+    .begin = resolve_csv_begin,
+    .marker = resolve_csv_marker,
+    .end = resolve_csv_end,
+};
@@ -0,0 +1,101 @@
+#include "session-index.h"
+#include "session-log.h"
+#include <util/platform.h>
+#include <stdio.h>
+
+void session_index_init(struct session_index *index)
+{
+    da_init(index->blocks);
+    index->markers = 0;
+}
+
+void session_index_free(struct session_index *index)
+{
+    da_free(index->blocks);
+    index->markers = 0;
+}
+
+bool session_index_path(const char *log_path, char *buffer, size_t size)
+{
+    return session_log_sibling_path(log_path, SESSION_INDEX_EXTENSION, buffer, size);
+}
+
+void session_index_add(struct session_index *index, uint64_t offset, uint64_t length, uint64_t timestamp_ms)
+{
+    struct session_index_block *block = da_end(index->blocks);
+
+    if (!block || block->markers >= SESSION_INDEX_BLOCK_MARKERS || block->offset + block->length != offset ||
+        (timestamp_ms > block->opened_ms && timestamp_ms - block->opened_ms >= SESSION_INDEX_BLOCK_MS)) {
+        block = da_push_back_new(index->blocks);
+        block->offset = offset;
+        block->first_ms = timestamp_ms;
+        block->last_ms = timestamp_ms;
+        block->opened_ms = timestamp_ms;
+    }
+
+    block->length = offset + length - block->offset;
+    block->markers++;
+    if (timestamp_ms < block->first_ms) {
+        block->first_ms = timestamp_ms;
+    }
+    if (timestamp_ms > block->last_ms) {
+        block->last_ms = timestamp_ms;
+    }
+    index->markers++;
+}
+
+bool session_index_write(const struct session_index *index, const char *log_path)
+{
+    char path[512], temp_path[520];
+    if (!session_index_path(log_path, path, sizeof(path))) {
+        blog(LOG_WARNING, "Timestamp Plugin: Session index path too long for %s", log_path);
+        return false;
+    }
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    FILE *file = os_fopen(temp_path, "wb");
+    if (!file) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to create session index: %s", path);
+        return false;
+    }
+
+    const char *name = session_log_file_name(log_path);
+
+    char line[SESSION_LOG_LINE_SIZE];
+    int length = session_log_put_raw(line, sizeof(line), 0, "{\"metadata\": {\"log\": ");
+    length = session_log_put_string(line, sizeof(line), length, name);
+    length = session_log_put_raw(line, sizeof(line), length, ", \"blocks\": ");
+    length = session_log_put_uint(line, sizeof(line), length, index->blocks.num);
+    length = session_log_put_raw(line, sizeof(line), length, ", \"markers\": ");
+    length = session_log_put_uint(line, sizeof(line), length, index->markers);
+    length = session_log_put_raw(line, sizeof(line), length, "}");
+    bool ok = session_log_write_line(file, line, length);
+
+    for (size_t i = 0; ok && i < index->blocks.num; i++) {
+        const struct session_index_block *block = &index->blocks.array[i];
+
+        length = session_log_put_raw(line, sizeof(line), 0, "{\"offset\": ");
+        length = session_log_put_uint(line, sizeof(line), length, block->offset);
+        length = session_log_put_raw(line, sizeof(line), length, ", \"length\": ");
+        length = session_log_put_uint(line, sizeof(line), length, block->length);
+        length = session_log_put_raw(line, sizeof(line), length, ", \"markers\": ");
+        length = session_log_put_uint(line, sizeof(line), length, block->markers);
+        length = session_log_put_raw(line, sizeof(line), length, ", \"first_ms\": ");
+        length = session_log_put_uint(line, sizeof(line), length, block->first_ms);
+        length = session_log_put_raw(line, sizeof(line), length, ", \"last_ms\": ");
+        length = session_log_put_uint(line, sizeof(line), length, block->last_ms);
+        ok = session_log_write_line(file, line, length);
+    }
+
+    ok = ferror(file) == 0 && ok;
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+
+    if (!ok || os_rename(temp_path, path) != 0) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to write session index: %s", path);
+        os_unlink(temp_path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <obs-module.h>
+#include <util/darray.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sparse time-to-offset index of a JSONL session log, kept next to it as
+// "<session>.tsidx". The marker lines are cut into blocks of consecutive
+// lines, each no longer than SESSION_INDEX_BLOCK_MARKERS lines or
+// SESSION_INDEX_BLOCK_MS of recording, and the index holds one line per block:
+//
+//   {"metadata": {"log": "2024-05-01 20-15-00.jsonl", "blocks": 3, "markers": 514}, "crc": ...}
+//   {"offset": 171, "length": 24610, "markers": 256, "first_ms": 0, "last_ms": 287211, "crc": ...}
+//
+// first_ms/last_ms are the smallest and largest timestamp in the block, so a
+// reader looking for a time range reads only the blocks that overlap it,
+// even where markers were written slightly out of time order (an audio block
+// that arrived late). Lines are sealed like session log lines
+// (see session-log.h). The converter's --start-ms/--end-ms read a log
+// through it.
+
+#define SESSION_INDEX_EXTENSION ".tsidx"
+#define SESSION_INDEX_BLOCK_MARKERS 256
+#define SESSION_INDEX_BLOCK_MS (5 * 60 * 1000)
+
+struct session_index_block {
+    uint64_t offset; // first byte of the block's first line in the log
+    uint64_t length; // bytes up to the end of its last line
+    uint32_t markers;
+    uint64_t first_ms;
+    uint64_t last_ms;
+    uint64_t opened_ms; // timestamp of its first line, for the time limit (not saved)
+};
+
+struct session_index {
+    DARRAY(struct session_index_block) blocks;
+    uint64_t markers;
+};
+
+void session_index_init(struct session_index *index);
+void session_index_free(struct session_index *index);
+
+// Account for a marker line of length bytes written at offset. Starts a new
+// block when the last one is full or the line doesn't follow it directly.
+void session_index_add(struct session_index *index, uint64_t offset, uint64_t length, uint64_t timestamp_ms);
+
+// Write the index for the log at log_path to its sibling .tsidx file (through
+// a temporary file, so readers never see half an index)
+bool session_index_write(const struct session_index *index, const char *log_path);
+
+// The .tsidx path that goes with a session log; false if it doesn't fit
+bool session_index_path(const char *log_path, char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,511 @@
+#include "session-log.h"
+#include <util/threading.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SESSION_LOG_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SESSION_LOG_NEON
+#endif
+
+#define CRC_FIELD ", \"crc\": \""
+
+// Reflected IEEE polynomial, the one zlib uses. Table k advances the CRC
+// over a byte followed by k zero bytes, so eight bytes go in per step
+// (slicing-by-8) instead of one.
+static uint32_t crc_table[8][256];
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+static void init_crc_table(void)
+{
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[0][n] = c;
+    }
+
+    for (uint32_t n = 0; n < 256; n++) {
+        for (int k = 1; k < 8; k++) {
+            crc_table[k][n] = crc_table[0][crc_table[k - 1][n] & 0xFF] ^ (crc_table[k - 1][n] >> 8);
+        }
+    }
+}
+
+uint32_t session_log_crc32(uint32_t crc, const void *data, size_t size)
+{
+    pthread_once(&crc_table_once, init_crc_table);
+
+    const uint8_t *bytes = data;
+    crc = ~crc;
+
+    for (; size >= 8; size -= 8, bytes += 8) {
+        uint32_t low = crc ^ ((uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 |
+                              (uint32_t)bytes[3] << 24);
+        crc = crc_table[7][low & 0xFF] ^ crc_table[6][(low >> 8) & 0xFF] ^ crc_table[5][(low >> 16) & 0xFF] ^
+              crc_table[4][low >> 24] ^ crc_table[3][bytes[4]] ^ crc_table[2][bytes[5]] ^ crc_table[1][bytes[6]] ^
+              crc_table[0][bytes[7]];
+    }
+
+    while (size--) {
+        crc = crc_table[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+int session_log_seal(char *buffer, size_t size, int length)
+{
+    if (length < 0 || (size_t)length + sizeof(CRC_FIELD) + 12 > size) {
+        return -1;
+    }
+
+    uint32_t crc = session_log_crc32(0, buffer, (size_t)length);
+    char *out = buffer + length;
+    memcpy(out, CRC_FIELD, sizeof(CRC_FIELD) - 1);
+    out += sizeof(CRC_FIELD) - 1;
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        *out++ = "0123456789abcdef"[(crc >> shift) & 0xF];
+    }
+    memcpy(out, "\"}\n", 4); // NUL included
+    return (int)(out + 3 - buffer);
+}
+
+bool session_log_write_line(FILE *file, char *line, int length)
+{
+    length = session_log_seal(line, SESSION_LOG_LINE_SIZE, length);
+    return length > 0 && fwrite(line, 1, (size_t)length, file) == (size_t)length;
+}
+
+const char *session_log_file_name(const char *path)
+{
+    const char *name = path;
+    for (const char *c = path; *c; c++) {
+        if (*c == '/' || *c == '\\') {
+            name = c + 1;
+        }
+    }
+    return name;
+}
+
+size_t session_log_stem_length(const char *path)
+{
+    const char *dot = strrchr(session_log_file_name(path), '.');
+    return dot ? (size_t)(dot - path) : strlen(path);
+}
+
+bool session_log_sibling_path(const char *path, const char *suffix, char *buffer, size_t size)
+{
+    int length = snprintf(buffer, size, "%.*s%s", (int)session_log_stem_length(path), path, suffix);
+    return length >= 0 && (size_t)length < size;
+}
+
+int session_log_put_raw(char *buffer, size_t size, int length, const char *text)
+{
+    size_t text_len = strlen(text);
+    if (length < 0 || (size_t)length + text_len >= size) {
+        return -1;
+    }
+
+    memcpy(buffer + length, text, text_len + 1);
+    return length + (int)text_len;
+}
+
+int session_log_put_uint(char *buffer, size_t size, int length, uint64_t value)
+{
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    if (length < 0 || (size_t)length + count >= size) {
+        return -1;
+    }
+
+    char *out = buffer + length;
+    while (count) {
+        *out++ = digits[--count];
+    }
+    *out = '\0';
+    return (int)(out - buffer);
+}
+
+int session_log_put_int(char *buffer, size_t size, int length, int64_t value)
+{
+    if (value >= 0) {
+        return session_log_put_uint(buffer, size, length, (uint64_t)value);
+    }
+    length = session_log_put_raw(buffer, size, length, "-");
+    return session_log_put_uint(buffer, size, length, 0 - (uint64_t)value);
+}
+
+// Index of the lowest set bit of a nonzero mask
+static unsigned lowest_bit(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+// Offset of the first byte JSON needs escaped (a quote, a backslash or a
+// control character), or length if there is none. Looks at 16 bytes at a
+// time where the CPU can, which is all of a typical comment or path.
+static size_t find_escape(const uint8_t *data, size_t length)
+{
+    size_t i = 0;
+
+#if defined(SESSION_LOG_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+
+        // chunk <= 0x1F unsigned: the minimum of the two is the chunk itself
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                    _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        if (mask) {
+            return i + lowest_bit(mask);
+        }
+    }
+#elif defined(SESSION_LOG_NEON)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x1F);
+
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t chunk = vld1q_u8(data + i);
+        uint8x16_t hits =
+            vorrq_u8(vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)), vcleq_u8(chunk, control));
+        if (vmaxvq_u8(hits)) {
+            break; // the byte loop below finds which one
+        }
+    }
+#endif
+
+    for (; i < length; i++) {
+        if (data[i] == '"' || data[i] == '\\' || data[i] < 0x20) {
+            return i;
+        }
+    }
+    return length;
+}
+
+int session_log_put_string(char *buffer, size_t size, int length, const char *string)
+{
+    if (length < 0) {
+        return -1;
+    }
+
+    const uint8_t *in = (const uint8_t *)string;
+    size_t remaining = strlen(string);
+    size_t pos = (size_t)length;
+
+    // Room for both quotes and the NUL is checked up front
+    if (pos + remaining + 3 > size) {
+        return -1;
+    }
+    buffer[pos++] = '"';
+
+    for (;;) {
+        size_t clean = find_escape(in, remaining);
+        if (pos + clean + 2 > size) {
+            return -1;
+        }
+        memcpy(buffer + pos, in, clean);
+        pos += clean;
+        in += clean;
+        remaining -= clean;
+
+        if (!remaining) {
+            break;
+        }
+
+        // The slow path, one escaped byte
+        char escape[7];
+        switch (*in) {
+        case '"': memcpy(escape, "\\\"", 3); break;
+        case '\\': memcpy(escape, "\\\\", 3); break;
+        case '\n': memcpy(escape, "\\n", 3); break;
+        case '\r': memcpy(escape, "\\r", 3); break;
+        case '\t': memcpy(escape, "\\t", 3); break;
+        case '\b': memcpy(escape, "\\b", 3); break;
+        case '\f': memcpy(escape, "\\f", 3); break;
+        default: snprintf(escape, sizeof(escape), "\\u%04x", *in); break;
+        }
+
+        size_t escape_len = strlen(escape);
+        if (pos + escape_len + remaining + 1 >= size) {
+            return -1;
+        }
+        memcpy(buffer + pos, escape, escape_len);
+        pos += escape_len;
+        in++;
+        remaining--;
+    }
+
+    buffer[pos++] = '"';
+    buffer[pos] = '\0';
+    return (int)pos;
+}
+
+int session_log_format_header(char *buffer, size_t size, const char *recording_path, const char *start_time,
+                              uint32_t fps_num, uint32_t fps_den)
+{
+    int length = session_log_put_raw(buffer, size, 0, "{\"metadata\": {\"recording_path\": ");
+    length = session_log_put_string(buffer, size, length, recording_path);
+    length = session_log_put_raw(buffer, size, length, ", \"timestamp\": ");
+    length = session_log_put_string(buffer, size, length, start_time);
+    length = session_log_put_raw(buffer, size, length, ", \"fps_num\": ");
+    length = session_log_put_uint(buffer, size, length, fps_num);
+    length = session_log_put_raw(buffer, size, length, ", \"fps_den\": ");
+    length = session_log_put_uint(buffer, size, length, fps_den);
+    length = session_log_put_raw(buffer, size, length, "}");
+    return session_log_seal(buffer, size, length);
+}
+
+int session_log_format_segment(char *buffer, size_t size, uint32_t segment, uint64_t start_ms, uint64_t start_frame,
+                               const char *previous)
+{
+    int length = session_log_put_raw(buffer, size, 0, "{\"metadata\": {\"segment\": ");
+    length = session_log_put_uint(buffer, size, length, segment);
+    length = session_log_put_raw(buffer, size, length, ", \"segment_start_ms\": ");
+    length = session_log_put_uint(buffer, size, length, start_ms);
+    length = session_log_put_raw(buffer, size, length, ", \"segment_start_frame\": ");
+    length = session_log_put_uint(buffer, size, length, start_frame);
+    length = session_log_put_raw(buffer, size, length, ", \"previous_segment\": ");
+    length = session_log_put_string(buffer, size, length, previous ? previous : "");
+    length = session_log_put_raw(buffer, size, length, "}");
+    return session_log_seal(buffer, size, length);
+}
+
+int session_log_format_marker(char *buffer, size_t size, const struct marker_record *record)
+{
+    int length = session_log_put_raw(buffer, size, 0, "{\"timestamp_ms\": ");
+    length = session_log_put_uint(buffer, size, length, record->timestamp_ms);
+    length = session_log_put_raw(buffer, size, length, ", \"frame\": ");
+    length = session_log_put_uint(buffer, size, length, record->frame);
+    length = session_log_put_raw(buffer, size, length, ", \"comment\": ");
+    length = session_log_put_string(buffer, size, length, record->comment);
+    length = session_log_put_raw(buffer, size, length, ", \"name\": ");
+    length = session_log_put_string(buffer, size, length, record->name);
+    length = session_log_put_raw(buffer, size, length, ", \"color\": ");
+    length = session_log_put_string(buffer, size, length, record->color[0] ? record->color : "blue");
+
+    if (record->count > 1) {
+        length = session_log_put_raw(buffer, size, length, ", \"count\": ");
+        length = session_log_put_uint(buffer, size, length, record->count);
+    }
+    return session_log_seal(buffer, size, length);
+}
+
+int session_log_format_trailer(char *buffer, size_t size, const char *video_path, bool recovered)
+{
+    int length = session_log_put_raw(buffer, size, 0, "{\"metadata\": {");
+    if (recovered) {
+        length = session_log_put_raw(buffer, size, length, "\"recovered\": true, ");
+    }
+    length = session_log_put_raw(buffer, size, length, "\"video_path\": ");
+    length = session_log_put_string(buffer, size, length, video_path ? video_path : "");
+    length = session_log_put_raw(buffer, size, length, "}");
+    return session_log_seal(buffer, size, length);
+}
+
+// The crc field closes the line, so it is the last occurrence
+static const char *find_crc_field(const char *line, size_t length)
+{
+    size_t field = sizeof(CRC_FIELD) - 1;
+    if (length < field + 10) {
+        return NULL;
+    }
+
+    for (size_t i = length - field - 10 + 1; i-- > 0;) {
+        if (memcmp(line + i, CRC_FIELD, field) == 0) {
+            return line + i;
+        }
+    }
+    return NULL;
+}
+
+bool session_log_check(const char *line, size_t length)
+{
+    while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == ' ')) {
+        length--;
+    }
+    if (length < 2 || line[0] != '{' || line[length - 1] != '}') {
+        return false;
+    }
+
+    const char *field = find_crc_field(line, length);
+    if (!field) {
+        return true;
+    }
+
+    // ", \"crc\": \"xxxxxxxx\"}" must be the very end
+    const char *digits = field + sizeof(CRC_FIELD) - 1;
+    if ((size_t)(line + length - digits) != 10 || digits[8] != '"') {
+        return false;
+    }
+
+    char hex[9];
+    memcpy(hex, digits, 8);
+    hex[8] = '\0';
+
+    char *end;
+    unsigned long stored = strtoul(hex, &end, 16);
+    if (*end) {
+        return false;
+    }
+
+    return session_log_crc32(0, line, (size_t)(field - line)) == (uint32_t)stored;
+}
+
+// Start of the value of "key": in the line, or NULL
+static const char *find_value(const char *line, size_t length, const char *key)
+{
+    char pattern[64];
+    int pattern_len = snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    if (pattern_len <= 0 || (size_t)pattern_len >= sizeof(pattern) || (size_t)pattern_len > length) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i + (size_t)pattern_len <= length; i++) {
+        if (memcmp(line + i, pattern, (size_t)pattern_len) == 0) {
+            return line + i + pattern_len;
+        }
+    }
+    return NULL;
+}
+
+static void put_utf8(char *buffer, size_t size, size_t *pos, uint32_t code)
+{
+    char bytes[4];
+    size_t count;
+
+    if (code < 0x80) {
+        bytes[0] = (char)code;
+        count = 1;
+    } else if (code < 0x800) {
+        bytes[0] = (char)(0xC0 | (code >> 6));
+        bytes[1] = (char)(0x80 | (code & 0x3F));
+        count = 2;
+    } else {
+        bytes[0] = (char)(0xE0 | (code >> 12));
+        bytes[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        bytes[2] = (char)(0x80 | (code & 0x3F));
+        count = 3;
+    }
+
+    if (*pos + count < size) {
+        memcpy(buffer + *pos, bytes, count);
+        *pos += count;
+    }
+}
+
+bool session_log_get_string(const char *line, size_t length, const char *key, char *buffer, size_t size)
+{
+    if (size == 0) {
+        return false;
+    }
+    buffer[0] = '\0';
+
+    const char *value = find_value(line, length, key);
+    const char *end = line + length;
+    if (!value || value >= end || *value != '"') {
+        return false;
+    }
+
+    size_t pos = 0;
+    for (const char *c = value + 1; c < end; c++) {
+        if (*c == '"') {
+            buffer[pos] = '\0';
+            return true;
+        }
+
+        char out = *c;
+        if (*c == '\\' && c + 1 < end) {
+            c++;
+            switch (*c) {
+            case 'n': out = '\n'; break;
+            case 'r': out = '\r'; break;
+            case 't': out = '\t'; break;
+            case 'b': out = '\b'; break;
+            case 'f': out = '\f'; break;
+            case 'u':
+                if (end - c > 4) {
+                    char hex[5] = {c[1], c[2], c[3], c[4], '\0'};
+                    put_utf8(buffer, size, &pos, (uint32_t)strtoul(hex, NULL, 16));
+                    c += 4;
+                }
+                continue;
+            default: out = *c; break; // \" \\ \/
+            }
+        }
+
+        if (pos + 1 < size) {
+            buffer[pos++] = out;
+        }
+    }
+
+    buffer[0] = '\0';
+    return false;
+}
+
+bool session_log_get_int(const char *line, size_t length, const char *key, int64_t *value)
+{
+    const char *start = find_value(line, length, key);
+    if (!start || start >= line + length) {
+        return false;
+    }
+
+    char *end;
+    long long parsed = strtoll(start, &end, 10);
+    if (end == start) {
+        return false;
+    }
+
+    *value = (int64_t)parsed;
+    return true;
+}
+
+bool session_log_parse_marker(const char *line, size_t length, struct marker_record *record)
+{
+    int64_t timestamp_ms, frame = 0, count = 1;
+
+    if (!session_log_get_int(line, length, "timestamp_ms", &timestamp_ms) || timestamp_ms < 0) {
+        return false;
+    }
+    session_log_get_int(line, length, "frame", &frame);
+    session_log_get_int(line, length, "count", &count);
+
+    memset(record, 0, sizeof(*record));
+    record->type = MARKER_RECORD_MARKER;
+    record->timestamp_ms = (uint64_t)timestamp_ms;
+    record->timestamp_ns = (uint64_t)timestamp_ms * 1000000;
+    record->frame = frame > 0 ? (uint64_t)frame : 0;
+    record->count = count > 1 ? (uint32_t)count : 1;
+
+    session_log_get_string(line, length, "comment", record->comment, sizeof(record->comment));
+    session_log_get_string(line, length, "name", record->name, sizeof(record->name));
+    if (!session_log_get_string(line, length, "color", record->color, sizeof(record->color))) {
+        snprintf(record->color, sizeof(record->color), "blue");
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "marker-queue.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Line format of the JSON Lines session log: a metadata header, one line per
+// marker, then trailing metadata. Every line the plugin writes ends in a
+// "crc" field, the CRC-32 (as zlib.crc32 computes it) of the line's bytes in
+// front of ", \"crc\"":
+//
+//   {"timestamp_ms": 15000, "frame": 900, "comment": "Marker 1", "name": "", "color": "blue", "crc": "2e7229ed"}
+//
+// so a reader can tell a complete line from one a crash cut short or that
+// was only partly flushed.
+
+// Longest line the plugin writes. Escaping can grow a string up to six
+// times, so even a marker whose comment is all control characters fits.
+#define SESSION_LOG_LINE_SIZE 4096
+
+uint32_t session_log_crc32(uint32_t crc, const void *data, size_t size);
+
+// Close a line: buffer holds length bytes of a JSON object without its final
+// brace. Appends the crc field, the brace and the newline; returns the new
+// length, or -1 if it doesn't fit.
+int session_log_seal(char *buffer, size_t size, int length);
+
+// Serializer: each call appends at buffer + length, keeps the buffer
+// NUL-terminated and returns the new length, or -1 once anything didn't fit
+// (later calls pass the -1 through, so a line is checked once at the end).
+// Strings are quoted and escaped for JSON; a vectorized scan finds the bytes
+// that need it, so the common string without any is copied in one go.
+int session_log_put_raw(char *buffer, size_t size, int length, const char *text);
+int session_log_put_string(char *buffer, size_t size, int length, const char *string);
+int session_log_put_uint(char *buffer, size_t size, int length, uint64_t value);
+int session_log_put_int(char *buffer, size_t size, int length, int64_t value);
+
+// Seal a line built in a SESSION_LOG_LINE_SIZE buffer and write it out;
+// false if it didn't fit or the write failed
+bool session_log_write_line(FILE *file, char *line, int length);
+
+// Paths of the files that go with a session log. Either separator counts,
+// whatever the platform, since logs move between systems.
+//
+// File name part of path
+const char *session_log_file_name(const char *path);
+
+// Length of path without the file name's extension
+size_t session_log_stem_length(const char *path);
+
+// path with the file name's extension replaced by suffix
+// ("a/b.jsonl", ".tsidx" -> "a/b.tsidx"); false if it doesn't fit
+bool session_log_sibling_path(const char *path, const char *suffix, char *buffer, size_t size);
+
+// Complete, sealed lines; each returns its length or -1
+int session_log_format_header(char *buffer, size_t size, const char *recording_path, const char *start_time,
+                              uint32_t fps_num, uint32_t fps_den);
+int session_log_format_marker(char *buffer, size_t size, const struct marker_record *record);
+
+// Second metadata line of the log of a later file of a split recording: the
+// file's index in the recording (0 is the first, which has no such line),
+// where it starts on the recording timeline, and the log of the file before.
+// The marker lines that follow count from that start.
+int session_log_format_segment(char *buffer, size_t size, uint32_t segment, uint64_t start_ms, uint64_t start_frame,
+                               const char *previous);
+
+// The metadata line that follows the markers: the final video path, and
+// whether the session was closed by crash recovery instead of at stop
+int session_log_format_trailer(char *buffer, size_t size, const char *video_path, bool recovered);
+
+// Whether a line (without its newline) is intact. Lines without a crc field
+// are accepted if they look complete, as logs from older versions have none.
+bool session_log_check(const char *line, size_t length);
+
+// Field lookup in a flat JSON line written by the plugin; a string that is
+// missing comes back as ""
+bool session_log_get_string(const char *line, size_t length, const char *key, char *buffer, size_t size);
+bool session_log_get_int(const char *line, size_t length, const char *key, int64_t *value);
+
+// Parse a marker line; false for metadata and anything else
+bool session_log_parse_marker(const char *line, size_t length, struct marker_record *record);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+#include "session-manifest.h"
+#include "marker-journal.h"
+#include "session-log.h"
+#include <util/platform.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+void session_manifest_path(const char *session_path, char *buffer, size_t size)
+{
+    size_t dir_len = (size_t)(session_log_file_name(session_path) - session_path);
+    snprintf(buffer, size, "%.*s%s", (int)dir_len, session_path, SESSION_MANIFEST_NAME);
+}
+
+// Open the manifest for appending and report where the next entry starts
+static FILE *open_manifest(const char *manifest_path, int64_t *offset)
+{
+    FILE *file = fopen(manifest_path, "ab");
+    if (!file) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to open session manifest: %s", manifest_path);
+        return NULL;
+    }
+
+    os_fseeki64(file, 0, SEEK_END);
+    *offset = os_ftelli64(file);
+    return file;
+}
+
+// An entry holds up to six paths, each of which may double in size when
+// its backslashes are escaped
+#define MANIFEST_ENTRY_SIZE (4 * SESSION_LOG_LINE_SIZE)
+
+// ", \"key\": value" onto the entry
+static int put_string_field(char *entry, int length, const char *key, const char *value)
+{
+    length = session_log_put_raw(entry, MANIFEST_ENTRY_SIZE, length, key);
+    return session_log_put_string(entry, MANIFEST_ENTRY_SIZE, length, value);
+}
+
+static int put_int_field(char *entry, int length, const char *key, int64_t value)
+{
+    length = session_log_put_raw(entry, MANIFEST_ENTRY_SIZE, length, key);
+    return session_log_put_int(entry, MANIFEST_ENTRY_SIZE, length, value);
+}
+
+// Seal the entry and write it in one go. A failed write leaves at most one
+// partial line, which readers skip.
+static bool close_manifest(FILE *file, const char *manifest_path, char *entry, int length)
+{
+    length = session_log_seal(entry, MANIFEST_ENTRY_SIZE, length);
+    bool ok = length > 0 && fwrite(entry, 1, (size_t)length, file) == (size_t)length;
+    ok = ferror(file) == 0 && ok;
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+
+    if (!ok) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to write session manifest: %s", manifest_path);
+    }
+    return ok;
+}
+
+int64_t session_manifest_begin(const char *manifest_path, const struct marker_session_info *info)
+{
+    int64_t offset;
+    FILE *file = open_manifest(manifest_path, &offset);
+    if (!file) {
+        return -1;
+    }
+
+    char journal[512] = "";
+    if (info->log_format != MARKER_LOG_JSONL) {
+        session_log_sibling_path(info->path, MARKER_JOURNAL_EXTENSION, journal, sizeof(journal));
+    }
+
+    char entry[MANIFEST_ENTRY_SIZE];
+    int length = session_log_put_raw(entry, sizeof(entry), 0, "{\"event\": \"begin\"");
+    length = put_string_field(entry, length, ", \"session\": ", session_log_file_name(info->path));
+    length = put_string_field(entry, length, ", \"log\": ", info->log_format != MARKER_LOG_BINARY ? info->path : "");
+    length = put_string_field(entry, length, ", \"journal\": ", journal);
+    length = put_string_field(entry, length, ", \"video\": ", info->video_path);
+    length = put_string_field(entry, length, ", \"recording_path\": ", info->recording_path);
+    length = put_string_field(entry, length, ", \"start_time\": ", info->start_time);
+    length = put_int_field(entry, length, ", \"start_epoch\": ", info->start_epoch);
+    length = put_int_field(entry, length, ", \"fps_num\": ", info->fps_num);
+    length = put_int_field(entry, length, ", \"fps_den\": ", info->fps_den);
+    length = put_int_field(entry, length, ", \"width\": ", info->width);
+    length = put_int_field(entry, length, ", \"height\": ", info->height);
+    length = put_int_field(entry, length, ", \"export_formats\": ", info->export_formats);
+    if (info->segment) {
+        length = put_int_field(entry, length, ", \"segment\": ", info->segment);
+        length = put_int_field(entry, length, ", \"segment_start_ms\": ", (int64_t)(info->segment_start_ns / 1000000));
+        length = put_string_field(entry, length, ", \"previous_segment\": ", session_log_file_name(info->previous_segment));
+    }
+
+    return close_manifest(file, manifest_path, entry, length) ? offset : -1;
+}
+
+bool session_manifest_end(const char *manifest_path, const struct marker_session_info *info,
+                          const struct session_manifest_summary *summary)
+{
+    int64_t offset;
+    FILE *file = open_manifest(manifest_path, &offset);
+    if (!file) {
+        return false;
+    }
+
+    char entry[MANIFEST_ENTRY_SIZE];
+    int length = session_log_put_raw(entry, sizeof(entry), 0, "{\"event\": \"end\"");
+    length = put_string_field(entry, length, ", \"session\": ", session_log_file_name(info->path));
+    length = put_string_field(entry, length, ", \"video\": ", info->video_path);
+    length = put_int_field(entry, length, ", \"begin_offset\": ", summary->begin_offset);
+    length = put_int_field(entry, length, ", \"markers\": ", (int64_t)summary->markers);
+    length = put_int_field(entry, length, ", \"data_offset\": ", (int64_t)summary->data_offset);
+    length = put_int_field(entry, length, ", \"end_offset\": ", (int64_t)summary->end_offset);
+    length = put_int_field(entry, length, ", \"journal_size\": ", (int64_t)summary->journal_size);
+    length = put_int_field(entry, length, ", \"index_blocks\": ", (int64_t)summary->index_blocks);
+    length = put_int_field(entry, length, ", \"end_epoch\": ", (int64_t)time(NULL));
+    if (summary->recovered) {
+        length = session_log_put_raw(entry, sizeof(entry), length, ", \"recovered\": true");
+    }
+
+    return close_manifest(file, manifest_path, entry, length);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "marker-writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Append-only index of every session written into a sessions directory, one
+// JSON object per line. A session gets a "begin" entry when its log is opened
+// and an "end" entry when it is closed:
+//
+//   {"event": "begin", "session": "2024-05-01 20-15-00.jsonl", "log": ..., "journal": ...,
+//    "video": ..., "recording_path": ..., "start_time": ..., "start_epoch": ..., "fps_num": ..., "fps_den": ...,
+//    "width": ..., "height": ..., "crc": ...}
+//   {"event": "end", "session": ..., "video": ..., "begin_offset": ..., "markers": ..., "data_offset": ...,
+//    "end_offset": ..., "journal_size": ..., "index_blocks": ..., "end_epoch": ..., "crc": ...}
+//
+// The log of a later file of a split recording adds "segment", "segment_start_ms"
+// and "previous_segment" (the session of the file before) to its begin entry,
+// so the files of one recording chain back to its first.
+//
+// begin_offset is where the session's begin entry starts in the manifest, and
+// data_offset/end_offset delimit the marker lines in the JSONL log, so readers
+// can seek straight to a session. A begin without an end is a session that
+// never closed (OBS crashed or is still recording); the end entry the plugin
+// writes once it has recovered such a session says "recovered": true. Entries
+// are sealed like session log lines (see session-log.h).
+
+#define SESSION_MANIFEST_NAME "sessions.manifest"
+
+// Figures written into a session's end entry
+struct session_manifest_summary {
+    int64_t begin_offset;
+    uint64_t markers;
+    uint64_t data_offset;  // first marker line of the JSONL log (0 without one)
+    uint64_t end_offset;   // size of the JSONL log at close
+    uint64_t journal_size; // size of the binary journal at close (0 without one)
+    uint64_t index_blocks; // blocks in the log's .tsidx index (0 without one, see session-index.h)
+    bool recovered;        // closed after a crash rather than at stop
+};
+
+// The manifest that indexes the directory session_path lives in
+void session_manifest_path(const char *session_path, char *buffer, size_t size);
+
+// Append the begin entry; returns its offset in the manifest, or -1
+int64_t session_manifest_begin(const char *manifest_path, const struct marker_session_info *info);
+
+bool session_manifest_end(const char *manifest_path, const struct marker_session_info *info,
+                          const struct session_manifest_summary *summary);
+
+#ifdef __cplusplus
+}
+#endif
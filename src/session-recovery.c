@@ -0,0 +1,389 @@
+#include "session-recovery.h"
+#include "marker-journal.h"
+#include "session-index.h"
+#include "session-log.h"
+#include "timestamp-plugin.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Directory part of a path, separator included
+static size_t dir_length(const char *path)
+{
+    return (size_t)(session_log_file_name(path) - path);
+}
+
+// Read [offset, end of file) into a bmalloc'd buffer
+static char *read_from(FILE *file, int64_t offset, size_t *length)
+{
+    os_fseeki64(file, 0, SEEK_END);
+    int64_t size = os_ftelli64(file);
+    if (size <= offset || os_fseeki64(file, offset, SEEK_SET) != 0) {
+        return NULL;
+    }
+
+    char *data = bmalloc((size_t)(size - offset) + 1);
+    *length = fread(data, 1, (size_t)(size - offset), file);
+    data[*length] = '\0';
+    return data;
+}
+
+static uint32_t get_uint(const char *line, size_t length, const char *key)
+{
+    int64_t value = 0;
+    session_log_get_int(line, length, key, &value);
+    return value > 0 && value <= UINT32_MAX ? (uint32_t)value : 0;
+}
+
+// Session info as it was at start, from the manifest's begin entry
+static struct marker_session_info *info_from_begin(const char *manifest_path, const char *line, size_t length)
+{
+    char session[256], log[512], journal[512];
+    if (!session_log_get_string(line, length, "session", session, sizeof(session)) || !session[0]) {
+        return NULL;
+    }
+    session_log_get_string(line, length, "log", log, sizeof(log));
+    session_log_get_string(line, length, "journal", journal, sizeof(journal));
+
+    struct marker_session_info *info = bzalloc(sizeof(*info));
+
+    // The sessions live next to the manifest that indexes them
+    snprintf(info->path, sizeof(info->path), "%.*s%s", (int)dir_length(manifest_path), manifest_path, session);
+
+    if (log[0] && journal[0]) {
+        info->log_format = MARKER_LOG_BOTH;
+    } else if (journal[0]) {
+        info->log_format = MARKER_LOG_BINARY;
+    } else {
+        info->log_format = MARKER_LOG_JSONL;
+    }
+
+    session_log_get_string(line, length, "video", info->video_path, sizeof(info->video_path));
+    session_log_get_string(line, length, "recording_path", info->recording_path, sizeof(info->recording_path));
+    session_log_get_string(line, length, "start_time", info->start_time, sizeof(info->start_time));
+    session_log_get_int(line, length, "start_epoch", &info->start_epoch);
+    info->fps_num = get_uint(line, length, "fps_num");
+    info->fps_den = get_uint(line, length, "fps_den");
+    info->width = get_uint(line, length, "width");
+    info->height = get_uint(line, length, "height");
+    info->export_formats = get_uint(line, length, "export_formats");
+
+    // A later file of a split recording; its log already counts from the split
+    info->segment = get_uint(line, length, "segment");
+    if (info->segment) {
+        int64_t start_ms = 0;
+        session_log_get_int(line, length, "segment_start_ms", &start_ms);
+        info->segment_start_ns = start_ms > 0 ? (uint64_t)start_ms * 1000000ULL : 0;
+
+        char previous[256];
+        if (session_log_get_string(line, length, "previous_segment", previous, sizeof(previous)) && previous[0]) {
+            snprintf(info->previous_segment, sizeof(info->previous_segment), "%.*s%s", (int)dir_length(manifest_path),
+                     manifest_path, previous);
+        }
+    }
+
+    if (!info->fps_num || !info->fps_den) {
+        info->fps_num = 30;
+        info->fps_den = 1;
+    }
+
+    // Enough of the clock to move frames with the drift table
+    info->clock.fps_num = info->fps_num;
+    info->clock.fps_den = info->fps_den;
+    return info;
+}
+
+struct marker_session_info *session_recovery_find(const char *manifest_path, int64_t *begin_offset)
+{
+    FILE *file = os_fopen(manifest_path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    os_fseeki64(file, 0, SEEK_END);
+    int64_t size = os_ftelli64(file);
+    int64_t start = size > SESSION_RECOVERY_TAIL_SIZE ? size - SESSION_RECOVERY_TAIL_SIZE : 0;
+
+    size_t length = 0;
+    char *tail = read_from(file, start, &length);
+    fclose(file);
+    if (!tail) {
+        return NULL;
+    }
+
+    const char *end = tail + length;
+    const char *line = tail;
+
+    // Inside the manifest the window starts mid-entry
+    if (start > 0) {
+        const char *newline = memchr(line, '\n', length);
+        line = newline ? newline + 1 : end;
+    }
+
+    // Sessions close in the order they open, so only the latest can still
+    // be unfinished; an end entry that refers to it settles it
+    const char *pending = NULL;
+    size_t pending_length = 0;
+    int64_t pending_offset = -1;
+
+    while (line < end) {
+        const char *newline = memchr(line, '\n', (size_t)(end - line));
+        if (!newline) {
+            break; // torn by a crash while it was written
+        }
+
+        size_t line_length = (size_t)(newline - line);
+        char event[16];
+        if (session_log_check(line, line_length) &&
+            session_log_get_string(line, line_length, "event", event, sizeof(event))) {
+            int64_t offset;
+            if (strcmp(event, "begin") == 0) {
+                pending = line;
+                pending_length = line_length;
+                pending_offset = start + (int64_t)(line - tail);
+            } else if (strcmp(event, "end") == 0 && pending &&
+                       session_log_get_int(line, line_length, "begin_offset", &offset) && offset == pending_offset) {
+                pending = NULL;
+            }
+        }
+
+        line = newline + 1;
+    }
+
+    struct marker_session_info *info = NULL;
+    if (pending) {
+        info = info_from_begin(manifest_path, pending, pending_length);
+        *begin_offset = pending_offset;
+    }
+
+    bfree(tail);
+    return info;
+}
+
+static void write_line(FILE *file, const char *line, int length)
+{
+    if (length > 0) {
+        fwrite(line, 1, (size_t)length, file);
+    }
+}
+
+// Cut the file back to its last intact line
+static bool truncate_file(FILE *file, uint64_t size)
+{
+    fflush(file);
+#ifdef _WIN32
+    return _chsize_s(_fileno(file), (__int64)size) == 0;
+#else
+    return ftruncate(fileno(file), (off_t)size) == 0;
+#endif
+}
+
+static void sync_file(FILE *file)
+{
+    fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+// Load the intact lines of the JSONL log and close it as stop would have
+static struct marker_store *repair_jsonl(struct marker_session_info *info, struct session_manifest_summary *summary,
+                                         struct clock_drift *drift)
+{
+    FILE *file = os_fopen(info->path, "r+b");
+    if (!file) {
+        blog(LOG_WARNING, "Timestamp Plugin: Could not open %s to recover it", info->path);
+        return NULL;
+    }
+
+    size_t length = 0;
+    char *data = read_from(file, 0, &length);
+    if (!data) {
+        fclose(file);
+        return NULL;
+    }
+
+    struct marker_store *store = marker_store_create();
+    struct marker_record last = {0};
+    bool has_end = false;
+    size_t valid = 0;
+
+    // Rebuilt as the lines are read; stop would have written it
+    struct session_index index;
+    session_index_init(&index);
+
+    const char *end = data + length;
+    for (const char *line = data; line < end;) {
+        const char *newline = memchr(line, '\n', (size_t)(end - line));
+        if (!newline || !session_log_check(line, (size_t)(newline - line))) {
+            break; // everything from the first bad line on is lost with the crash
+        }
+
+        size_t line_length = (size_t)(newline - line);
+        struct marker_record record;
+        if (session_log_parse_marker(line, line_length, &record)) {
+            marker_store_add(store, &record);
+            session_index_add(&index, (uint64_t)(line - data), line_length + 1, record.timestamp_ms);
+            has_end = strcmp(record.comment, "Recording End") == 0;
+            last = record;
+            summary->end_offset = (uint64_t)(newline + 1 - data);
+        } else if (marker_store_count(store) == 0) {
+            // The header, and the segment line of a later file
+            summary->data_offset = (uint64_t)(newline + 1 - data);
+            summary->end_offset = summary->data_offset;
+        } else if (!clock_drift_parse(drift, line, line_length)) {
+            // The log was closed after all and only the manifest missed it
+            char video_path[512];
+            if (session_log_get_string(line, line_length, "video_path", video_path, sizeof(video_path))) {
+                snprintf(info->video_path, sizeof(info->video_path), "%s", video_path);
+            }
+        }
+
+        valid = (size_t)(newline + 1 - data);
+        line = newline + 1;
+    }
+    bfree(data);
+
+    if (valid < length) {
+        if (truncate_file(file, valid)) {
+            blog(LOG_INFO, "Timestamp Plugin: Cut %zu torn byte(s) off the end of %s", length - valid, info->path);
+        } else {
+            blog(LOG_WARNING, "Timestamp Plugin: Could not cut the torn end off %s", info->path);
+        }
+    }
+    os_fseeki64(file, (int64_t)valid, SEEK_SET);
+
+    char line[SESSION_LOG_LINE_SIZE];
+
+    // The crash time is unknown; the last marker is the last moment known
+    // to be in the recording
+    if (!has_end && marker_store_count(store) > 0) {
+        struct marker_record record = {0};
+        record.type = MARKER_RECORD_MARKER;
+        record.timestamp_ns = last.timestamp_ns;
+        record.timestamp_ms = last.timestamp_ms;
+        record.frame = last.frame;
+        record.count = 1;
+        snprintf(record.comment, sizeof(record.comment), "Recording End");
+        snprintf(record.color, sizeof(record.color), "green");
+
+        int64_t offset = os_ftelli64(file);
+        int length = session_log_format_marker(line, sizeof(line), &record);
+        write_line(file, line, length);
+        marker_store_add(store, &record);
+        if (length > 0 && offset >= 0) {
+            session_index_add(&index, (uint64_t)offset, (uint64_t)length, record.timestamp_ms);
+        }
+        summary->end_offset = (uint64_t)os_ftelli64(file);
+    }
+
+    write_line(file, line, session_log_format_trailer(line, sizeof(line), info->video_path, true));
+
+    bool ok = ferror(file) == 0;
+    sync_file(file);
+    if (fclose(file) != 0 || !ok) {
+        blog(LOG_WARNING, "Timestamp Plugin: Failed to write the recovered end of %s", info->path);
+    }
+
+    if (index.blocks.num && session_index_write(&index, info->path)) {
+        summary->index_blocks = index.blocks.num;
+    }
+    session_index_free(&index);
+
+    return store;
+}
+
+// A binary-only session: the records survive a crash, their strings don't
+static struct marker_store *repair_journal(const char *path, struct clock_drift *drift)
+{
+    struct marker_journal_reader reader;
+    if (!marker_journal_open(&reader, path)) {
+        return NULL;
+    }
+
+    struct marker_store *store = marker_store_create();
+    bool has_end = false;
+
+    for (size_t i = 0; i < reader.count; i++) {
+        const struct marker_journal_record *entry = &reader.records[i];
+
+        struct marker_record record = {0};
+        record.type = MARKER_RECORD_MARKER;
+        record.timestamp_ns = entry->timestamp_ns;
+        record.timestamp_ms = entry->timestamp_ns / 1000000;
+        record.frame = entry->frame;
+        record.count = entry->count ? entry->count : 1;
+        snprintf(record.comment, sizeof(record.comment), "%s", marker_journal_string(&reader, entry->comment));
+        snprintf(record.name, sizeof(record.name), "%s", marker_journal_string(&reader, entry->name));
+        snprintf(record.color, sizeof(record.color), "%s", marker_color_name((enum marker_color)entry->color));
+
+        marker_store_add(store, &record);
+        has_end = strcmp(record.comment, "Recording End") == 0;
+    }
+
+    // Only for the export; the journal itself is left as the crash left it
+    if (!has_end && reader.count > 0) {
+        const struct marker_journal_record *entry = &reader.records[reader.count - 1];
+
+        struct marker_record record = {0};
+        record.type = MARKER_RECORD_MARKER;
+        record.timestamp_ns = entry->timestamp_ns;
+        record.frame = entry->frame;
+        record.count = 1;
+        snprintf(record.comment, sizeof(record.comment), "Recording End");
+        snprintf(record.color, sizeof(record.color), "green");
+        marker_store_add(store, &record);
+    }
+
+    marker_journal_load_drift(&reader, drift);
+    marker_journal_unmap(&reader);
+    return store;
+}
+
+// Only the drift table of a journal whose text log had none
+static void load_journal_drift(const char *path, struct clock_drift *drift)
+{
+    struct marker_journal_reader reader;
+    if (marker_journal_open(&reader, path)) {
+        marker_journal_load_drift(&reader, drift);
+        marker_journal_unmap(&reader);
+    }
+}
+
+struct marker_store *session_recovery_repair(struct marker_session_info *info,
+                                             struct session_manifest_summary *summary, struct clock_drift *drift)
+{
+    uint64_t start_ns = os_gettime_ns();
+    struct marker_store *store = NULL;
+
+    char journal[512];
+    session_log_sibling_path(info->path, MARKER_JOURNAL_EXTENSION, journal, sizeof(journal));
+
+    // The text log has the strings, so it wins when there are both
+    if (info->log_format != MARKER_LOG_BINARY) {
+        store = repair_jsonl(info, summary, drift);
+    }
+
+    if (info->log_format != MARKER_LOG_JSONL) {
+        int64_t journal_size = os_get_file_size(journal);
+        summary->journal_size = journal_size > 0 ? (uint64_t)journal_size : 0;
+
+        if (!store) {
+            store = repair_journal(journal, drift);
+        } else if (drift->points.num < 2) {
+            load_journal_drift(journal, drift);
+        }
+    }
+
+    if (store) {
+        summary->markers = marker_store_count(store);
+        blog(LOG_INFO, "Timestamp Plugin: Recovered %" PRIu64 " marker(s) of %s in %.1f ms", summary->markers,
+             info->path, (double)(os_gettime_ns() - start_ns) / 1000000.0);
+    }
+    return store;
+}
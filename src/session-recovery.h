@@ -0,0 +1,37 @@
+#pragma once
+
+#include "marker-store.h"
+#include "marker-writer.h"
+#include "session-manifest.h"
+#include "clock-drift.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Crash recovery. A recording OBS never stopped leaves a begin entry without
+// an end in sessions.manifest and a session log that stops wherever the
+// crash hit. Only the manifest's tail is read to find it, and only that
+// session's own files to repair it, so the cost follows the size of the
+// unfinished session and not the history in the directory.
+
+// How much of the end of the manifest is searched for the unfinished session
+#define SESSION_RECOVERY_TAIL_SIZE (64 * 1024)
+
+// The session the last run left open, if the manifest's latest session never
+// got an end entry: bzalloc'd info rebuilt from its begin entry, or NULL.
+// *begin_offset is where that entry starts in the manifest.
+struct marker_session_info *session_recovery_find(const char *manifest_path, int64_t *begin_offset);
+
+// Repair the session's logs and load its markers. A torn last line is cut
+// off, and the JSONL log gets the "Recording End" marker (at the last marker
+// it has), the trailing metadata line and the .tsidx index that stop would
+// have written. Fills in summary for the manifest's end entry, and drift
+// (zero-initialized) with the session's drift table if stop got as far as
+// writing it to either log; NULL if no log is readable.
+struct marker_store *session_recovery_repair(struct marker_session_info *info,
+                                             struct session_manifest_summary *summary, struct clock_drift *drift);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,24 +1,139 @@
 #include "timestamp-plugin.h"
+#include "marker-writer.h"
+#include "marker-api.h"
+#include "audio-trigger.h"
+#include "video-trigger.h"
+#include "marker-export.h"
+#include "marker-stats.h"
+#include "marker-store.h"
+#include "job-queue.h"
+#include "recording-clock.h"
+#include "session-log.h"
+#include <util/dstr.h>
 #include <time.h>
-#include <stdlib.h>
 
 // Global state
 static obs_hotkey_id timestamp_hotkey_id = OBS_INVALID_HOTKEY_ID;
-static bool recording_active = false;
-static uint64_t recording_start_time = 0;
-static char output_path[512] = {0};
-static uint64_t marker_counter = 0;
-static char recording_output_dir[512] = {0};
+static char session_dir[512] = {0};
+static volatile long marker_counter = 0;
 
-// Get the default output path
-static void get_default_output_path(char *buffer, size_t size)
+// Recording state read by the hotkey thread and written by the UI thread
+// (frontend events) only, as a sequence lock: an update makes session_seq odd,
+// changes the fields and makes it even again. The even value published at
+// recording start is the session's generation, which tags its markers so the
+// writer can reject stragglers; pausing and resuming republish under it.
+struct session_state {
+    bool active;
+    long generation;
+    struct recording_clock clock;
+    uint32_t coalesce_ms;
+    bool reject_paused; // PausedMarkers=reject
+};
+
+static struct session_state session_state = {0};
+static volatile long session_seq = 0;
+
+// Scene-change markers of the running recording, fixed at its start (UI
+// thread only, like the frontend events that create them)
+static bool scene_markers = false;
+static char scene_color[MARKER_COLOR_SIZE] = "";
+
+// Default SceneCoalesceMs: a switch within a second of the last is one transition
+#define DEFAULT_SCENE_COALESCE_MS 1000
+
+// Audio level detector of the running recording (UI thread only)
+static struct audio_trigger *audio_trigger = NULL;
+
+// Audio trigger defaults: a shout well above normal speech, and a 2 s pause
+// before the next one counts
+#define DEFAULT_AUDIO_TRIGGER_DB -12.0
+#define DEFAULT_AUDIO_TRIGGER_HYSTERESIS_DB 6.0
+#define DEFAULT_AUDIO_TRIGGER_HOLD_MS 2000
+
+// Picture change detector of the running recording (UI thread only)
+static struct video_trigger *video_trigger = NULL;
+
+// Video trigger defaults: a 64 px wide luma image ten times a second, which
+// costs microseconds per frame, and a threshold a hard cut clears easily
+#define DEFAULT_VIDEO_TRIGGER_WIDTH 64
+#define DEFAULT_VIDEO_TRIGGER_FPS 10
+#define DEFAULT_VIDEO_TRIGGER_THRESHOLD 25.0
+#define DEFAULT_VIDEO_TRIGGER_HOLD_MS 2000
+
+// Recording output whose file splits start a new session log (UI thread only)
+static obs_output_t *split_output = NULL;
+
+// Last hotkey press, for the coalescing window (hotkey thread only)
+static uint64_t burst_press_ns = 0;
+static long burst_generation = 0;
+static long burst_number = 0;
+
+// Profile settings the plugin needs at recording start, resolved ahead of time
+// so starting a recording does no config lookups on the UI thread
+struct plugin_settings {
+    bool loaded;
+    char recording_dir[512];
+    uint32_t fps_num;
+    uint32_t fps_den;
+    struct marker_flush_policy flush;
+    enum marker_log_format log_format;
+    bool dump_jsonl;
+    bool live_xml;
+    bool chapters;
+    uint32_t coalesce_ms;
+    uint32_t repeat_ms;
+    bool reject_paused;
+    char broadcast_address[64];
+    uint32_t export_formats;
+    bool scene_markers;
+    uint32_t scene_coalesce_ms;
+    char scene_color[MARKER_COLOR_SIZE];
+    struct audio_trigger_settings audio_trigger;
+    struct video_trigger_settings video_trigger;
+};
+
+static struct plugin_settings settings = {0};
+
+// Video/FPSCommon values as written by the OBS settings dialog
+struct common_fps {
+    const char *name;
+    uint32_t num;
+    uint32_t den;
+};
+
+static const struct common_fps common_fps_table[] = {
+    {"10", 10, 1},
+    {"20", 20, 1},
+    {"23.976", 24000, 1001},
+    {"24 NTSC", 24000, 1001},
+    {"24", 24, 1},
+    {"25 PAL", 25, 1},
+    {"25", 25, 1},
+    {"29.97", 30000, 1001},
+    {"30", 30, 1},
+    {"48", 48, 1},
+    {"50 PAL", 50, 1},
+    {"50", 50, 1},
+    {"59.94", 60000, 1001},
+    {"60", 60, 1},
+};
+
+// Video/FPSType
+enum fps_type {
+    FPS_TYPE_COMMON = 0,
+    FPS_TYPE_INTEGER = 1,
+    FPS_TYPE_FRACTION = 2,
+};
+
+// Get the default directory for the per-recording session logs
+static void get_default_session_dir(char *buffer, size_t size)
 {
-    const char *config_path = obs_module_config_path("");
+    const char *config_path = obs_module_config_path("sessions");
     if (config_path) {
-        snprintf(buffer, size, "%s/timestamps.jsonl", config_path);
+        snprintf(buffer, size, "%s", config_path);
         bfree((void *)config_path);
     } else {
-        snprintf(buffer, size, "timestamps.jsonl");
+        snprintf(buffer, size, "sessions");
     }
 }
 
@@ -34,23 +149,60 @@ static void ensure_config_directory_exists(void)
     }
 }
 
-// Get the recording output directory from OBS settings
-static void get_recording_output_dir(char *buffer, size_t size)
+// File the recording output is writing to, or "" if the frontend doesn't say
+static void get_recording_file_path(char *buffer, size_t size)
 {
-    config_t *config = obs_frontend_get_profile_config();
-    if (!config) {
-        blog(LOG_WARNING, "Timestamp Plugin: Could not get profile config");
-        buffer[0] = '\0';
+    buffer[0] = '\0';
+
+    obs_output_t *output = obs_frontend_get_recording_output();
+    if (!output) {
         return;
     }
 
+    obs_data_t *output_settings = obs_output_get_settings(output);
+    if (output_settings) {
+        // Standard outputs use "path", custom FFmpeg output uses "url"
+        const char *path = obs_data_get_string(output_settings, "path");
+        if (!path || !*path) {
+            path = obs_data_get_string(output_settings, "url");
+        }
+        if (path) {
+            snprintf(buffer, size, "%s", path);
+        }
+        obs_data_release(output_settings);
+    }
+    obs_output_release(output);
+}
+
+// Session logs are named after the recording file ("2024-05-01 20-15-00.mkv"
+// -> "2024-05-01 20-15-00.jsonl"), or after the start time if it is unknown
+static void get_session_name(const char *video_path, const struct tm *start, char *buffer, size_t size)
+{
+    const char *name = session_log_file_name(video_path);
+    size_t len = session_log_stem_length(video_path) - (size_t)(name - video_path);
+
+    if (len) {
+        snprintf(buffer, size, "%.*s", (int)len, name);
+    } else {
+        strftime(buffer, size, "%Y-%m-%d %H-%M-%S", start);
+    }
+}
+
+// Get the recording output directory from OBS settings
+static void get_recording_output_dir(config_t *config, char *buffer, size_t size)
+{
     // Check if using advanced output mode or simple mode
     const char *mode = config_get_string(config, "Output", "Mode");
     const char *rec_path = NULL;
 
     if (mode && strcmp(mode, "Advanced") == 0) {
-        // Advanced mode - check RecFilePath
-        rec_path = config_get_string(config, "AdvOut", "RecFilePath");
+        // Advanced mode - custom FFmpeg output has its own path
+        const char *rec_type = config_get_string(config, "AdvOut", "RecType");
+        if (rec_type && strcmp(rec_type, "FFmpeg") == 0) {
+            rec_path = config_get_string(config, "AdvOut", "FFFilePath");
+        } else {
+            rec_path = config_get_string(config, "AdvOut", "RecFilePath");
+        }
     } else {
         // Simple mode - check FilePath
         rec_path = config_get_string(config, "SimpleOutput", "FilePath");
@@ -58,13 +210,226 @@ static void get_recording_output_dir(char *buffer, size_t size)
 
     if (rec_path && *rec_path) {
         snprintf(buffer, size, "%s", rec_path);
-        blog(LOG_INFO, "Timestamp Plugin: Recording output directory: %s", buffer);
     } else {
         buffer[0] = '\0';
         blog(LOG_WARNING, "Timestamp Plugin: Could not determine recording output directory");
     }
 }
 
+// Get the configured FPS from the profile; only a fallback in case libobs
+// has no running video output to take the real cadence from
+static void get_profile_fps(config_t *config, uint32_t *fps_num, uint32_t *fps_den)
+{
+    *fps_num = 30;
+    *fps_den = 1;
+
+    switch ((enum fps_type)config_get_uint(config, "Video", "FPSType")) {
+    case FPS_TYPE_COMMON: {
+        const char *fps_common = config_get_string(config, "Video", "FPSCommon");
+        bool found = false;
+
+        for (size_t i = 0; fps_common && i < sizeof(common_fps_table) / sizeof(common_fps_table[0]); i++) {
+            if (strcmp(fps_common, common_fps_table[i].name) == 0) {
+                *fps_num = common_fps_table[i].num;
+                *fps_den = common_fps_table[i].den;
+                found = true;
+                break;
+            }
+        }
+
+        // OBS itself falls back to 30 for values it doesn't know
+        if (!found && fps_common && *fps_common) {
+            blog(LOG_WARNING, "Timestamp Plugin: Unknown common FPS '%s', assuming 30", fps_common);
+        }
+        break;
+    }
+    case FPS_TYPE_INTEGER: {
+        uint64_t fps = config_get_uint(config, "Video", "FPSInt");
+        if (fps > 0) {
+            *fps_num = (uint32_t)fps;
+        }
+        break;
+    }
+    case FPS_TYPE_FRACTION: {
+        uint64_t num = config_get_uint(config, "Video", "FPSNum");
+        uint64_t den = config_get_uint(config, "Video", "FPSDen");
+        if (num > 0 && den > 0) {
+            *fps_num = (uint32_t)num;
+            *fps_den = (uint32_t)den;
+        }
+        break;
+    }
+    }
+}
+
+// Read the session log durability policy from the profile config.
+// [TimestampMarker] FlushMode = count | interval | fsync
+//                   FlushMarkers = N (count mode), FlushIntervalMs = T (interval mode)
+static void load_flush_policy(config_t *config, struct marker_flush_policy *policy)
+{
+    policy->mode = MARKER_FLUSH_COUNT;
+    policy->every_markers = 1;
+    policy->interval_ms = 1000;
+
+    if (!config) {
+        return;
+    }
+
+    const char *mode = config_get_string(config, "TimestampMarker", "FlushMode");
+    if (mode && strcmp(mode, "interval") == 0) {
+        policy->mode = MARKER_FLUSH_INTERVAL;
+    } else if (mode && strcmp(mode, "fsync") == 0) {
+        policy->mode = MARKER_FLUSH_FSYNC;
+    }
+
+    uint64_t every = config_get_uint(config, "TimestampMarker", "FlushMarkers");
+    if (every > 0) {
+        policy->every_markers = (uint32_t)every;
+    }
+
+    uint64_t interval = config_get_uint(config, "TimestampMarker", "FlushIntervalMs");
+    if (interval > 0) {
+        policy->interval_ms = (uint32_t)interval;
+    }
+}
+
+// Which session log(s) to write, from [TimestampMarker] in the profile
+static void load_log_format(config_t *config, enum marker_log_format *log_format, bool *dump_jsonl)
+{
+    *log_format = MARKER_LOG_JSONL;
+    *dump_jsonl = true;
+
+    if (!config) {
+        return;
+    }
+
+    const char *format = config_get_string(config, "TimestampMarker", "LogFormat");
+    if (format && strcmp(format, "binary") == 0) {
+        *log_format = MARKER_LOG_BINARY;
+    } else if (format && strcmp(format, "both") == 0) {
+        *log_format = MARKER_LOG_BOTH;
+    }
+
+    if (config_has_user_value(config, "TimestampMarker", "JournalDumpJsonl")) {
+        *dump_jsonl = config_get_bool(config, "TimestampMarker", "JournalDumpJsonl");
+    }
+}
+
+// Scene-change markers, from [TimestampMarker] in the profile:
+// SceneMarkers = true | false, SceneMarkerColor = marker color,
+// SceneCoalesceMs = T (0 = every switch gets its own marker)
+static void load_scene_settings(config_t *config, struct plugin_settings *next)
+{
+    next->scene_markers = config_get_bool(config, "TimestampMarker", "SceneMarkers");
+
+    next->scene_coalesce_ms = DEFAULT_SCENE_COALESCE_MS;
+    if (config_has_user_value(config, "TimestampMarker", "SceneCoalesceMs")) {
+        next->scene_coalesce_ms = (uint32_t)config_get_uint(config, "TimestampMarker", "SceneCoalesceMs");
+    }
+
+    const char *color = config_get_string(config, "TimestampMarker", "SceneMarkerColor");
+    if (!color || !*color) {
+        color = "purple";
+    } else if (marker_color_from_name(color) == MARKER_COLOR_BLUE && astrcmpi(color, "blue") != 0) {
+        blog(LOG_WARNING, "Timestamp Plugin: Unknown SceneMarkerColor '%s', using purple", color);
+        color = "purple";
+    }
+    snprintf(next->scene_color, sizeof(next->scene_color), "%s", marker_color_name(marker_color_from_name(color)));
+}
+
+// Audio level markers, from [TimestampMarker] in the profile:
+// AudioTriggerSource = source name, or AudioTriggerTrack = 1-6 for a mix,
+// AudioTriggerDb, AudioTriggerHysteresisDb, AudioTriggerHoldMs,
+// AudioTriggerMeasure = rms | peak
+static void load_audio_trigger_settings(config_t *config, struct audio_trigger_settings *trigger)
+{
+    const char *source = config_get_string(config, "TimestampMarker", "AudioTriggerSource");
+    snprintf(trigger->source, sizeof(trigger->source), "%s", source ? source : "");
+    trigger->track = (uint32_t)config_get_uint(config, "TimestampMarker", "AudioTriggerTrack");
+
+    trigger->threshold_db = (float)DEFAULT_AUDIO_TRIGGER_DB;
+    if (config_has_user_value(config, "TimestampMarker", "AudioTriggerDb")) {
+        trigger->threshold_db = (float)config_get_double(config, "TimestampMarker", "AudioTriggerDb");
+    }
+
+    trigger->hysteresis_db = (float)DEFAULT_AUDIO_TRIGGER_HYSTERESIS_DB;
+    if (config_has_user_value(config, "TimestampMarker", "AudioTriggerHysteresisDb")) {
+        double hysteresis = config_get_double(config, "TimestampMarker", "AudioTriggerHysteresisDb");
+        trigger->hysteresis_db = hysteresis > 0.0 ? (float)hysteresis : 0.0f;
+    }
+
+    trigger->hold_ms = DEFAULT_AUDIO_TRIGGER_HOLD_MS;
+    if (config_has_user_value(config, "TimestampMarker", "AudioTriggerHoldMs")) {
+        trigger->hold_ms = (uint32_t)config_get_uint(config, "TimestampMarker", "AudioTriggerHoldMs");
+    }
+
+    const char *measure = config_get_string(config, "TimestampMarker", "AudioTriggerMeasure");
+    trigger->use_peak = measure && strcmp(measure, "peak") == 0;
+}
+
+// Picture change markers, from [TimestampMarker] in the profile:
+// VideoTrigger = true | false, VideoTriggerWidth, VideoTriggerFps,
+// VideoTriggerThreshold, VideoTriggerHoldMs
+static void load_video_trigger_settings(config_t *config, struct video_trigger_settings *trigger)
+{
+    trigger->enabled = config_get_bool(config, "TimestampMarker", "VideoTrigger");
+
+    uint64_t width = config_get_uint(config, "TimestampMarker", "VideoTriggerWidth");
+    trigger->width = width ? (uint32_t)width : DEFAULT_VIDEO_TRIGGER_WIDTH;
+
+    uint64_t fps = config_get_uint(config, "TimestampMarker", "VideoTriggerFps");
+    trigger->fps = fps ? (uint32_t)fps : DEFAULT_VIDEO_TRIGGER_FPS;
+
+    trigger->threshold = (float)DEFAULT_VIDEO_TRIGGER_THRESHOLD;
+    if (config_has_user_value(config, "TimestampMarker", "VideoTriggerThreshold")) {
+        trigger->threshold = (float)config_get_double(config, "TimestampMarker", "VideoTriggerThreshold");
+    }
+
+    trigger->hold_ms = DEFAULT_VIDEO_TRIGGER_HOLD_MS;
+    if (config_has_user_value(config, "TimestampMarker", "VideoTriggerHoldMs")) {
+        trigger->hold_ms = (uint32_t)config_get_uint(config, "TimestampMarker", "VideoTriggerHoldMs");
+    }
+}
+
+// Re-read everything recording start needs from the active profile
+static void refresh_settings(void)
+{
+    config_t *config = obs_frontend_get_profile_config();
+    if (!config) {
+        blog(LOG_WARNING, "Timestamp Plugin: Could not get profile config");
+        return;
+    }
+
+    struct plugin_settings next = {0};
+    get_recording_output_dir(config, next.recording_dir, sizeof(next.recording_dir));
+    get_profile_fps(config, &next.fps_num, &next.fps_den);
+    load_flush_policy(config, &next.flush);
+    load_log_format(config, &next.log_format, &next.dump_jsonl);
+    next.live_xml = config_get_bool(config, "TimestampMarker", "LiveXml");
+    next.chapters = config_get_bool(config, "TimestampMarker", "Chapters");
+    next.coalesce_ms = (uint32_t)config_get_uint(config, "TimestampMarker", "CoalesceMs");
+    next.repeat_ms = (uint32_t)config_get_uint(config, "TimestampMarker", "RepeatIntervalMs");
+
+    // Markers asked for while paused: queue (land where the recording
+    // resumes, the default) or reject
+    const char *paused = config_get_string(config, "TimestampMarker", "PausedMarkers");
+    next.reject_paused = paused && strcmp(paused, "reject") == 0;
+
+    const char *broadcast = config_get_string(config, "TimestampMarker", "BroadcastAddress");
+    snprintf(next.broadcast_address, sizeof(next.broadcast_address), "%s", broadcast ? broadcast : "");
+    next.export_formats =
+        marker_export_parse_formats(config_get_string(config, "TimestampMarker", "ExportFormats"));
+    load_scene_settings(config, &next);
+    load_audio_trigger_settings(config, &next.audio_trigger);
+    load_video_trigger_settings(config, &next.video_trigger);
+    next.loaded = true;
+
+    settings = next;
+
+    blog(LOG_INFO, "Timestamp Plugin: Profile settings loaded (recording directory: %s, %u/%u fps)",
+         settings.recording_dir[0] ? settings.recording_dir : "(unknown)", settings.fps_num, settings.fps_den);
+}
+
 // Load hotkey data from OBS global config
 void load_hotkey_data(void)
 {
@@ -140,31 +505,261 @@ void save_hotkey_data(void)
     blog(LOG_INFO, "Timestamp Plugin: Hotkey data saved");
 }
 
-// Save a timestamp to the output file in JSON Lines format
+// Copy the session state without waiting. Fails if no recording is running or
+// if it started or stopped during the copy; the caller drops its marker then
+// rather than retrying, since it was taken on the edge of two sessions.
+static bool read_session_state(struct session_state *state, long *generation)
+{
+    long seq = os_atomic_load_long(&session_seq);
+    if (seq & 1) {
+        return false;
+    }
+
+    *state = session_state;
+
+    // Full barrier, and only succeeds if no update began meanwhile
+    if (!os_atomic_compare_exchange_long(&session_seq, &seq, seq)) {
+        return false;
+    }
+
+    *generation = state->generation;
+    return state->active;
+}
+
+// UI thread only; returns the sequence number the new state is published under
+static long publish_session_state(const struct session_state *state)
+{
+    os_atomic_inc_long(&session_seq);
+    session_state = *state;
+    return os_atomic_inc_long(&session_seq);
+}
+
+// Whether markers asked for now are refused because the recording is paused
+// and PausedMarkers=reject. Queued ones need nothing: the clock maps every
+// time in a pause to the point the recording resumes from.
+static bool refuse_paused(const struct session_state *state)
+{
+    return state->reject_paused && recording_clock_paused(&state->clock);
+}
+
+// Fill in a marker taken timestamp_ns into the recording
+static void fill_marker(struct marker_record *record, const struct session_state *state, long generation,
+                        uint64_t timestamp_ns, const char *comment, const char *name, const char *color,
+                        enum marker_burst burst)
+{
+    record->type = MARKER_RECORD_MARKER;
+    record->data = NULL;
+    record->generation = generation;
+    record->burst = burst;
+    record->count = 1;
+    record->timestamp_ns = timestamp_ns;
+    record->timestamp_ms = timestamp_ns / 1000000;
+    record->frame = recording_clock_frame(&state->clock, timestamp_ns);
+    snprintf(record->comment, sizeof(record->comment), "%s", comment ? comment : "");
+    snprintf(record->name, sizeof(record->name), "%s", name ? name : "");
+    snprintf(record->color, sizeof(record->color), "%s", color ? color : "blue");
+}
+
+// Queue a marker taken timestamp_ns into the recording for the writer thread.
+// requested_ns is when the marker was asked for, for the latency stats.
+static void queue_marker(const struct session_state *state, long generation, uint64_t requested_ns,
+                         uint64_t timestamp_ns, const char *comment, const char *name, const char *color,
+                         enum marker_burst burst)
+{
+    struct marker_record record;
+    fill_marker(&record, state, generation, timestamp_ns, comment, name, color, burst);
+
+    // A full queue is counted by the writer and reported in the log
+    record.queued_ns = os_gettime_ns();
+    if (marker_writer_push(&record)) {
+        marker_stats_record(MARKER_STAT_HOTKEY_TO_ENQUEUE, os_gettime_ns() - requested_ns);
+    }
+}
+
+// Queue a timestamp for the writer thread, which appends it to the output
+// file in JSON Lines format. Never touches the disk on the calling thread.
 void save_timestamp(uint64_t timestamp_ms, const char *comment, const char *name, const char *color)
 {
-    if (!output_path[0]) {
-        blog(LOG_ERROR, "Timestamp Plugin: Output path not set");
+    uint64_t requested_ns = os_gettime_ns();
+    struct session_state state;
+    long generation;
+
+    if (!read_session_state(&state, &generation)) {
+        blog(LOG_WARNING, "Timestamp Plugin: Marker at %" PRIu64 "ms ignored, not recording", timestamp_ms);
         return;
     }
 
-    FILE *file = fopen(output_path, "a");
-    if (!file) {
-        blog(LOG_ERROR, "Timestamp Plugin: Failed to open output file: %s", output_path);
+    queue_marker(&state, generation, requested_ns, timestamp_ms * 1000000, comment, name, color, MARKER_BURST_NONE);
+}
+
+size_t save_timestamps(const struct timestamp_request *requests, size_t count)
+{
+    uint64_t requested_ns = os_gettime_ns();
+    struct session_state state;
+    long generation;
+
+    if (!count) {
+        return 0;
+    }
+    if (!read_session_state(&state, &generation)) {
+        blog(LOG_WARNING, "Timestamp Plugin: %zu marker(s) ignored, not recording", count);
+        return 0;
+    }
+
+    // The whole batch shares one clock reading and one claim on the queue
+    uint64_t now_ns = recording_clock_elapsed_ns(&state.clock, requested_ns);
+    struct marker_record *records = bmalloc(sizeof(*records) * count);
+    bool refuse = refuse_paused(&state);
+    size_t queued = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const struct timestamp_request *request = &requests[i];
+
+        // Markers at a given time don't depend on when they were sent
+        if (refuse && !request->has_timestamp) {
+            marker_stats_count(MARKER_COUNTER_PAUSED);
+            continue;
+        }
+
+        uint64_t timestamp_ns = now_ns;
+        if (request->has_timestamp) {
+            timestamp_ns = request->timestamp_ms * 1000000ULL;
+        } else if (request->offset_ms < 0) {
+            uint64_t back_ns = (uint64_t)(-request->offset_ms) * 1000000ULL;
+            timestamp_ns = back_ns < now_ns ? now_ns - back_ns : 0;
+        } else {
+            timestamp_ns += (uint64_t)request->offset_ms * 1000000ULL;
+        }
+
+        char comment[MARKER_COMMENT_SIZE];
+        if (request->comment && *request->comment) {
+            snprintf(comment, sizeof(comment), "%s", request->comment);
+        } else {
+            snprintf(comment, sizeof(comment), "Marker %ld", os_atomic_inc_long(&marker_counter));
+        }
+
+        struct marker_record *record = &records[queued++];
+        fill_marker(record, &state, generation, timestamp_ns, comment, request->name,
+                    marker_color_name(marker_color_from_name(request->color)), MARKER_BURST_NONE);
+        record->queued_ns = requested_ns;
+    }
+
+    size_t pushed = queued ? marker_writer_push_batch(records, queued) : 0;
+    bfree(records);
+
+    if (queued < count) {
+        blog(LOG_WARNING, "Timestamp Plugin: %zu marker(s) ignored, recording is paused", count - queued);
+    }
+    if (pushed < queued) {
+        blog(LOG_WARNING, "Timestamp Plugin: Marker queue full, %zu of %zu marker(s) dropped", queued - pushed,
+             queued);
+    }
+    for (size_t i = 0; i < pushed; i++) {
+        marker_stats_count(MARKER_COUNTER_API);
+    }
+    marker_stats_record(MARKER_STAT_API_BATCH, os_gettime_ns() - requested_ns);
+    return pushed;
+}
+
+// Mark a switch to another scene, named after the scene now in program. It
+// takes the hotkey's path: queued here, written by the writer thread, which
+// also folds rapid switches into one marker.
+static void queue_scene_marker(const struct session_state *state, uint64_t event_ns)
+{
+    obs_source_t *scene = obs_frontend_get_current_scene();
+    if (!scene) {
         return;
     }
 
-    // Write JSON line
-    fprintf(file, "{\"timestamp_ms\": %" PRIu64 ", \"comment\": \"%s\", \"name\": \"%s\", \"color\": \"%s\"}\n",
-            timestamp_ms,
-            comment ? comment : "",
-            name ? name : "",
-            color ? color : "blue");
+    const char *name = obs_source_get_name(scene);
+    uint64_t timestamp_ns = recording_clock_elapsed_ns(&state->clock, event_ns);
+    queue_marker(state, state->generation, event_ns, timestamp_ns, "Scene change", name,
+                 scene_color, MARKER_BURST_SCENE);
 
-    fclose(file);
+    obs_source_release(scene);
+}
+
+// Audio thread: the detector's level crossed its threshold. Block timestamps
+// are on the os_gettime_ns() clock, like hotkey presses, and nothing here
+// waits: a recording stopping meanwhile only drops the marker.
+static void audio_trigger_marker(void *param, const char *label, uint64_t timestamp_ns, float level_db)
+{
+    UNUSED_PARAMETER(param);
+
+    uint64_t requested_ns = os_gettime_ns();
+    struct session_state state;
+    long generation;
+
+    // Nothing heard while paused is in the file
+    if (!read_session_state(&state, &generation) || recording_clock_paused(&state.clock)) {
+        return;
+    }
+
+    char comment[128];
+    snprintf(comment, sizeof(comment), "Audio %s %.1f dB", label, level_db);
+    queue_marker(&state, generation, requested_ns, recording_clock_elapsed_ns(&state.clock, timestamp_ns), comment,
+                 "", "yellow", MARKER_BURST_NONE);
+}
+
+// Video trigger thread: the picture changed by more than the threshold
+static void video_trigger_marker(void *param, uint64_t timestamp_ns, float score)
+{
+    UNUSED_PARAMETER(param);
+
+    uint64_t requested_ns = os_gettime_ns();
+    struct session_state state;
+    long generation;
+
+    if (!read_session_state(&state, &generation) || recording_clock_paused(&state.clock)) {
+        return;
+    }
 
-    blog(LOG_INFO, "Timestamp Plugin: Saved marker at %" PRIu64 "ms: %s",
-         timestamp_ms, comment ? comment : "(no comment)");
+    char comment[128];
+    snprintf(comment, sizeof(comment), "Picture change %.1f", score);
+    queue_marker(&state, generation, requested_ns, recording_clock_elapsed_ns(&state.clock, timestamp_ns), comment,
+                 "", "orange", MARKER_BURST_NONE);
+}
+
+// Output thread: the recording output closed its file and continues in
+// next_file. The signal comes as the new file opens, which is as close to
+// its first frame as the plugin gets to see.
+static void recording_file_changed(void *param, calldata_t *data)
+{
+    UNUSED_PARAMETER(param);
+
+    uint64_t event_ns = os_gettime_ns();
+    struct session_state state;
+    long generation;
+
+    if (!read_session_state(&state, &generation)) {
+        return;
+    }
+
+    const char *next_file = calldata_string(data, "next_file");
+    blog(LOG_INFO, "Timestamp Plugin: Recording split, continuing in %s", next_file ? next_file : "(unknown)");
+    marker_writer_split_session(generation, recording_clock_elapsed_ns(&state.clock, event_ns), next_file);
+}
+
+// Follow the recording output's file splits (automatic or by hotkey) so the
+// session log rotates with the files
+static void connect_file_splits(void)
+{
+    split_output = obs_frontend_get_recording_output();
+    if (split_output) {
+        signal_handler_connect(obs_output_get_signal_handler(split_output), "file_changed", recording_file_changed,
+                               NULL);
+    }
+}
+
+// Returns once no split callback is running
+static void disconnect_file_splits(void)
+{
+    if (split_output) {
+        signal_handler_disconnect(obs_output_get_signal_handler(split_output), "file_changed",
+                                  recording_file_changed, NULL);
+        obs_output_release(split_output);
+        split_output = NULL;
+    }
 }
 
 // Hotkey callback - called when user presses the timestamp hotkey
@@ -174,23 +769,81 @@ void timestamp_hotkey_callback(void *data, obs_hotkey_id id, obs_hotkey_t *hotke
     UNUSED_PARAMETER(id);
     UNUSED_PARAMETER(hotkey);
 
-    if (!pressed || !recording_active) {
+    if (!pressed) {
         return;
     }
 
-    // Calculate elapsed time since recording started
-    uint64_t current_time = os_gettime_ns() / 1000000; // Convert to milliseconds
-    uint64_t timestamp_ms = current_time - recording_start_time;
+    uint64_t pressed_ns = os_gettime_ns();
+    struct session_state state;
+    long generation;
+
+    if (!read_session_state(&state, &generation)) {
+        return;
+    }
+    if (refuse_paused(&state)) {
+        marker_stats_count(MARKER_COUNTER_PAUSED);
+        blog(LOG_INFO, "Timestamp Plugin: Marker ignored, recording is paused");
+        return;
+    }
+
+    // Position on the recording timeline, in nanoseconds since the first
+    // frame; a press during a pause lands where the recording resumes
+    uint64_t timestamp_ns = recording_clock_elapsed_ns(&state.clock, pressed_ns);
+
+    // Rapid taps become one marker: a press within the window of the previous
+    // one only adds to its count, and the window slides with every press
+    bool merge = false;
+    if (state.coalesce_ms) {
+        merge = generation == burst_generation &&
+                pressed_ns - burst_press_ns < (uint64_t)state.coalesce_ms * 1000000ULL;
+        burst_press_ns = pressed_ns;
+        burst_generation = generation;
+    }
 
-    // Create a default comment with marker number
-    marker_counter++;
+    // Create a default comment with marker number. A merged press keeps the
+    // burst's, in case it reaches the writer after the burst was written.
+    long number = merge ? burst_number : os_atomic_inc_long(&marker_counter);
     char comment[128];
-    snprintf(comment, sizeof(comment), "Marker %llu",
-             (unsigned long long)marker_counter);
+    snprintf(comment, sizeof(comment), "Marker %ld", number);
+
+    if (merge) {
+        queue_marker(&state, generation, pressed_ns, timestamp_ns, comment, "", "blue", MARKER_BURST_MERGE);
+        return;
+    }
+    if (state.coalesce_ms) {
+        burst_number = number;
+    }
 
     // Save timestamp with default values
     // TODO: In the future, we can add a dialog to let users input custom comments
-    save_timestamp(timestamp_ms, comment, "", "blue");
+    queue_marker(&state, generation, pressed_ns, timestamp_ns, comment, "", "blue",
+                 state.coalesce_ms ? MARKER_BURST_START : MARKER_BURST_NONE);
+}
+
+// Stop or continue the recording timeline. The offset changes only here, so
+// every marker is still mapped with one subtraction; the writer gets the
+// same clock for its repeat markers and drift samples.
+static void set_recording_paused(bool paused, uint64_t event_ns)
+{
+    // Only this thread publishes the state, so it can read it directly
+    struct session_state next = session_state;
+    if (!next.active || recording_clock_paused(&next.clock) == paused) {
+        return;
+    }
+
+    if (paused) {
+        recording_clock_pause(&next.clock, event_ns);
+        blog(LOG_INFO, "Timestamp Plugin: Recording paused at %" PRIu64 "ms",
+             recording_clock_elapsed_ns(&next.clock, event_ns) / 1000000);
+    } else {
+        uint64_t paused_ns = next.clock.paused_ns;
+        recording_clock_resume(&next.clock, event_ns);
+        blog(LOG_INFO, "Timestamp Plugin: Recording resumed after %" PRIu64 "ms, %" PRIu64 "ms paused in total",
+             (next.clock.paused_ns - paused_ns) / 1000000, next.clock.paused_ns / 1000000);
+    }
+
+    publish_session_state(&next);
+    marker_writer_pause_session(next.generation, &next.clock);
 }
 
 // Frontend event callback - handles recording start/stop events
@@ -198,128 +851,162 @@ static void frontend_event_callback(enum obs_frontend_event event, void *data)
 {
     UNUSED_PARAMETER(data);
 
+    uint64_t event_ns = os_gettime_ns();
+
     switch (event) {
-    case OBS_FRONTEND_EVENT_RECORDING_STARTED:
-        recording_active = true;
-        recording_start_time = os_gettime_ns() / 1000000; // Milliseconds
-        marker_counter = 0;
-
-        // Get the recording output directory
-        get_recording_output_dir(recording_output_dir, sizeof(recording_output_dir));
-
-        blog(LOG_INFO, "Timestamp Plugin: Recording started, clearing timestamp file");
-
-        // Clear/create new timestamp file for this recording session
-        if (output_path[0]) {
-            FILE *file = fopen(output_path, "w");
-            if (file) {
-                // Get FPS from OBS config
-                config_t *config = obs_frontend_get_profile_config();
-                uint32_t fps_num = 60;
-                uint32_t fps_den = 1;
-
-                if (config) {
-                    // Read FPS type and value from config
-                    const char *fps_type = config_get_string(config, "Video", "FPSType");
-
-                    if (fps_type && strcmp(fps_type, "2") == 0) {
-                        // Common FPS (FPSCommon setting)
-                        const char *fps_common = config_get_string(config, "Video", "FPSCommon");
-                        if (fps_common) {
-                            if (strcmp(fps_common, "60") == 0) {
-                                fps_num = 60; fps_den = 1;
-                            } else if (strcmp(fps_common, "59.94") == 0) {
-                                fps_num = 60000; fps_den = 1001;
-                            } else if (strcmp(fps_common, "30") == 0) {
-                                fps_num = 30; fps_den = 1;
-                            } else if (strcmp(fps_common, "29.97") == 0) {
-                                fps_num = 30000; fps_den = 1001;
-                            } else if (strcmp(fps_common, "25") == 0) {
-                                fps_num = 25; fps_den = 1;
-                            } else if (strcmp(fps_common, "24") == 0) {
-                                fps_num = 24; fps_den = 1;
-                            } else if (strcmp(fps_common, "23.976") == 0) {
-                                fps_num = 24000; fps_den = 1001;
-                            }
-                        }
-                    } else {
-                        // Fractional FPS (FPSNum/FPSDen)
-                        fps_num = (uint32_t)config_get_uint(config, "Video", "FPSNum");
-                        fps_den = (uint32_t)config_get_uint(config, "Video", "FPSDen");
-                        if (fps_den == 0) fps_den = 1; // Prevent division by zero
-                    }
-                }
-
-                // Get current timestamp for metadata
-                time_t now = time(NULL);
-                char time_str[64];
-                struct tm *tm_info = localtime(&now);
-                strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
-
-                // Write metadata header
-                fprintf(file, "{\"metadata\": {\"recording_path\": \"%s\", \"timestamp\": \"%s\", \"fps_num\": %u, \"fps_den\": %u}}\n",
-                        recording_output_dir[0] ? recording_output_dir : "",
-                        time_str,
-                        fps_num,
-                        fps_den);
-
-                // Add initial marker at 0
-                fprintf(file, "{\"timestamp_ms\": 0, \"comment\": \"Recording Start\", \"name\": \"\", \"color\": \"blue\"}\n");
-                fclose(file);
+    case OBS_FRONTEND_EVENT_RECORDING_STARTED: {
+        // Normally resolved at load/profile change already
+        if (!settings.loaded) {
+            refresh_settings();
+        }
+
+        // Anchor marker times to the first recorded frame
+        struct session_state next = {0};
+        next.active = true;
+        next.coalesce_ms = settings.coalesce_ms;
+        next.reject_paused = settings.reject_paused;
+        recording_clock_start(&next.clock, settings.fps_num, settings.fps_den);
+
+        // Only this thread changes session_seq, so the generation is known
+        // before publishing; the session opens ahead of its first marker
+        long generation = os_atomic_load_long(&session_seq) + 2;
+        next.generation = generation;
+
+        // Every recording gets its own session log, so an export of the last
+        // one never reads a file the next recording is writing
+        if (session_dir[0]) {
+            struct marker_session_info *info = bzalloc(sizeof(*info));
+            snprintf(info->recording_path, sizeof(info->recording_path), "%s", settings.recording_dir);
+            get_recording_file_path(info->video_path, sizeof(info->video_path));
+
+            info->generation = generation;
+            info->fps_num = next.clock.fps_num;
+            info->fps_den = next.clock.fps_den;
+            info->flush = settings.flush;
+            info->log_format = settings.log_format;
+            info->dump_jsonl = settings.dump_jsonl;
+            info->live_xml = settings.live_xml;
+            info->chapters = settings.chapters;
+            info->clock = next.clock;
+            info->coalesce_ms = settings.coalesce_ms;
+            info->scene_coalesce_ms = settings.scene_coalesce_ms;
+            info->repeat_ms = settings.repeat_ms;
+            snprintf(info->broadcast_address, sizeof(info->broadcast_address), "%s", settings.broadcast_address);
+            info->export_formats = settings.export_formats;
+
+            // Output resolution for the exported sequence
+            struct obs_video_info ovi;
+            if (obs_get_video_info(&ovi)) {
+                info->width = ovi.output_width;
+                info->height = ovi.output_height;
+            }
+
+            // Get current timestamp for metadata
+            time_t now = time(NULL);
+            info->start_epoch = (int64_t)now;
+            struct tm *tm_info = localtime(&now);
+            strftime(info->start_time, sizeof(info->start_time), "%Y-%m-%d %H:%M:%S", tm_info);
+
+            char name[256];
+            get_session_name(info->video_path, tm_info, name, sizeof(name));
+            int length = snprintf(info->path, sizeof(info->path), "%s/%s.jsonl", session_dir, name);
+
+            // A cut-off name would leave the log without its extension and
+            // the manifest, journal and index pointing elsewhere
+            if (length < 0 || (size_t)length >= sizeof(info->path)) {
+                blog(LOG_ERROR, "Timestamp Plugin: Session log path too long, recording not logged: %s/%s.jsonl",
+                     session_dir, name);
+                bfree(info);
             } else {
-                blog(LOG_ERROR, "Timestamp Plugin: Failed to create output file: %s", output_path);
+                blog(LOG_INFO, "Timestamp Plugin: Recording started, session log: %s", info->path);
+
+                // The writer thread creates the file and keeps it open until stop
+                marker_writer_begin_session(info);
             }
         }
+
+        scene_markers = settings.scene_markers && session_dir[0];
+        snprintf(scene_color, sizeof(scene_color), "%s", settings.scene_color);
+
+        // From here on the hotkey thread sees the new recording
+        os_atomic_set_long(&marker_counter, 0);
+        publish_session_state(&next);
+
+        // Listens from the first block after the session is published
+        if (session_dir[0] && audio_trigger_enabled(&settings.audio_trigger)) {
+            audio_trigger = audio_trigger_create(&settings.audio_trigger, audio_trigger_marker, NULL);
+        }
+        if (session_dir[0] && settings.video_trigger.enabled) {
+            video_trigger = video_trigger_create(&settings.video_trigger, video_trigger_marker, NULL);
+        }
+        if (session_dir[0]) {
+            connect_file_splits();
+        }
+
+        marker_stats_record(MARKER_STAT_RECORDING_START, os_gettime_ns() - event_ns);
         break;
+    }
+
+    case OBS_FRONTEND_EVENT_RECORDING_STOPPED: {
+        // This thread is the only writer, so it can read the state directly
+        struct session_state current = session_state;
+
+        if (current.active) {
+            // Nothing from the detectors or a split lands after the end marker
+            audio_trigger_destroy(audio_trigger);
+            audio_trigger = NULL;
+            video_trigger_destroy(video_trigger);
+            video_trigger = NULL;
+            disconnect_file_splits();
 
-    case OBS_FRONTEND_EVENT_RECORDING_STOPPED:
-        if (recording_active) {
             // Add final marker
-            uint64_t current_time = os_gettime_ns() / 1000000;
-            uint64_t timestamp_ms = current_time - recording_start_time;
-            save_timestamp(timestamp_ms, "Recording End", "", "green");
-
-            blog(LOG_INFO, "Timestamp Plugin: Recording stopped, final timestamp: %" PRIu64 "ms", timestamp_ms);
-
-            // Auto-convert to XML if user created markers (marker_counter > 0)
-            if (marker_counter > 0) {
-                blog(LOG_INFO, "Timestamp Plugin: %llu marker(s) created, running Python converter...",
-                     (unsigned long long)marker_counter);
-
-                // Get the plugin's data directory where the Python script should be
-                const char *plugin_data_path = obs_get_module_data_path(obs_current_module());
-                if (plugin_data_path) {
-                    char python_script[1024];
-                    char command[2048];
-
-                    snprintf(python_script, sizeof(python_script), "%s/timestamp_to_premiere.py", plugin_data_path);
-
-                    // Build command to run Python script
-                    // On Windows, use python or python3
-                    snprintf(command, sizeof(command), "python \"%s\" \"%s\"", python_script, output_path);
-
-                    blog(LOG_INFO, "Timestamp Plugin: Executing: %s", command);
-
-                    // Execute the Python script
-                    int result = system(command);
-
-                    if (result == 0) {
-                        blog(LOG_INFO, "Timestamp Plugin: XML markers generated successfully");
-                    } else {
-                        blog(LOG_WARNING, "Timestamp Plugin: Python converter failed with code %d", result);
-                        blog(LOG_WARNING, "Timestamp Plugin: You can manually run: python \"%s\" \"%s\"",
-                             python_script, output_path);
-                    }
-
-                    bfree((void *)plugin_data_path);
-                } else {
-                    blog(LOG_ERROR, "Timestamp Plugin: Could not get plugin data path");
-                }
-            } else {
-                blog(LOG_INFO, "Timestamp Plugin: No markers created, skipping XML conversion");
-            }
+            uint64_t timestamp_ns = recording_clock_elapsed_ns(&current.clock, event_ns);
+            queue_marker(&current, current.generation, event_ns, timestamp_ns, "Recording End", "",
+                         "green", MARKER_BURST_NONE);
+
+            blog(LOG_INFO, "Timestamp Plugin: Recording stopped, final timestamp: %" PRIu64 "ms (frame %" PRIu64 ")",
+                 timestamp_ns / 1000000, recording_clock_frame(&current.clock, timestamp_ns));
+
+            // New markers are refused from now on; a hotkey press racing
+            // this still carries the old generation and is rejected later
+            struct session_state stopped = {0};
+            publish_session_state(&stopped);
+
+            // The file name is final now (the output may have split or
+            // changed it since start), so record the real one
+            char *video_path = obs_frontend_get_last_recording();
+
+            // Close the session log; the writer thread exports the XML from the
+            // markers it collected, so nothing here waits on the disk
+            marker_writer_end_session(video_path);
+            bfree(video_path);
+            marker_stats_record(MARKER_STAT_RECORDING_STOP, os_gettime_ns() - event_ns);
+        }
+
+        // There is no event for edits in the settings dialog; re-read while
+        // nothing is time-critical so they apply from the next recording
+        refresh_settings();
+        break;
+    }
+
+    case OBS_FRONTEND_EVENT_RECORDING_PAUSED:
+    case OBS_FRONTEND_EVENT_RECORDING_UNPAUSED:
+        set_recording_paused(event == OBS_FRONTEND_EVENT_RECORDING_PAUSED, event_ns);
+        break;
+
+    case OBS_FRONTEND_EVENT_SCENE_CHANGED: {
+        // Only this thread publishes the state, so it can read it directly
+        struct session_state current = session_state;
+        if (current.active && scene_markers) {
+            queue_scene_marker(&current, event_ns);
         }
-        recording_active = false;
+        break;
+    }
+
+    case OBS_FRONTEND_EVENT_FINISHED_LOADING:
+    case OBS_FRONTEND_EVENT_PROFILE_CHANGED:
+    case OBS_FRONTEND_EVENT_PROFILE_LIST_CHANGED:
+        refresh_settings();
         break;
 
     default:
@@ -333,9 +1020,17 @@ void init_timestamp_plugin(void)
     // Ensure the config directory exists
     ensure_config_directory_exists();
 
-    // Set default output path
-    get_default_output_path(output_path, sizeof(output_path));
-    blog(LOG_INFO, "Timestamp Plugin: Using output file: %s", output_path);
+    // Set default session directory
+    get_default_session_dir(session_dir, sizeof(session_dir));
+    os_mkdirs(session_dir);
+    blog(LOG_INFO, "Timestamp Plugin: Writing session logs to: %s", session_dir);
+
+    // Start the background workers before any marker can be created
+    job_queue_start();
+    marker_writer_start();
+
+    // A recording the last run never stopped is closed and exported first
+    marker_writer_recover(session_dir);
 
     // Register hotkey - OBS automatically handles save/load for frontend hotkeys
     timestamp_hotkey_id = obs_hotkey_register_frontend(
@@ -353,6 +1048,9 @@ void init_timestamp_plugin(void)
 
     // Register frontend event callbacks
     obs_frontend_add_event_callback(frontend_event_callback, NULL);
+
+    // Markers from scripts and other plugins
+    marker_api_register_procs();
 }
 
 // Clean up plugin resources
@@ -367,20 +1065,33 @@ void free_timestamp_plugin(void)
     // Remove frontend event callback
     obs_frontend_remove_event_callback(frontend_event_callback, NULL);
 
+    // Unloaded mid-recording: stop listening before the writer goes away
+    audio_trigger_destroy(audio_trigger);
+    audio_trigger = NULL;
+    video_trigger_destroy(video_trigger);
+    video_trigger = NULL;
+    disconnect_file_splits();
+
+    // Write out pending markers and join the writer thread, then let any
+    // queued exports (including one the writer just queued) finish
+    marker_writer_stop();
+    job_queue_stop();
+
     blog(LOG_INFO, "Timestamp Plugin: Cleaned up");
 }
 
-// Get current output path
+// Get current session directory
 const char *get_output_path(void)
 {
-    return output_path;
+    return session_dir;
 }
 
-// Set output path
+// Set session directory, used from the next recording on
 void set_output_path(const char *path)
 {
     if (path && *path) {
-        snprintf(output_path, sizeof(output_path), "%s", path);
-        blog(LOG_INFO, "Timestamp Plugin: Output path set to: %s", output_path);
+        snprintf(session_dir, sizeof(session_dir), "%s", path);
+        os_mkdirs(session_dir);
+        blog(LOG_INFO, "Timestamp Plugin: Session directory set to: %s", session_dir);
     }
 }
@@ -2,6 +2,7 @@
 
 #include <obs-module.h>
 #include <obs-frontend-api.h>
+#include "marker-queue.h"
 #include <util/platform.h>
 #include <util/config-file.h>
 #include <stdio.h>
@@ -30,7 +31,43 @@ void recording_stopped_callback(enum obs_frontend_event event, void *data);
 // Timestamp saving
 void save_timestamp(uint64_t timestamp_ms, const char *comment, const char *name, const char *color);
 
-// Configuration
+// One marker of a batch for save_timestamps
+struct timestamp_request {
+    bool has_timestamp;    // at timestamp_ms on the recording timeline...
+    uint64_t timestamp_ms;
+    int64_t offset_ms;     // ...or offset_ms from now (negative = in the past)
+    const char *comment;   // NULL or "" = "Marker N", numbered like hotkey markers
+    const char *name;
+    const char *color;     // unknown names become blue
+};
+
+// Queue the markers in order with one push through the writer queue, from any
+// thread; returns how many were queued (0 when not recording)
+size_t save_timestamps(const struct timestamp_request *requests, size_t count);
+
+// Markers of the recording in progress, in timestamp order. They are kept in
+// memory by the writer thread, so these calls do no file I/O and are safe from
+// any thread. Markers still in the queue are not visible yet; everything is
+// released when recording stops. When the output splits the recording into
+// several files, they are the markers of the file being written, timed from
+// its start.
+size_t timestamp_marker_count(void);
+bool timestamp_marker_get(size_t index, struct marker_record *marker);
+
+// Markers with start_ms <= timestamp_ms < end_ms are indices [*first, *first + count)
+size_t timestamp_marker_range(uint64_t start_ms, uint64_t end_ms, size_t *first);
+
+// Copy up to max markers with start_ms <= timestamp_ms < end_ms in one go, so
+// none can be added in between; returns how many were copied
+size_t timestamp_marker_copy(uint64_t start_ms, uint64_t end_ms, struct marker_record *markers, size_t max);
+
+// Index of the file being written among the recording's file splits (0 for
+// the first) and, if start_ms is given, where it starts on the recording
+// timeline; 0 when not recording
+uint32_t timestamp_marker_segment(uint64_t *start_ms);
+
+// Configuration: directory the per-recording session logs and their
+// sessions.manifest index are written to
 const char *get_output_path(void);
 void set_output_path(const char *path);
 
@@ -0,0 +1,271 @@
+#include "video-trigger.h"
+#include "marker-stats.h"
+#include <util/platform.h>
+#include <util/threading.h>
+#include <util/util_uint64.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VIDEO_TRIGGER_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VIDEO_TRIGGER_NEON
+#endif
+
+// libobs 30 skips frames before converting them (frame_rate_divisor); with
+// older versions every frame is converted and the callback skips instead
+#if LIBOBS_API_VER >= MAKE_SEMANTIC_VERSION(30, 0, 0)
+#define VIDEO_TRIGGER_DIVISOR_API
+#endif
+
+// Frames the video thread can hand over before the worker has caught up; a
+// frame arriving with all of them in use is skipped
+#define VIDEO_TRIGGER_POOL_SIZE 4
+
+// Bounds for the analysis width
+#define VIDEO_TRIGGER_MIN_WIDTH 16
+#define VIDEO_TRIGGER_MAX_WIDTH 640
+
+struct video_trigger {
+    struct video_scale_info scale;
+    uint32_t divisor;
+    size_t frame_size;
+    float threshold;
+    uint64_t hold_ns;
+
+    video_trigger_callback callback;
+    void *param;
+
+    // Single producer (the video thread) and single consumer (the worker):
+    // slot head % size is filled next, slot tail % size is compared next
+    uint8_t *pool[VIDEO_TRIGGER_POOL_SIZE];
+    uint64_t pool_timestamp[VIDEO_TRIGGER_POOL_SIZE];
+    volatile long head;
+    volatile long tail;
+    uint64_t skipped;  // video thread only
+    uint64_t received; // video thread only
+
+    os_event_t *event;
+    pthread_t thread;
+    volatile bool running;
+
+    // Worker only
+    uint8_t *previous;
+    bool has_previous;
+    uint64_t last_marker_ns;
+    uint64_t frames;
+    uint64_t markers;
+    uint64_t total_ns;
+    uint64_t max_ns;
+};
+
+uint64_t video_trigger_sad(const uint8_t *a, const uint8_t *b, size_t count)
+{
+    uint64_t sum = 0;
+    size_t i = 0;
+
+#if defined(VIDEO_TRIGGER_SSE2)
+    // psadbw: 16 absolute differences summed into two 64-bit lanes per step
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(x, y));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    sum = lanes[0] + lanes[1];
+#elif defined(VIDEO_TRIGGER_NEON)
+    // Widened pairwise twice, so the lanes can't overflow
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        acc = vpadalq_u16(acc, vpaddlq_u8(diff));
+    }
+    sum = vaddlvq_u32(acc);
+#endif
+
+    for (; i < count; i++) {
+        sum += a[i] > b[i] ? (uint64_t)(a[i] - b[i]) : (uint64_t)(b[i] - a[i]);
+    }
+    return sum;
+}
+
+// Video thread: copy the luma plane into a free slot and wake the worker.
+// A few hundred rows of memcpy at most, and no locks.
+static void raw_video_callback(void *param, struct video_data *frame)
+{
+    struct video_trigger *trigger = param;
+
+#ifndef VIDEO_TRIGGER_DIVISOR_API
+    if (trigger->received++ % trigger->divisor) {
+        return;
+    }
+#endif
+
+    long head = trigger->head;
+    if (head - os_atomic_load_long(&trigger->tail) >= VIDEO_TRIGGER_POOL_SIZE) {
+        trigger->skipped++;
+        return;
+    }
+
+    uint8_t *slot = trigger->pool[head % VIDEO_TRIGGER_POOL_SIZE];
+    uint32_t width = trigger->scale.width;
+    for (uint32_t y = 0; y < trigger->scale.height; y++) {
+        memcpy(slot + (size_t)y * width, frame->data[0] + (size_t)y * frame->linesize[0], width);
+    }
+    trigger->pool_timestamp[head % VIDEO_TRIGGER_POOL_SIZE] = frame->timestamp;
+
+    // Publishes the slot's contents along with the new head
+    os_atomic_set_long(&trigger->head, head + 1);
+    os_event_signal(trigger->event);
+}
+
+// Worker: compare a frame with the one before and keep it as the next reference
+static void compare_frame(struct video_trigger *trigger, const uint8_t *frame, uint64_t timestamp)
+{
+    uint64_t start_ns = os_gettime_ns();
+
+    if (trigger->has_previous) {
+        uint64_t sad = video_trigger_sad(trigger->previous, frame, trigger->frame_size);
+        float score = (float)sad / (float)trigger->frame_size;
+
+        if (score >= trigger->threshold &&
+            (!trigger->last_marker_ns || timestamp - trigger->last_marker_ns >= trigger->hold_ns)) {
+            trigger->last_marker_ns = timestamp ? timestamp : 1;
+            trigger->markers++;
+            trigger->callback(trigger->param, timestamp, score);
+        }
+    }
+
+    memcpy(trigger->previous, frame, trigger->frame_size);
+    trigger->has_previous = true;
+
+    uint64_t cost_ns = os_gettime_ns() - start_ns;
+    trigger->frames++;
+    trigger->total_ns += cost_ns;
+    trigger->max_ns = cost_ns > trigger->max_ns ? cost_ns : trigger->max_ns;
+    marker_stats_record(MARKER_STAT_VIDEO_FRAME, cost_ns);
+}
+
+static void *video_trigger_thread(void *data)
+{
+    struct video_trigger *trigger = data;
+    os_set_thread_name("timestamp-video-trigger");
+
+    while (os_atomic_load_bool(&trigger->running)) {
+        os_event_wait(trigger->event);
+
+        long tail = trigger->tail;
+        while (tail != os_atomic_load_long(&trigger->head)) {
+            long slot = tail % VIDEO_TRIGGER_POOL_SIZE;
+            compare_frame(trigger, trigger->pool[slot], trigger->pool_timestamp[slot]);
+
+            // Hands the slot back to the video thread
+            os_atomic_set_long(&trigger->tail, ++tail);
+        }
+    }
+    return NULL;
+}
+
+struct video_trigger *video_trigger_create(const struct video_trigger_settings *settings,
+                                           video_trigger_callback callback, void *param)
+{
+    struct obs_video_info ovi;
+    if (!settings->enabled || !obs_get_video_info(&ovi) || !ovi.output_width || !ovi.output_height) {
+        return NULL;
+    }
+
+    uint32_t width = settings->width;
+    if (width < VIDEO_TRIGGER_MIN_WIDTH) {
+        width = VIDEO_TRIGGER_MIN_WIDTH;
+    } else if (width > VIDEO_TRIGGER_MAX_WIDTH) {
+        width = VIDEO_TRIGGER_MAX_WIDTH;
+    }
+    uint32_t height = (uint32_t)util_mul_div64(width, ovi.output_height, ovi.output_width) & ~1u;
+    if (height < 2) {
+        height = 2;
+    }
+
+    // Every divisor-th frame of the output is analyzed
+    uint32_t output_fps = ovi.fps_den ? (ovi.fps_num + ovi.fps_den / 2) / ovi.fps_den : 30;
+    uint32_t fps = settings->fps ? settings->fps : 1;
+    uint32_t divisor = output_fps > fps ? (output_fps + fps / 2) / fps : 1;
+
+    struct video_trigger *trigger = bzalloc(sizeof(*trigger));
+    trigger->scale.format = VIDEO_FORMAT_Y800;
+    trigger->scale.width = width;
+    trigger->scale.height = height;
+    trigger->scale.range = VIDEO_RANGE_FULL;
+    trigger->scale.colorspace = VIDEO_CS_DEFAULT;
+    trigger->divisor = divisor;
+    trigger->frame_size = (size_t)width * height;
+    trigger->threshold = settings->threshold;
+    trigger->hold_ns = (uint64_t)settings->hold_ms * 1000000ULL;
+    trigger->callback = callback;
+    trigger->param = param;
+
+    // One allocation for the pool and the reference frame
+    uint8_t *buffers = bzalloc(trigger->frame_size * (VIDEO_TRIGGER_POOL_SIZE + 1));
+    for (size_t i = 0; i < VIDEO_TRIGGER_POOL_SIZE; i++) {
+        trigger->pool[i] = buffers + i * trigger->frame_size;
+    }
+    trigger->previous = buffers + VIDEO_TRIGGER_POOL_SIZE * trigger->frame_size;
+
+    if (os_event_init(&trigger->event, OS_EVENT_TYPE_AUTO) != 0) {
+        bfree(buffers);
+        bfree(trigger);
+        return NULL;
+    }
+
+    os_atomic_set_bool(&trigger->running, true);
+    if (pthread_create(&trigger->thread, NULL, video_trigger_thread, trigger) != 0) {
+        blog(LOG_ERROR, "Timestamp Plugin: Failed to start the video trigger thread");
+        os_event_destroy(trigger->event);
+        bfree(buffers);
+        bfree(trigger);
+        return NULL;
+    }
+
+#ifdef VIDEO_TRIGGER_DIVISOR_API
+    obs_add_raw_video_callback2(&trigger->scale, divisor, raw_video_callback, trigger);
+#else
+    obs_add_raw_video_callback(&trigger->scale, raw_video_callback, trigger);
+#endif
+
+    blog(LOG_INFO, "Timestamp Plugin: Video trigger at %ux%u, every %u frame(s), threshold %.1f", width, height,
+         divisor, settings->threshold);
+    return trigger;
+}
+
+void video_trigger_destroy(struct video_trigger *trigger)
+{
+    if (!trigger) {
+        return;
+    }
+
+    // Returns once no callback is running
+#ifdef VIDEO_TRIGGER_DIVISOR_API
+    obs_remove_raw_video_callback2(&trigger->scale, trigger->divisor, raw_video_callback, trigger);
+#else
+    obs_remove_raw_video_callback(raw_video_callback, trigger);
+#endif
+
+    os_atomic_set_bool(&trigger->running, false);
+    os_event_signal(trigger->event);
+    pthread_join(trigger->thread, NULL);
+    os_event_destroy(trigger->event);
+
+    blog(LOG_INFO,
+         "Timestamp Plugin: Video trigger: %" PRIu64 " marker(s), %" PRIu64 " frame(s) compared, %" PRIu64
+         " skipped, %.2f us mean, %.2f us max per frame",
+         trigger->markers, trigger->frames, trigger->skipped,
+         trigger->frames ? (double)trigger->total_ns / (double)trigger->frames / 1000.0 : 0.0,
+         (double)trigger->max_ns / 1000.0);
+
+    bfree(trigger->pool[0]);
+    bfree(trigger);
+}
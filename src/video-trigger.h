@@ -0,0 +1,42 @@
+#pragma once
+
+#include <obs-module.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Markers from the picture: whenever consecutive frames differ a lot, as at
+// a cut to a replay. libobs scales the output down to a small luma-only
+// frame for us and skips frames at the source, the video thread only copies
+// it into a preallocated pool slot, and a worker thread compares it with the
+// previous one. Width and frame rate bound the cost: it grows with
+// width x height x fps and nothing else.
+
+struct video_trigger_settings {
+    bool enabled;
+    uint32_t width;    // analysis width in pixels; the height keeps the output's aspect
+    uint32_t fps;      // frames analyzed per second, at most the output's rate
+    float threshold;   // mean absolute luma difference (0-255) that fires a marker
+    uint32_t hold_ms;  // minimum time between two markers
+};
+
+// Called on the worker thread with the video timestamp of the frame that
+// changed (os_gettime_ns() clock) and its difference score
+typedef void (*video_trigger_callback)(void *param, uint64_t timestamp_ns, float score);
+
+struct video_trigger;
+
+// Start the worker and subscribe to the raw video; NULL if there is no video
+struct video_trigger *video_trigger_create(const struct video_trigger_settings *settings,
+                                           video_trigger_callback callback, void *param);
+
+// Unsubscribe, stop the worker, log the per-frame cost and free
+void video_trigger_destroy(struct video_trigger *trigger);
+
+// Sum of absolute differences of two byte arrays
+uint64_t video_trigger_sad(const uint8_t *a, const uint8_t *b, size_t count);
+
+#ifdef __cplusplus
+}
+#endif